@@ -0,0 +1,78 @@
+#include <string>
+#include <sstream>
+#include "NajaLang.h"
+#include "Bench.h"
+
+// many small statements,the width of the tree grows with n
+static std::string GenerateWideSource(size_t n)
+{
+    std::string src;
+    for (size_t i = 0; i < n; ++i)
+    {
+        std::string id = std::to_string(i);
+        src += "var v" + id + " = [" + id + ", \"s" + id + "\", 1.5] ;\n";
+        src += "if (v" + id + " > 3) { f(v" + id + ", -1); } else { while (true) { break; } }\n";
+    }
+    return src;
+}
+
+// one statement nested n levels deep,every level's text contains all the levels below it
+static std::string GenerateDeepSource(size_t n)
+{
+    std::string src;
+    for (size_t i = 0; i < n; ++i)
+        src += "if (a" + std::to_string(i % 10) + ") {";
+    src += "x = 1;";
+    for (size_t i = 0; i < n; ++i)
+        src += "}";
+    return src;
+}
+
+// a stream that drops everything,so only the printing itself is timed
+class NullBuffer : public std::streambuf
+{
+protected:
+    std::streamsize xsputn(const char *, std::streamsize count) override { return count; }
+    int overflow(int c) override { return c; }
+};
+
+static void BenchPrint(std::string_view name, const std::string &src)
+{
+    NajaLang::Lexer lexer;
+    NajaLang::TokenBuffer tokens;
+    lexer.ScanTokens(src, tokens);
+    NajaLang::Parser parser;
+    NajaLang::Stmt *stmts = parser.Parse(tokens);
+
+    uint64_t textSize = stmts->Stringify().size();
+    double printTime = Measure([&]()
+                               { DoNotOptimize(stmts->Stringify().size()); });
+    Report(std::string(name) + " (AstPrinter)", printTime, textSize);
+
+    NullBuffer nullBuffer;
+    std::ostream nullStream(&nullBuffer);
+    double streamTime = Measure([&]()
+                                { NajaLang::AstPrinter printer(nullStream); printer.Print(stmts); });
+    Report(std::string(name) + " (AstPrinter,streamed)", streamTime, textSize);
+
+    //FlatAst::Stringify concatenates the text of every subtree the way the nodes' Stringify used to
+    NajaLang::FlatAst ast;
+    ast.Build(stmts);
+    double concatTime = Measure([&]()
+                                { DoNotOptimize(ast.Stringify().size()); },
+                                1);
+    Report(std::string(name) + " (concatenation)", concatTime, textSize);
+}
+
+int main(int argc, char **argv)
+{
+    size_t wideCount = argc > 1 ? std::stoull(argv[1]) : 25000;
+    size_t deepCount = argc > 2 ? std::stoull(argv[2]) : 500;
+
+    //the time per MB of the printer should stay flat as n doubles
+    for (size_t n = wideCount; n <= wideCount * 8; n *= 2)
+        BenchPrint("Print wide n=" + std::to_string(n), GenerateWideSource(n));
+    for (size_t n = deepCount; n <= deepCount * 8; n *= 2)
+        BenchPrint("Print deep n=" + std::to_string(n), GenerateDeepSource(n));
+    return 0;
+}
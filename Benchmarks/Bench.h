@@ -0,0 +1,44 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <iostream>
+#include <iomanip>
+
+// best wall clock time of 'repeat' runs,in seconds
+template <typename Fn>
+inline double Measure(Fn &&fn, int repeat = 5)
+{
+    double best = 1e30;
+    for (int i = 0; i < repeat; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() < best)
+            best = elapsed.count();
+    }
+    return best;
+}
+
+inline void Report(std::string_view name, double seconds, uint64_t bytes)
+{
+    std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds * 1000.0 << " ms"
+              << std::setw(10) << (bytes / seconds) / (1024.0 * 1024.0) << " MB/s" << std::endl;
+}
+
+// keeps the optimizer from dropping a result
+#if defined(__GNUC__)
+inline void DoNotOptimize(uint64_t value)
+{
+    asm volatile("" : : "r"(value) : "memory");
+}
+#else
+inline volatile uint64_t gSink;
+
+inline void DoNotOptimize(uint64_t value)
+{
+    gSink = value;
+}
+#endif
@@ -0,0 +1,61 @@
+#include <string>
+#include <random>
+#include "NajaLang.h"
+#include "Bench.h"
+
+static std::string GenerateSource(size_t statementCount)
+{
+    std::string src;
+    for (size_t i = 0; i < statementCount; ++i)
+    {
+        std::string id = std::to_string(i);
+        src += "var v" + id + " = [" + id + ", \"s" + id + "\", 1.5] ; // line " + id + "\n";
+    }
+    return src;
+}
+
+// the cost of an edit should follow the text it changes,not the size of the file
+static void BenchEdits(size_t statementCount)
+{
+    std::string src = GenerateSource(statementCount);
+    const size_t editCount = 2000;
+
+    NajaLang::IncrementalLexer lexer;
+    lexer.SetSource(src);
+
+    //typing and deleting a word in the middle of the file
+    uint64_t cursor = src.size() / 2;
+    double typingTime = Measure([&]()
+                                {
+        for (size_t i = 0; i < editCount; ++i)
+        {
+            if (i % 2 == 0)
+                DoNotOptimize(lexer.ApplyEdit({cursor, 0, "abc "}).insertedCount);
+            else
+                DoNotOptimize(lexer.ApplyEdit({cursor, 4, ""}).removedCount);
+        } });
+
+    //the same edits at random places,each one moves the gap
+    std::mt19937 rng(42);
+    double jumpingTime = Measure([&]()
+                                 {
+        for (size_t i = 0; i < editCount; i += 2)
+        {
+            uint64_t pos = rng() % src.size();
+            DoNotOptimize(lexer.ApplyEdit({pos, 0, " x "}).insertedCount);
+            DoNotOptimize(lexer.ApplyEdit({pos, 3, ""}).removedCount);
+        } });
+
+    std::cout << std::left << std::setw(12) << src.size() / 1024 << " KB"
+              << std::right << std::fixed << std::setprecision(3)
+              << std::setw(12) << typingTime / editCount * 1e6 << " us/edit typing"
+              << std::setw(12) << jumpingTime / editCount * 1e6 << " us/edit jumping" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    size_t maxStatements = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    for (size_t statementCount = 1000; statementCount <= maxStatements; statementCount *= 10)
+        BenchEdits(statementCount);
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include <string>
+#include <vector>
+#include <random>
+#include <unordered_map>
+#include "NajaLang.h"
+#include "SimdScan.h"
+#include "Bench.h"
+
+// the keyword table Lexer::Identifier used before GetKeywordType,kept as the baseline
+static std::unordered_map<std::string, NajaLang::TokenType> keywords =
+    {
+        {"var", NajaLang::TOKEN_VAR},
+        {"if", NajaLang::TOKEN_IF},
+        {"else", NajaLang::TOKEN_ELSE},
+        {"true", NajaLang::TOKEN_TRUE},
+        {"false", NajaLang::TOKEN_FALSE},
+        {"null", NajaLang::TOKEN_NULL},
+        {"while", NajaLang::TOKEN_WHILE},
+        {"for", NajaLang::TOKEN_FOR},
+        {"break", NajaLang::TOKEN_BREAK},
+        {"continue", NajaLang::TOKEN_CONTINUE},
+        {"function", NajaLang::TOKEN_FUNCTION},
+        {"class", NajaLang::TOKEN_CLASS},
+        {"public", NajaLang::TOKEN_PUBLIC},
+        {"protected", NajaLang::TOKEN_PROTECTED},
+        {"private", NajaLang::TOKEN_PRIVATE},
+        {"this", NajaLang::TOKEN_THIS},
+        {"base", NajaLang::TOKEN_BASE},
+        {"new", NajaLang::TOKEN_NEW},
+        {"return", NajaLang::TOKEN_RETURN},
+};
+
+static std::string GenerateIdentifierDenseSource(size_t identifierCount)
+{
+    static const char *words[] = {"var", "if", "else", "function", "return", "this", "class", "while",
+                                  "value", "index", "count", "result", "fn", "x", "y", "position", "velocity", "_tmp"};
+    std::mt19937 rng(42);
+    std::string src;
+    for (size_t i = 0; i < identifierCount; ++i)
+    {
+        src += words[rng() % (sizeof(words) / sizeof(words[0]))];
+        if (rng() % 3 == 0)
+            src += std::to_string(rng() % 100);
+        src += (i % 12 == 11) ? ";\n" : " ";
+    }
+    return src;
+}
+
+static std::string GenerateCommentHeavySource(size_t lineCount)
+{
+    std::string src;
+    for (size_t i = 0; i < lineCount; ++i)
+    {
+        src += "/* generated rule block " + std::to_string(i) + ",see the template for details\n   nothing here is code */\n";
+        src += "var message" + std::to_string(i) + " = \"a fairly long string literal produced by the templating layer\"; // trailing note\n";
+    }
+    return src;
+}
+
+static void BenchLexer(std::string_view name, std::string_view src)
+{
+    static const char *levelNames[] = {"scalar", "sse2", "avx2"};
+    NajaLang::Lexer lexer;
+    for (int level = NajaLang::SIMD_SCALAR; level <= NajaLang::GetSupportedSimdLevel(); ++level)
+    {
+        NajaLang::SetSimdLevel((NajaLang::SimdLevel)level);
+        double lexTime = Measure([&]()
+                                 { DoNotOptimize(lexer.ScanTokens(src).size()); });
+        Report(std::string(name) + " (" + levelNames[level] + ")", lexTime, src.size());
+    }
+    NajaLang::SetSimdLevel(NajaLang::GetSupportedSimdLevel());
+}
+
+int main(int argc, char **argv)
+{
+    size_t identifierCount = argc > 1 ? std::stoull(argv[1]) : 2000000;
+    std::string src = GenerateIdentifierDenseSource(identifierCount);
+
+    NajaLang::Lexer lexer;
+    std::vector<std::string_view> names;
+    for (const auto &token : lexer.ScanTokens(src))
+        if (token.type == NajaLang::TOKEN_IDENTIFIER || NajaLang::GetKeywordType(token.literal) != NajaLang::TOKEN_IDENTIFIER)
+            names.emplace_back(token.literal);
+
+    std::cout << names.size() << " names in " << src.size() << " bytes of source" << std::endl;
+
+    double mapTime = Measure([&]()
+                             {
+        uint64_t sum = 0;
+        for (auto name : names)
+        {
+            auto iter = keywords.find(std::string(name));
+            sum += iter == keywords.end() ? NajaLang::TOKEN_IDENTIFIER : iter->second;
+        }
+        DoNotOptimize(sum); });
+    Report("keywords: unordered_map<std::string>", mapTime, src.size());
+
+    double switchTime = Measure([&]()
+                                {
+        uint64_t sum = 0;
+        for (auto name : names)
+            sum += NajaLang::GetKeywordType(name);
+        DoNotOptimize(sum); });
+    Report("keywords: GetKeywordType", switchTime, src.size());
+
+    BenchLexer("lex identifier dense", src);
+    BenchLexer("lex comment heavy", GenerateCommentHeavySource(identifierCount / 8));
+    return 0;
+}
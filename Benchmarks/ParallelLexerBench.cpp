@@ -0,0 +1,45 @@
+#include <string>
+#include <thread>
+#include <algorithm>
+#include "NajaLang.h"
+#include "Bench.h"
+
+static std::string GenerateRuleFile(size_t ruleCount)
+{
+    std::string src;
+    for (size_t i = 0; i < ruleCount; ++i)
+    {
+        std::string id = std::to_string(i);
+        src += "/* rule " + id + "\n   generated */\n";
+        src += "function rule" + id + "(input, limit)\n{\n";
+        src += "    var score = input * 3 + " + id + ", label = \"rule " + id + " matched\";\n";
+        src += "    if (score >= limit) { return label; } // threshold\n";
+        src += "    return null;\n}\n";
+    }
+    return src;
+}
+
+int main(int argc, char **argv)
+{
+    size_t ruleCount = argc > 1 ? std::stoull(argv[1]) : 400000;
+    uint32_t maxThreads = argc > 2 ? std::stoul(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+    std::string src = GenerateRuleFile(ruleCount);
+    std::cout << src.size() / (1024 * 1024) << " MB of source" << std::endl;
+
+    NajaLang::Lexer lexer;
+    double serialTime = Measure([&]()
+                                { DoNotOptimize(lexer.ScanTokens(src).size()); });
+    Report("ScanTokens", serialTime, src.size());
+
+    for (uint32_t threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        NajaLang::ThreadPool pool(threads);
+        double time = Measure([&]()
+                              { DoNotOptimize(lexer.ScanTokensParallel(src, pool).size()); });
+        Report("ScanTokensParallel x" + std::to_string(threads), time, src.size());
+        std::cout << "    speedup over serial: " << serialTime / time << std::endl;
+        if (threads * 2 > maxThreads && threads != maxThreads)
+            threads = maxThreads / 2;
+    }
+    return 0;
+}
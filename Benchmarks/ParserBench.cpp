@@ -0,0 +1,99 @@
+#include <string>
+#include "NajaLang.h"
+#include "Bench.h"
+
+static std::string GenerateRuleFile(size_t ruleCount)
+{
+    std::string src;
+    for (size_t i = 0; i < ruleCount; ++i)
+    {
+        std::string id = std::to_string(i);
+        src += "function rule" + id + "(input, limit)\n{\n";
+        src += "    var score = input * 3 + " + id + ", label = \"rule " + id + " matched\";\n";
+        src += "    if (score >= limit && !(input < 0)) { return label; } else { score = -score; }\n";
+        src += "    while (score > 0) { score -= [1, 2, 3][input % 3]; }\n";
+        src += "    return null;\n}\n";
+    }
+    return src;
+}
+
+static std::string GenerateExpressionHeavySource(size_t lineCount)
+{
+    std::string src;
+    for (size_t i = 0; i < lineCount; ++i)
+    {
+        std::string id = std::to_string(i % 1000);
+        src += "r" + id + " = (a * " + id + " + b << 2) - c / (d + 1) % 7 == e && f >= g || !h & ~i | j ^ k;\n";
+        src += "s" + id + " += m ? n.x + o(p, q * " + id + ") : -t++ * (u - v) / w;\n";
+    }
+    return src;
+}
+
+static void BenchParse(std::string_view name, std::string_view src)
+{
+    NajaLang::Lexer lexer;
+    NajaLang::TokenBuffer tokens;
+    lexer.ScanTokens(src, tokens);
+
+    NajaLang::Parser parser;
+    double parseTime = Measure([&]()
+                               { DoNotOptimize((uint64_t)parser.Parse(tokens)); });
+    Report(name, parseTime, src.size());
+    std::cout << "    ast bytes: " << parser.GetArena().GetUsedBytes() << " in " << parser.GetArena().GetBlockCount() << " blocks" << std::endl;
+
+    NajaLang::FlatAst ast;
+    double flatTime = Measure([&]()
+                              { parser.ParseFlat(tokens, ast); DoNotOptimize(ast.GetNodeCount()); });
+    Report(std::string(name) + " (flat)", flatTime, src.size());
+    std::cout << "    flat ast bytes: " << ast.GetUsedBytes() << " in " << ast.GetNodeCount() << " nodes" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    size_t ruleCount = argc > 1 ? std::stoull(argv[1]) : 100000;
+    std::string src = GenerateRuleFile(ruleCount);
+    std::cout << src.size() / (1024 * 1024) << " MB of source" << std::endl;
+    BenchParse("Parse rule file", src);
+
+    {
+        //time to the first usable tree when no function body is needed yet
+        NajaLang::Lexer lexer;
+        NajaLang::TokenBuffer tokens;
+        lexer.ScanTokens(src, tokens);
+        NajaLang::Parser parser;
+        parser.SetLazyBodies(true);
+        double lazyTime = Measure([&]()
+                                  { DoNotOptimize((uint64_t)parser.Parse(tokens)); });
+        Report("Parse rule file (lazy bodies)", lazyTime, src.size());
+        std::cout << "    ast bytes: " << parser.GetArena().GetUsedBytes() << std::endl;
+
+        NajaLang::ThreadPool pool;
+        NajaLang::Parser parallelParser;
+        double parallelTime = Measure([&]()
+                                      { DoNotOptimize((uint64_t)parallelParser.ParseParallel(tokens, pool)); });
+        Report("Parse rule file (" + std::to_string(pool.GetThreadCount()) + " threads)", parallelTime, src.size());
+    }
+
+    std::string exprSrc = GenerateExpressionHeavySource(ruleCount * 2);
+    std::cout << exprSrc.size() / (1024 * 1024) << " MB of expressions" << std::endl;
+    BenchParse("Parse expression heavy", exprSrc);
+
+    NajaLang::Lexer lexer;
+    NajaLang::TokenBuffer tokens;
+    NajaLang::Parser parser;
+
+    //a REPL session:one short line after another on the same parser,the arena must not grow
+    std::string line = "var total = count * 2 + offset, name = \"entry\"; total += [1, 2, 3][0];";
+    const uint64_t lineCount = 1000000;
+    double replTime = Measure([&]()
+                              {
+        for (uint64_t i = 0; i < lineCount; ++i)
+        {
+            lexer.ScanTokens(line, tokens);
+            DoNotOptimize((uint64_t)parser.Parse(tokens));
+        } },
+                              1);
+    Report("REPL lines", replTime, line.size() * lineCount);
+    std::cout << "    arena blocks after " << lineCount << " lines: " << parser.GetArena().GetBlockCount() << std::endl;
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <string>
+#include "NajaLang.h"
+#include "Bench.h"
+
+// straight line code whose instructions allocate nothing,so the time is spent in dispatch and the handlers
+static std::string GenerateDispatchSource(size_t lineCount)
+{
+    std::string src = "var a = 1, b = 2, c = true;\n";
+    for (size_t i = 0; i < lineCount; ++i)
+    {
+        src += "a < b;\n";   // GET_GLOBAL_OP,GET_GLOBAL_OP,LESS_OP,POP_OP
+        src += "c = !c;\n";  // GET_GLOBAL_OP,NOT_OP,SET_GLOBAL_OP,POP_OP
+        src += "a == b;\n";  // GET_GLOBAL_OP,GET_GLOBAL_OP,EQUAL_OP,POP_OP
+    }
+    return src;
+}
+
+// integer arithmetic on small ints
+static std::string GenerateArithmeticSource(size_t lineCount)
+{
+    std::string src = "var a = 7, b = 3;\n";
+    for (size_t i = 0; i < lineCount; ++i)
+        src += "a * b + a % b - (a << 2);\n";
+    return src;
+}
+
+// stores of the literals scripts are full of
+static std::string GenerateLiteralSource(size_t lineCount)
+{
+    std::string src = "var x = null;\n";
+    for (size_t i = 0; i < lineCount; ++i)
+        src += "x = 0; x = 1; x = 42; x = 1000; x = true; x = null;\n";
+    return src;
+}
+
+static constexpr std::string_view GetDispatchName(NajaLang::VMDispatch dispatch)
+{
+    switch (dispatch)
+    {
+    case NajaLang::VM_DISPATCH_SWITCH:
+        return "switch";
+    case NajaLang::VM_DISPATCH_GOTO:
+        return "computed goto";
+    default:
+        return "tail call";
+    }
+}
+
+static void BenchDispatch(std::string_view name, std::string_view src)
+{
+    NajaLang::Lexer lexer;
+    NajaLang::TokenBuffer tokens;
+    lexer.ScanTokens(src, tokens);
+    NajaLang::Parser parser;
+    NajaLang::Compiler compiler;
+    const NajaLang::Chunk &chunk = compiler.Compile(parser.Parse(tokens));
+    if (parser.HasError() || compiler.HasError())
+    {
+        std::cout << name << ": does not compile" << std::endl;
+        if (parser.HasError())
+            parser.PrintErrors();
+        if (compiler.HasError())
+            compiler.PrintErrors();
+        return;
+    }
+
+    //count what runs,not the code size:operands are skipped
+    uint64_t instructionCount = 0;
+    const auto &codes = chunk.GetCodes();
+    for (const uint8_t *ip = codes.data(); ip < codes.data() + codes.size(); ++instructionCount)
+    {
+        uint8_t code = *ip++;
+        if (code <= NajaLang::STR_OP || code == NajaLang::PUSH_SMALL_INT_OP)
+            ip += 1;
+        else if (code == NajaLang::PUSH_SMALL_INT_16_OP)
+            ip += 2;
+        else if (code >= NajaLang::DEFINE_GLOBAL_OP && code <= NajaLang::SET_GLOBAL_OP)
+            ip += 4;
+        else if (code >= NajaLang::FLOAT_NUM_LONG_OP)
+            NajaLang::ReadLeb128(ip);
+    }
+    std::cout << name << ": " << instructionCount << " instructions" << std::endl;
+
+    for (auto dispatch : {NajaLang::VM_DISPATCH_SWITCH, NajaLang::VM_DISPATCH_GOTO, NajaLang::VM_DISPATCH_TAIL_CALL})
+    {
+        std::string label = "    " + std::string(GetDispatchName(dispatch));
+        if (!NajaLang::VM::IsDispatchSupported(dispatch))
+        {
+            std::cout << label << ": not supported by this build" << std::endl;
+            continue;
+        }
+
+        NajaLang::VM vm;
+        double time = Measure([&]()
+                              {
+            vm.Reset();
+            if (vm.Run(chunk, dispatch) != NajaLang::INTERPRET_OK)
+                std::cout << vm.GetError() << std::endl;
+            DoNotOptimize(vm.GetResult().GetBits()); });
+        Report(label, time, codes.size());
+        std::cout << "        " << std::fixed << std::setprecision(2) << time * 1e9 / instructionCount << " ns/instruction" << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t lineCount = argc > 1 ? std::stoull(argv[1]) : 100000;
+    std::cout << "default dispatch: " << GetDispatchName(NajaLang::VM::GetDefaultDispatch()) << std::endl;
+    BenchDispatch("Dispatch", GenerateDispatchSource(lineCount));
+    BenchDispatch("Integer arithmetic", GenerateArithmeticSource(lineCount));
+    BenchDispatch("Literals", GenerateLiteralSource(lineCount));
+    return 0;
+}
@@ -1,9 +1,10 @@
 #pragma once
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <map>
-#include <unordered_map>
 #include <vector>
-#include <memory>
+#include <memory_resource>
 namespace NajaLang
 {
 	enum AstType
@@ -43,255 +44,286 @@ namespace NajaLang
 		AST_STMTS,
 	};
 
+	// operators of PrefixExpr,InfixExpr and PostfixExpr,mapped from the TokenType by the parser.
+	// Prefix and postfix '++'/'--' share OPERATOR_INCREMENT/OPERATOR_DECREMENT,the node type tells them apart
+	enum Operator : uint8_t
+	{
+		OPERATOR_ASSIGN,		 // =
+		OPERATOR_ADD_ASSIGN,	 // +=
+		OPERATOR_SUB_ASSIGN,	 // -=
+		OPERATOR_MUL_ASSIGN,	 // *=
+		OPERATOR_DIV_ASSIGN,	 // /=
+		OPERATOR_MOD_ASSIGN,	 // %=
+		OPERATOR_BIT_AND_ASSIGN, // &=
+		OPERATOR_BIT_OR_ASSIGN,	 // |=
+		OPERATOR_BIT_XOR_ASSIGN, // ^=
+		OPERATOR_SHL_ASSIGN,	 // <<=
+		OPERATOR_SHR_ASSIGN,	 // >>=
+
+		OPERATOR_LOGIC_OR,		// ||
+		OPERATOR_LOGIC_AND,		// &&
+		OPERATOR_BIT_OR,		// |
+		OPERATOR_BIT_XOR,		// ^
+		OPERATOR_BIT_AND,		// &
+		OPERATOR_EQUAL,			// ==
+		OPERATOR_NOT_EQUAL,		// !=
+		OPERATOR_LESS,			// <
+		OPERATOR_LESS_EQUAL,	// <=
+		OPERATOR_GREATER,		// >
+		OPERATOR_GREATER_EQUAL, // >=
+		OPERATOR_SHL,			// <<
+		OPERATOR_SHR,			// >>
+		OPERATOR_ADD,			// +
+		OPERATOR_SUB,			// -
+		OPERATOR_MUL,			// *
+		OPERATOR_DIV,			// /
+		OPERATOR_MOD,			// %
+
+		OPERATOR_NEGATE,	// -
+		OPERATOR_NOT,		// !
+		OPERATOR_BIT_NOT,	// ~
+		OPERATOR_ADDRESS,	// &
+		OPERATOR_INCREMENT, // ++
+		OPERATOR_DECREMENT, // --
+
+		OPERATOR_UNDEFINED,
+	};
+
+	constexpr uint32_t OPERATOR_COUNT = OPERATOR_UNDEFINED + 1;
+
+	constexpr std::string_view GetOperatorLiteral(Operator op)
+	{
+		constexpr std::string_view literals[OPERATOR_COUNT] = {
+			"=", "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", "<<=", ">>=",
+			"||", "&&", "|", "^", "&", "==", "!=", "<", "<=", ">", ">=", "<<", ">>", "+", "-", "*", "/", "%",
+			"-", "!", "~", "&", "++", "--",
+			""};
+		return literals[op];
+	}
+
+	struct Expr;
+	struct Stmt;
+	// the text of a subtree,printed by an AstPrinter in one pass
+	std::string StringifyAst(Expr *expr);
+	std::string StringifyAst(Stmt *stmt);
+
+	// nodes are built in the parser's AstArena and are never destroyed one by one,so they own nothing:containers are
+	// std::pmr ones taking their memory from the arena and strings are views into the arena or the SymbolTable
 	struct AstNode
 	{
 		AstNode() {}
 		virtual ~AstNode() {}
 
 		virtual std::string Stringify() = 0;
-		virtual AstType Type() = 0;
 	};
 
+	// every node stores its AstType,so passes switch on it without a virtual call.Each node type has it as
+	// T::TYPE as well,which AstCast checks against
 	struct Expr
 	{
-		Expr() {}
+		Expr(AstType type) : type(type) {}
 		virtual ~Expr() {}
 
 		virtual std::string Stringify() = 0;
-		virtual AstType Type() = 0;
+		AstType Type() const { return type; }
+
+		const AstType type;
 	};
 
 	struct FloatNumExpr : public Expr
 	{
-		FloatNumExpr() : value(0.0) {}
-		FloatNumExpr(double value) : value(value) {}
+		static constexpr AstType TYPE = AstType::FLOAT_NUM_EXPR;
+
+		FloatNumExpr() : Expr(TYPE), value(0.0) {}
+		FloatNumExpr(double value) : Expr(TYPE), value(value) {}
 		~FloatNumExpr() {}
 
 		std::string Stringify() override { return std::to_string(value); }
-		AstType Type() override { return AstType::FLOAT_NUM_EXPR; }
 
 		double value;
 	};
 
 	struct IntNumExpr : public Expr
 	{
-		IntNumExpr() : value(0) {}
-		IntNumExpr(int64_t value) : value(value) {}
+		static constexpr AstType TYPE = AstType::INT_NUM_EXPR;
+
+		IntNumExpr() : Expr(TYPE), value(0) {}
+		IntNumExpr(int64_t value) : Expr(TYPE), value(value) {}
 		~IntNumExpr() {}
 
 		std::string Stringify() override { return std::to_string(value); }
-		AstType Type() override { return AstType::INT_NUM_EXPR; }
 
 		int64_t value;
 	};
 
 	struct StrExpr : public Expr
 	{
-		StrExpr() {}
-		StrExpr(std::string_view str) : value(str) {}
+		static constexpr AstType TYPE = AstType::STR_EXPR;
 
-		std::string Stringify() override { return value; }
-		AstType Type() override { return AstType::STR_EXPR; }
+		StrExpr() : Expr(TYPE) {}
+		StrExpr(std::string_view str) : Expr(TYPE), value(str) {}
 
-		std::string value;
+		std::string Stringify() override { return std::string(value); }
+
+		std::string_view value;
 	};
 
 	struct NullExpr : public Expr
 	{
-		NullExpr() {}
+		static constexpr AstType TYPE = AstType::NULL_EXPR;
+
+		NullExpr() : Expr(TYPE) {}
 		~NullExpr() {}
 
 		std::string Stringify() override { return "null"; }
-		AstType Type() override { return AstType::NULL_EXPR; }
 	};
 
 	struct TrueExpr : public Expr
 	{
-		TrueExpr() {}
+		static constexpr AstType TYPE = AstType::TRUE_EXPR;
+
+		TrueExpr() : Expr(TYPE) {}
 		~TrueExpr() {}
 
 		std::string Stringify() override { return "true"; }
-		AstType Type() override { return AstType::TRUE_EXPR; }
 	};
 
 	struct FalseExpr : public Expr
 	{
-		FalseExpr() {}
+		static constexpr AstType TYPE = AstType::FALSE_EXPR;
+
+		FalseExpr() : Expr(TYPE) {}
 		~FalseExpr() {}
 
 		std::string Stringify() override { return "false"; }
-		AstType Type() override { return AstType::FALSE_EXPR; }
 	};
 
 	struct IdentifierExpr : public Expr
 	{
-		IdentifierExpr() {}
-		IdentifierExpr(std::string_view literal) : literal(literal) {}
+		static constexpr AstType TYPE = AstType::IDENTIFIER_EXPR;
+
+		IdentifierExpr() : Expr(TYPE), symbol(0) {}
+		IdentifierExpr(std::string_view literal, uint32_t symbol) : Expr(TYPE), literal(literal), symbol(symbol) {}
 		~IdentifierExpr() {}
 
-		std::string Stringify() override { return literal; }
-		AstType Type() override { return AstType::IDENTIFIER_EXPR; }
+		std::string Stringify() override { return std::string(literal); }
 
-		std::string literal;
+		std::string_view literal; // name in the SymbolTable,lives as long as the table
+		uint32_t symbol;
 	};
 
 	struct ThisExpr : public Expr
 	{
-		ThisExpr() {}
+		static constexpr AstType TYPE = AstType::THIS_EXPR;
+
+		ThisExpr() : Expr(TYPE) {}
 		~ThisExpr() {}
 
 		std::string Stringify() override { return "this"; }
-		AstType Type() override { return AstType::THIS_EXPR; }
 	};
 
 	struct BaseExpr : public Expr
 	{
-		BaseExpr() {}
+		static constexpr AstType TYPE = AstType::BASE_EXPR;
+
+		BaseExpr() : Expr(TYPE) {}
 		~BaseExpr() {}
 
 		std::string Stringify() override { return "base"; }
-		AstType Type() override { return AstType::BASE_EXPR; }
 	};
 
 	struct ArrayExpr : public Expr
 	{
-		ArrayExpr() {}
-		ArrayExpr(std::vector<Expr *> elements) : elements(elements) {}
-		~ArrayExpr()
-		{
-			std::vector<Expr *>().swap(elements);
-		}
+		static constexpr AstType TYPE = AstType::ARRAY_EXPR;
 
-		std::string Stringify() override
-		{
-			std::string result = "[";
-
-			if (!elements.empty())
-			{
-				for (auto e : elements)
-					result += e->Stringify() + ",";
-				result = result.substr(0, result.size() - 1);
-			}
-			result += "]";
-			return result;
-		}
-		AstType Type() override { return AstType::ARRAY_EXPR; }
+		ArrayExpr(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) : Expr(TYPE), elements(resource) {}
+		~ArrayExpr() {}
+
+		std::string Stringify() override { return StringifyAst(this); }
 
-		std::vector<Expr *> elements;
+		std::pmr::vector<Expr *> elements;
 	};
 
 	struct TableExpr : public Expr
 	{
-		TableExpr() {}
-		TableExpr(std::map<Expr *, Expr *> elements) : elements(elements) {}
-		~TableExpr() { std::map<Expr *, Expr *>().swap(elements); }
+		static constexpr AstType TYPE = AstType::TABLE_EXPR;
 
-		std::string Stringify() override
-		{
-			std::string result = "{";
-
-			if (!elements.empty())
-			{
-				for (auto [key,value] : elements)
-					result += key->Stringify() + ":" + value->Stringify() + ",";
-				result = result.substr(0, result.size() - 1);
-			}
-			result += "}";
-			return result;
-		}
-		AstType Type() override { return AstType::TABLE_EXPR; }
+		TableExpr(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) : Expr(TYPE), elements(resource) {}
+		~TableExpr() {}
+
+		std::string Stringify() override { return StringifyAst(this); }
 
-		std::map<Expr *, Expr *> elements;
+		std::pmr::map<Expr *, Expr *> elements;
 	};
 
 	struct GroupExpr : public Expr
 	{
-		GroupExpr() {}
-		GroupExpr(Expr *expr) : expr(expr) {}
+		static constexpr AstType TYPE = AstType::GROUP_EXPR;
+
+		GroupExpr() : Expr(TYPE) {}
+		GroupExpr(Expr *expr) : Expr(TYPE), expr(expr) {}
 		~GroupExpr() {}
 
-		std::string Stringify() override { return "(" + expr->Stringify() + ")"; }
-		AstType Type() override { return AstType::GROUP_EXPR; }
+		std::string Stringify() override { return StringifyAst(this); }
 
 		Expr *expr;
 	};
 
 	struct PrefixExpr : public Expr
 	{
-		PrefixExpr() : right(nullptr) {}
-		PrefixExpr(std::string_view op, Expr *right) : op(op), right(right) {}
-		~PrefixExpr()
-		{
-			delete right;
-			right = nullptr;
-		}
+		static constexpr AstType TYPE = AstType::PREFIX_EXPR;
 
-		std::string Stringify() override { return op + right->Stringify(); }
-		AstType Type() override { return AstType::PREFIX_EXPR; }
+		PrefixExpr() : Expr(TYPE), op(OPERATOR_UNDEFINED), right(nullptr) {}
+		PrefixExpr(Operator op, Expr *right) : Expr(TYPE), op(op), right(right) {}
+		~PrefixExpr() {}
 
-		std::string op;
+		std::string Stringify() override { return StringifyAst(this); }
+
+		Operator op;
 		Expr *right;
 	};
 
 	struct InfixExpr : public Expr
 	{
-		InfixExpr() : left(nullptr), right(nullptr) {}
-		InfixExpr(std::string_view op, Expr *left, Expr *right) : op(op), left(left), right(right) {}
-		~InfixExpr()
-		{
-			delete left;
-			left = nullptr;
+		static constexpr AstType TYPE = AstType::INFIX_EXPR;
 
-			delete right;
-			right = nullptr;
-		}
+		InfixExpr() : Expr(TYPE), op(OPERATOR_UNDEFINED), left(nullptr), right(nullptr) {}
+		InfixExpr(Operator op, Expr *left, Expr *right) : Expr(TYPE), op(op), left(left), right(right) {}
+		~InfixExpr() {}
 
-		std::string Stringify() override { return left->Stringify() + op + right->Stringify(); }
-		AstType Type() override { return AstType::INFIX_EXPR; }
+		std::string Stringify() override { return StringifyAst(this); }
 
-		std::string op;
+		Operator op;
 		Expr *left;
 		Expr *right;
 	};
 
 	struct PostfixExpr : public Expr
 	{
-		PostfixExpr() : left(nullptr) {}
-		PostfixExpr(Expr *left, std::string_view op) : op(op), left(left) {}
-		~PostfixExpr()
-		{
-			delete left;
-			left = nullptr;
-		}
+		static constexpr AstType TYPE = AstType::POSTFIX_EXPR;
+
+		PostfixExpr() : Expr(TYPE), left(nullptr), op(OPERATOR_UNDEFINED) {}
+		PostfixExpr(Expr *left, Operator op) : Expr(TYPE), left(left), op(op) {}
+		~PostfixExpr() {}
 
-		std::string Stringify() override { return left->Stringify() + op; }
-		AstType Type() override { return AstType::POSTFIX_EXPR; }
+		std::string Stringify() override { return StringifyAst(this); }
 
 		Expr *left;
-		std::string op;
+		Operator op;
 	};
 
 	struct TernaryExpr : public Expr
 	{
-		TernaryExpr() : condition(nullptr), trueBranch(nullptr), falseBranch(nullptr) {}
-		TernaryExpr(std::string_view firstOp, std::string_view secondOp, Expr *condition, Expr *trueBranch, Expr *falseBranch) : firstOp(firstOp), secondOp(secondOp), condition(condition), trueBranch(trueBranch), falseBranch(falseBranch)
+		static constexpr AstType TYPE = AstType::TERNARY_EXPR;
+
+		TernaryExpr() : Expr(TYPE), condition(nullptr), trueBranch(nullptr), falseBranch(nullptr) {}
+		TernaryExpr(Expr *condition, Expr *trueBranch, Expr *falseBranch) : Expr(TYPE), condition(condition), trueBranch(trueBranch), falseBranch(falseBranch)
 		{
 		}
-		~TernaryExpr()
-		{
-			delete condition;
-			condition = nullptr;
-			delete trueBranch;
-			trueBranch = nullptr;
-			delete falseBranch;
-			falseBranch = nullptr;
-		};
-
-		std::string Stringify() override { return condition->Stringify() + firstOp + trueBranch->Stringify() + secondOp + falseBranch->Stringify(); }
-		AstType Type() override { return AstType::TERNARY_EXPR; }
-
-		std::string firstOp;
-		std::string secondOp;
+		~TernaryExpr() {}
+
+		std::string Stringify() override { return StringifyAst(this); }
+
 		Expr *condition;
 		Expr *trueBranch;
 		Expr *falseBranch;
@@ -299,18 +331,13 @@ namespace NajaLang
 
 	struct IndexExpr : public Expr
 	{
-		IndexExpr() {}
-		IndexExpr(Expr *array, Expr *index) : array(array), index(index) {}
-		~IndexExpr()
-		{
-			delete array;
-			array = nullptr;
-			delete index;
-			index = nullptr;
-		}
-		std::string Stringify() override { return array->Stringify() + "[" + index->Stringify() + "]"; }
+		static constexpr AstType TYPE = AstType::INDEX_EXPR;
+
+		IndexExpr() : Expr(TYPE) {}
+		IndexExpr(Expr *array, Expr *index) : Expr(TYPE), array(array), index(index) {}
+		~IndexExpr() {}
+		std::string Stringify() override { return StringifyAst(this); }
 
-		AstType Type() override { return AstType::INDEX_EXPR; }
 
 		Expr *array;
 		Expr *index;
@@ -318,47 +345,26 @@ namespace NajaLang
 
 	struct FunctionCallExpr : public Expr
 	{
-		FunctionCallExpr() {}
-		FunctionCallExpr(Expr *function, std::vector<Expr *> arguments) : function(function), arguments(arguments) {}
+		static constexpr AstType TYPE = AstType::FUNCTION_CALL_EXPR;
+
+		FunctionCallExpr(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) : Expr(TYPE), function(nullptr), arguments(resource) {}
 		~FunctionCallExpr() {}
 
-		std::string Stringify() override
-		{
-			std::string result = function->Stringify() + "(";
-
-			if (!arguments.empty())
-			{
-				for (const auto &arg : arguments)
-					result += arg->Stringify() + ",";
-				result = result.substr(0, result.size() - 1);
-			}
-			result += ")";
-			return result;
-		}
-		AstType Type() override { return AstType::FUNCTION_CALL_EXPR; }
+		std::string Stringify() override { return StringifyAst(this); }
 
 		Expr *function;
-		std::vector<Expr *> arguments;
+		std::pmr::vector<Expr *> arguments;
 	};
 
 	struct ClassCallExpr : public Expr
 	{
-		ClassCallExpr() : classInstance(nullptr) {}
-		ClassCallExpr(Expr *classInstance, Expr *callee) {}
-		~ClassCallExpr()
-		{
-			delete classInstance;
-			classInstance = nullptr;
+		static constexpr AstType TYPE = AstType::CLASS_CALL_EXPR;
 
-			delete callee;
-			callee = nullptr;
-		}
+		ClassCallExpr() : Expr(TYPE), classInstance(nullptr), callee(nullptr) {}
+		ClassCallExpr(Expr *classInstance, Expr *callee) : Expr(TYPE), classInstance(classInstance), callee(callee) {}
+		~ClassCallExpr() {}
 
-		std::string Stringify() override
-		{
-			return classInstance->Stringify() + "." +callee->Stringify();
-		}
-		AstType Type() override { return AstType::FUNCTION_CALL_EXPR; }
+		std::string Stringify() override { return StringifyAst(this); }
 
 		Expr *classInstance;
 		Expr *callee;
@@ -366,15 +372,13 @@ namespace NajaLang
 
 	struct NewExpr:public Expr
 	{
-		NewExpr():object(nullptr){}
-		NewExpr(Expr* object):object(object){}
+		static constexpr AstType TYPE = AstType::NEW_EXPR;
+
+		NewExpr() : Expr(TYPE), object(nullptr){}
+		NewExpr(Expr* object) : Expr(TYPE), object(object){}
 		~NewExpr(){}
 
-		std::string Stringify() override
-		{
-			return "new " +object->Stringify();
-		}
-		AstType Type() override { return AstType::NEW_EXPR; }
+		std::string Stringify() override { return StringifyAst(this); }
 		
 
 		Expr* object;
@@ -382,96 +386,68 @@ namespace NajaLang
 
 	struct Stmt : public AstNode
 	{
-		Stmt() {}
+		Stmt(AstType type) : type(type) {}
 		virtual ~Stmt() {}
 
 		virtual std::string Stringify() = 0;
-		virtual AstType Type() = 0;
+		AstType Type() const { return type; }
+
+		const AstType type;
 	};
 
 	struct ExprStmt : public Stmt
 	{
-		ExprStmt() : expr(nullptr) {}
-		ExprStmt(Expr *expr) : expr(expr) {}
-		~ExprStmt()
-		{
-			delete expr;
-			expr = nullptr;
-		}
+		static constexpr AstType TYPE = AstType::EXPR_STMT;
+
+		ExprStmt() : Stmt(TYPE), expr(nullptr) {}
+		ExprStmt(Expr *expr) : Stmt(TYPE), expr(expr) {}
+		~ExprStmt() {}
 
-		std::string Stringify() override { return expr->Stringify() + ";"; }
-		AstType Type() override { return AstType::EXPR_STMT; }
+		std::string Stringify() override { return StringifyAst(this); }
 
 		Expr *expr;
 	};
 
 	struct VarStmt : public Stmt
 	{
-		VarStmt() {}
-		VarStmt(std::unordered_map<IdentifierExpr *, Expr *> variables) : variables(variables) {}
-		~VarStmt() { std::unordered_map<IdentifierExpr *, Expr *>().swap(variables); }
+		static constexpr AstType TYPE = AstType::VAR_STMT;
 
-		std::string Stringify() override
-		{
-			std::string result = "var ";
-			if (!variables.empty())
-			{
-				for (const auto &[key,value] : variables)
-					result += key->Stringify() + "=" + value->Stringify() + ",";
-				result = result.substr(0, result.size() - 1);
-			}
-			result += ";";
-			return result;
-		}
-		AstType Type() override { return AstType::VAR_STMT; }
+		VarStmt(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) : Stmt(TYPE), variables(resource) {}
+		~VarStmt() {}
+
+		std::string Stringify() override { return StringifyAst(this); }
 
-		std::unordered_map<IdentifierExpr *, Expr *> variables;
+		std::pmr::vector<std::pair<IdentifierExpr *, Expr *>> variables; // in declaration order
 	};
 
 	struct ReturnStmt : public Stmt
 	{
-		ReturnStmt() : expr(nullptr) {}
-		ReturnStmt(Expr *expr) : expr(expr) {}
-		~ReturnStmt()
-		{
-			delete expr;
-			expr = nullptr;
-		}
+		static constexpr AstType TYPE = AstType::RETURN_STMT;
+
+		ReturnStmt() : Stmt(TYPE), expr(nullptr) {}
+		ReturnStmt(Expr *expr) : Stmt(TYPE), expr(expr) {}
+		~ReturnStmt() {}
 
-		std::string Stringify() override { return "return " + expr->Stringify() + ";"; }
-		AstType Type() override { return AstType::RETURN_STMT; }
+		std::string Stringify() override { return StringifyAst(this); }
 
 		Expr *expr;
 	};
 
 	struct IfStmt : public Stmt
 	{
-		IfStmt() : condition(nullptr), thenBranch(nullptr), elseBranch(nullptr) {}
+		static constexpr AstType TYPE = AstType::IF_STMT;
+
+		IfStmt() : Stmt(TYPE), condition(nullptr), thenBranch(nullptr), elseBranch(nullptr) {}
 		IfStmt(Expr *condition, Stmt *thenBranch, Stmt *elseBranch)
-			: condition(condition),
+			: Stmt(TYPE),
+			  condition(condition),
 			  thenBranch(thenBranch),
 			  elseBranch(elseBranch)
 		{
 		}
-		~IfStmt()
-		{
-			delete condition;
-			condition = nullptr;
-			delete thenBranch;
-			thenBranch = nullptr;
-			delete elseBranch;
-			elseBranch = nullptr;
-		}
+		~IfStmt() {}
 
-		std::string Stringify() override
-		{
-			std::string result;
-			result = "if(" + condition->Stringify() + ")" + thenBranch->Stringify();
-			if (elseBranch != nullptr)
-				result += elseBranch->Stringify();
-			return result;
-		}
-		AstType Type() override { return AstType::IF_STMT; }
+		std::string Stringify() override { return StringifyAst(this); }
 
 		Expr *condition;
 		Stmt *thenBranch;
@@ -480,74 +456,51 @@ namespace NajaLang
 
 	struct ScopeStmt : public Stmt
 	{
-		ScopeStmt() {}
-		ScopeStmt(std::vector<Stmt *> stmts) : stmts(stmts) {}
-		~ScopeStmt() { std::vector<Stmt *>().swap(stmts); }
+		static constexpr AstType TYPE = AstType::SCOPE_STMT;
 
-		std::string Stringify() override
-		{
-			std::string result = "{";
-			for (const auto &stmt : stmts)
-				result += stmt->Stringify();
-			result += "}";
-			return result;
-		}
+		ScopeStmt(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) : Stmt(TYPE), stmts(resource) {}
+		~ScopeStmt() {}
+
+		std::string Stringify() override { return StringifyAst(this); }
+
+		std::pmr::vector<Stmt *> stmts;
+	};
 
-		AstType Type() override { return AstType::SCOPE_STMT; }
-		std::vector<Stmt *> stmts;
+	// tokens [beginToken,endToken) of a function body the parser skipped in lazy mode
+	struct LazyBody
+	{
+		uint64_t beginToken = 0;
+		uint64_t endToken = 0;
 	};
 
 	struct FunctionExpr : public Expr
 	{
-		FunctionExpr() : body(nullptr) {}
-		FunctionExpr(std::vector<IdentifierExpr *> parameters, ScopeStmt *body) : parameters(parameters), body(body) {}
-		~FunctionExpr()
-		{
-			std::vector<IdentifierExpr *>().swap(parameters);
-			delete body;
-			body = nullptr;
-		}
+		static constexpr AstType TYPE = AstType::FUNCTION_EXPR;
 
-		std::string Stringify() override
-		{
-			std::string result = "function(";
-			if (!parameters.empty())
-			{
-				for (auto param : parameters)
-					result += param->Stringify() + ",";
-				result = result.substr(0, result.size() - 1);
-			}
-			result += ")";
-			result += body->Stringify();
-			return result;
-		}
-		AstType Type() override { return AstType::FUNCTION_EXPR; }
+		FunctionExpr(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) : Expr(TYPE), parameters(resource), body(nullptr) {}
+		~FunctionExpr() {}
 
-		std::vector<IdentifierExpr *> parameters;
-		ScopeStmt *body;
+		std::string Stringify() override { return StringifyAst(this); }
+
+		std::pmr::vector<IdentifierExpr *> parameters;
+		ScopeStmt *body; // nullptr until Parser::ParseLazyBody if the body was skipped
+		LazyBody lazyBody;
 	};
 
 	struct WhileStmt : public Stmt
 	{
-		WhileStmt() : condition(nullptr), stmt(nullptr) {}
+		static constexpr AstType TYPE = AstType::WHILE_STMT;
+
+		WhileStmt() : Stmt(TYPE), condition(nullptr), stmt(nullptr) {}
 		WhileStmt(Expr *condition, Stmt *stmt)
-			: condition(condition),
+			: Stmt(TYPE),
+			  condition(condition),
 			  stmt(stmt)
 		{
 		}
-		~WhileStmt()
-		{
-			delete condition;
-			condition = nullptr;
-			delete stmt;
-			stmt = nullptr;
-		}
+		~WhileStmt() {}
 
-		std::string Stringify() override
-		{
-			return "while(" + condition->Stringify() + ")" + stmt->Stringify();
-		}
-		AstType Type() override { return AstType::WHILE_STMT; }
+		std::string Stringify() override { return StringifyAst(this); }
 
 		Expr *condition;
 		Stmt *stmt;
@@ -555,169 +508,92 @@ namespace NajaLang
 
 	struct BreakStmt : public Stmt
 	{
-		BreakStmt() {}
+		static constexpr AstType TYPE = AstType::BREAK_STMT;
+
+		BreakStmt() : Stmt(TYPE) {}
 		~BreakStmt() {}
 
 		std::string Stringify() override { return "break;"; }
-		AstType Type() override { return AstType::BREAK_STMT; }
 	};
 
 	struct ContinueStmt : public Stmt
 	{
-		ContinueStmt() {}
+		static constexpr AstType TYPE = AstType::CONTINUE_STMT;
+
+		ContinueStmt() : Stmt(TYPE) {}
 		~ContinueStmt() {}
 
 		std::string Stringify() override { return "continue;"; }
-		AstType Type() override { return AstType::CONTINUE_STMT; }
 	};
 
 	struct FunctionStmt : public Stmt
 	{
-		FunctionStmt() : name(nullptr), body(nullptr) {}
-		FunctionStmt(IdentifierExpr *name, std::vector<IdentifierExpr *> parameters, ScopeStmt *body) : name(name), parameters(parameters), body(body) {}
-		~FunctionStmt()
-		{
-			delete name;
-			name = nullptr;
+		static constexpr AstType TYPE = AstType::FUNCTION_STMT;
 
-			std::vector<IdentifierExpr *>().swap(parameters);
+		FunctionStmt(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) : Stmt(TYPE), name(nullptr), parameters(resource), body(nullptr) {}
+		~FunctionStmt() {}
 
-			delete body;
-			body = nullptr;
-		}
-
-		std::string Stringify() override
-		{
-			std::string result = "function " + name->Stringify() + "(";
-			if (!parameters.empty())
-			{
-				for (auto param : parameters)
-					result += param->Stringify() + ",";
-				result = result.substr(0, result.size() - 1);
-			}
-			result += ")";
-			result += body->Stringify();
-			return result;
-		}
-		AstType Type() override { return AstType::FUNCTION_STMT; }
+		std::string Stringify() override { return StringifyAst(this); }
 
 		IdentifierExpr *name;
-		std::vector<IdentifierExpr *> parameters;
-		ScopeStmt *body;
+		std::pmr::vector<IdentifierExpr *> parameters;
+		ScopeStmt *body; // nullptr until Parser::ParseLazyBody if the body was skipped
+		LazyBody lazyBody;
 	};
 
 	struct ClassStmt : public Stmt
 	{
-		ClassStmt() {}
-		ClassStmt(IdentifierExpr *name,
-				  std::vector<IdentifierExpr *> publicInherits, std::vector<IdentifierExpr *> protectedInherits, std::vector<IdentifierExpr *> privateInherits,
-				  std::vector<VarStmt *> publicVars, std::vector<VarStmt *> protectedVars, std::vector<VarStmt *> privateVars,
-				  std::vector<FunctionStmt *> publicFunctions, std::vector<FunctionStmt *> protectedFunctions, std::vector<FunctionStmt *> privateFunctions)
-			: publicInherits(publicInherits), protectedInherits(protectedInherits), privateInherits(privateInherits),
-			  publicVars(publicVars), protectedVars(protectedVars), privateVars(privateVars),
-			  publicFunctions(publicFunctions), protectedFunctions(protectedFunctions), privateFunctions(privateFunctions)
-		{
-		}
+		static constexpr AstType TYPE = AstType::CLASS_STMT;
 
-		~ClassStmt()
+		ClassStmt(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+			: Stmt(TYPE),
+			  name(nullptr),
+			  publicVars(resource), protectedVars(resource), privateVars(resource),
+			  publicFunctions(resource), protectedFunctions(resource), privateFunctions(resource),
+			  publicInherits(resource), protectedInherits(resource), privateInherits(resource)
 		{
-			delete name;
-			name = nullptr;
-
-			std::vector<IdentifierExpr *>().swap(publicInherits);
-			std::vector<IdentifierExpr *>().swap(protectedInherits);
-			std::vector<IdentifierExpr *>().swap(privateInherits);
-
-			std::vector<VarStmt *>().swap(publicVars);
-			std::vector<VarStmt *>().swap(protectedVars);
-			std::vector<VarStmt *>().swap(privateVars);
-
-			std::vector<FunctionStmt *>().swap(publicFunctions);
-			std::vector<FunctionStmt *>().swap(protectedFunctions);
-			std::vector<FunctionStmt *>().swap(privateFunctions);
 		}
+		~ClassStmt() {}
 
-		std::string Stringify() override
-		{
-			std::string result = "class " + name->Stringify();
-
-			if (!publicInherits.empty() || !protectedInherits.empty() || !privateInherits.empty())
-			{
-				result += ":";
-				if (!publicInherits.empty())
-					for (auto pubIn : publicInherits)
-						result += "public " + pubIn->Stringify() + ",\n";
-				if (!protectedInherits.empty())
-					for (auto proIn : protectedInherits)
-						result += "protected " + proIn->Stringify() + ",\n";
-
-				if (!privateInherits.empty())
-					for (auto priIn : privateInherits)
-						result += "private " + priIn->Stringify() + ",\n";
-
-				result = result.substr(0, result.size() - 2);
-			}
-			result += "\n{\n";
-
-			if (!publicFunctions.empty())
-				for (auto pubFn : publicFunctions)
-					result += "\tpublic " + pubFn->Stringify() + "\n";
-
-			if (!protectedFunctions.empty())
-				for (auto proFn : protectedFunctions)
-					result += "\tprotected " + proFn->Stringify() + "\n";
-
-			if (!privateFunctions.empty())
-				for (auto priFn : privateFunctions)
-					result += "\tprivate " + priFn->Stringify() + "\n";
-
-			if (!publicVars.empty())
-				for (auto pubVar : publicVars)
-					result += "\tpublic " + pubVar->Stringify() + "\n";
-
-			if (!protectedVars.empty())
-				for (auto proVar : protectedVars)
-					result += "\tprotected " + proVar->Stringify() + "\n";
-
-			if (!privateVars.empty())
-				for (auto priVar : privateVars)
-					result += "private " + priVar->Stringify() + "\n";
-
-			result += "}\n";
-			return result;
-		}
-		AstType Type() override { return AstType::CLASS_STMT; }
+		std::string Stringify() override { return StringifyAst(this); }
 
 		IdentifierExpr *name;
 
-		std::vector<VarStmt *> publicVars;
-		std::vector<VarStmt *> protectedVars;
-		std::vector<VarStmt *> privateVars;
+		std::pmr::vector<VarStmt *> publicVars;
+		std::pmr::vector<VarStmt *> protectedVars;
+		std::pmr::vector<VarStmt *> privateVars;
 
-		std::vector<FunctionStmt *> publicFunctions;
-		std::vector<FunctionStmt *> protectedFunctions;
-		std::vector<FunctionStmt *> privateFunctions;
+		std::pmr::vector<FunctionStmt *> publicFunctions;
+		std::pmr::vector<FunctionStmt *> protectedFunctions;
+		std::pmr::vector<FunctionStmt *> privateFunctions;
 
-		std::vector<IdentifierExpr *> publicInherits;
-		std::vector<IdentifierExpr *> protectedInherits;
-		std::vector<IdentifierExpr *> privateInherits;
+		std::pmr::vector<IdentifierExpr *> publicInherits;
+		std::pmr::vector<IdentifierExpr *> protectedInherits;
+		std::pmr::vector<IdentifierExpr *> privateInherits;
 	};
 
 	struct AstStmts : public Stmt
 	{
-		AstStmts() {}
-		AstStmts(std::vector<Stmt *> stmts) : stmts(stmts) {}
-		~AstStmts() { std::vector<Stmt *>().swap(stmts); }
+		static constexpr AstType TYPE = AstType::AST_STMTS;
 
-		std::string Stringify() override
-		{
-			std::string result;
-			for (const auto &stmt : stmts)
-				result += stmt->Stringify();
-			return result;
-		}
-		AstType Type() override { return AstType::AST_STMTS; }
+		AstStmts(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) : Stmt(TYPE), stmts(resource) {}
+		~AstStmts() {}
+
+		std::string Stringify() override { return StringifyAst(this); }
 
-		std::vector<Stmt *> stmts;
+		std::pmr::vector<Stmt *> stmts;
 	};
+
+	// the node as a T if its tag says it is one,nullptr otherwise
+	template <typename T>
+	inline T *AstCast(Expr *expr)
+	{
+		return expr && expr->type == T::TYPE ? static_cast<T *>(expr) : nullptr;
+	}
+
+	template <typename T>
+	inline T *AstCast(Stmt *stmt)
+	{
+		return stmt && stmt->type == T::TYPE ? static_cast<T *>(stmt) : nullptr;
+	}
 }
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "AstArena.h"
+#include <cstring>
+#include <algorithm>
+#include <new>
+namespace NajaLang
+{
+	AstArena::AstArena()
+		: m_Cur(nullptr), m_End(nullptr), m_UsedBytes(0)
+	{
+	}
+
+	AstArena::~AstArena()
+	{
+		for (const auto &block : m_Blocks)
+			::operator delete(block.data);
+	}
+
+	std::string_view AstArena::CopyString(std::string_view str)
+	{
+		if (str.empty())
+			return std::string_view();
+		char *data = (char *)allocate(str.size(), 1);
+		memcpy(data, str.data(), str.size());
+		return std::string_view(data, str.size());
+	}
+
+	void AstArena::Reset()
+	{
+		if (m_Blocks.empty())
+			return;
+
+		for (uint64_t i = 1; i < m_Blocks.size(); ++i)
+			::operator delete(m_Blocks[i].data);
+		m_Blocks.resize(1);
+
+		m_Cur = m_Blocks[0].data;
+		m_End = m_Cur + m_Blocks[0].size;
+		m_UsedBytes = 0;
+	}
+
+	uint64_t AstArena::GetUsedBytes() const
+	{
+		if (m_Blocks.empty())
+			return 0;
+		return m_UsedBytes + (m_Cur - m_Blocks.back().data);
+	}
+
+	uint64_t AstArena::GetBlockCount() const
+	{
+		return m_Blocks.size();
+	}
+
+	void *AstArena::do_allocate(size_t bytes, size_t alignment)
+	{
+		char *p = (char *)(((uintptr_t)m_Cur + alignment - 1) & ~(uintptr_t)(alignment - 1));
+		if (m_Cur && p + bytes <= m_End)
+		{
+			m_Cur = p + bytes;
+			return p;
+		}
+		return AllocateFromNewBlock(bytes, alignment);
+	}
+
+	void AstArena::do_deallocate(void *, size_t, size_t)
+	{
+		//memory comes back with Reset only
+	}
+
+	bool AstArena::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+	{
+		return this == &other;
+	}
+
+	void *AstArena::AllocateFromNewBlock(uint64_t bytes, uint64_t alignment)
+	{
+		//operator new aligns to __STDCPP_DEFAULT_NEW_ALIGNMENT__,anything stricter gets room to align in
+		uint64_t size = bytes + alignment;
+		Block block{nullptr, std::max(BLOCK_SIZE, size)};
+
+		//large requests(big vectors growing) get a block of their own,so the current block's tail is not wasted
+		if (!m_Blocks.empty() && size > BLOCK_SIZE / 4)
+		{
+			block.data = (char *)::operator new(block.size);
+			m_Blocks.insert(m_Blocks.end() - 1, block);
+			m_UsedBytes += bytes;
+			return (char *)(((uintptr_t)block.data + alignment - 1) & ~(uintptr_t)(alignment - 1));
+		}
+
+		if (!m_Blocks.empty())
+			m_UsedBytes += m_Cur - m_Blocks.back().data;
+
+		block.data = (char *)::operator new(block.size);
+		m_Blocks.emplace_back(block);
+
+		char *p = (char *)(((uintptr_t)block.data + alignment - 1) & ~(uintptr_t)(alignment - 1));
+		m_Cur = p + bytes;
+		m_End = block.data + block.size;
+		return p;
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <string_view>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+namespace NajaLang
+{
+    // bump pointer arena the parser builds its tree in.Nodes are never destroyed one by one:their containers take
+    // their memory from the arena as well,so Reset releases a whole tree in O(blocks).The first block is kept,
+    // which lets a REPL parse line after line without growing
+    class AstArena : public std::pmr::memory_resource
+    {
+    public:
+        AstArena();
+        ~AstArena();
+
+        AstArena(const AstArena &) = delete;
+        AstArena &operator=(const AstArena &) = delete;
+
+        // nodes with a constructor taking a std::pmr::memory_resource* get the arena passed as their last argument
+        template <typename T, typename... Args>
+        T *New(Args &&...args);
+
+        std::string_view CopyString(std::string_view str);
+
+        void Reset();
+
+        uint64_t GetUsedBytes() const;
+        uint64_t GetBlockCount() const;
+
+    private:
+        struct Block
+        {
+            char *data;
+            uint64_t size;
+        };
+
+        static constexpr uint64_t BLOCK_SIZE = 64 * 1024;
+
+        void *do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+        void *AllocateFromNewBlock(uint64_t bytes, uint64_t alignment);
+
+        std::vector<Block> m_Blocks;
+        char *m_Cur;
+        char *m_End;
+        uint64_t m_UsedBytes; // in the blocks before the current one
+    };
+
+    template <typename T, typename... Args>
+    inline T *AstArena::New(Args &&...args)
+    {
+        void *p = allocate(sizeof(T), alignof(T));
+        if constexpr (std::is_constructible_v<T, Args..., std::pmr::memory_resource *>)
+            return new (p) T(std::forward<Args>(args)..., this);
+        else
+            return new (p) T(std::forward<Args>(args)...);
+    }
+}
@@ -0,0 +1,125 @@
+#include "AstCache.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include "SourceFile.h"
+#include "TokenBuffer.h"
+namespace NajaLang
+{
+	//source hash and size in front of the FlatAst image
+	constexpr uint64_t ENTRY_HEADER_SIZE = 16;
+
+	static void WriteU64(std::string &out, uint64_t value)
+	{
+		for (uint32_t i = 0; i < 8; ++i)
+			out.push_back((char)(value >> (i * 8)));
+	}
+
+	static uint64_t ReadU64(const char *p)
+	{
+		uint64_t value = 0;
+		for (uint32_t i = 0; i < 8; ++i)
+			value |= (uint64_t)(uint8_t)p[i] << (i * 8);
+		return value;
+	}
+
+	AstCache::AstCache(std::string_view directory)
+		: m_Directory(directory)
+	{
+	}
+	AstCache::~AstCache()
+	{
+	}
+
+	uint64_t AstCache::HashSource(std::string_view src)
+	{
+		//FNV-1a over 8 byte words,a whole file is hashed on every lookup so the byte loop of Lexer::HashName is too slow
+		uint64_t hash = 14695981039346656037ull;
+		uint64_t i = 0;
+		for (; i + 8 <= src.size(); i += 8)
+		{
+			uint64_t word;
+			memcpy(&word, src.data() + i, sizeof(word));
+			hash = (hash ^ word) * 1099511628211ull;
+			hash ^= hash >> 29;
+		}
+		for (; i < src.size(); ++i)
+			hash = (hash ^ (uint8_t)src[i]) * 1099511628211ull;
+		return hash ^ (hash >> 32);
+	}
+
+	bool AstCache::Load(std::string_view src, FlatAst &ast)
+	{
+		uint64_t hash = HashSource(src);
+		SourceFile file;
+		if (!file.Open(GetEntryPath(hash).string()))
+			return false;
+
+		std::string_view entry = file.GetSource();
+		if (entry.size() < ENTRY_HEADER_SIZE || ReadU64(entry.data()) != hash || ReadU64(entry.data() + 8) != src.size())
+			return false;
+		return ast.Deserialize(entry.substr(ENTRY_HEADER_SIZE));
+	}
+
+	bool AstCache::Store(std::string_view src, const FlatAst &ast)
+	{
+		uint64_t hash = HashSource(src);
+		std::string entry;
+		WriteU64(entry, hash);
+		WriteU64(entry, src.size());
+		ast.Serialize(entry);
+
+		std::error_code err;
+		std::filesystem::create_directories(m_Directory, err);
+		std::filesystem::path path = GetEntryPath(hash);
+		std::filesystem::path tmpPath = path;
+		tmpPath += ".tmp";
+		{
+			std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+			if (!file.write(entry.data(), entry.size()))
+				return false;
+		}
+		std::filesystem::rename(tmpPath, path, err);
+		if (err)
+		{
+			std::filesystem::remove(tmpPath, err);
+			return false;
+		}
+		return true;
+	}
+
+	Stmt *AstCache::Parse(std::string_view src, Lexer &lexer, Parser &parser)
+	{
+		if (Load(src, m_Ast))
+			return parser.Parse(m_Ast);
+
+		//a stored tree must be complete,so bodies are parsed eagerly and the tokens can go once Parse returns
+		bool lazyBodies = parser.IsLazyBodies();
+		parser.SetLazyBodies(false);
+		Stmt *stmts;
+		if (src.size() <= TokenBuffer::MAX_SOURCE_SIZE)
+		{
+			TokenBuffer tokens;
+			lexer.ScanTokens(src, tokens);
+			stmts = parser.Parse(tokens);
+		}
+		else
+			stmts = parser.Parse(lexer.ScanTokens(src));
+		parser.SetLazyBodies(lazyBodies);
+
+		if (!parser.HasError())
+		{
+			m_Ast.Build(stmts);
+			Store(src, m_Ast);
+		}
+		return stmts;
+	}
+
+	std::filesystem::path AstCache::GetEntryPath(uint64_t hash) const
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.nast", (unsigned long long)hash);
+		return m_Directory / name;
+	}
+}
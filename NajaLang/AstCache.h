@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include "FlatAst.h"
+#include "Lexer.h"
+#include "Parser.h"
+namespace NajaLang
+{
+    // parsed trees kept on disk,one file per source named after a hash of its text.An entry is used only when the
+    // hash,the source size and the image version all match,anything else is a miss and is replaced by the next Store
+    class AstCache
+    {
+    public:
+        // the directory is created on the first Store
+        AstCache(std::string_view directory);
+        ~AstCache();
+
+        static uint64_t HashSource(std::string_view src);
+
+        bool Load(std::string_view src, FlatAst &ast);
+        // written to a temporary file first,so a concurrent Load never sees half an entry
+        bool Store(std::string_view src, const FlatAst &ast);
+
+        // the cached tree if there is one,otherwise src is lexed and parsed and the tree is stored when it has no
+        // errors.Either way the tree lives in the parser's arena as after Parser::Parse
+        Stmt *Parse(std::string_view src, Lexer &lexer, Parser &parser);
+
+    private:
+        std::filesystem::path GetEntryPath(uint64_t hash) const;
+
+        std::filesystem::path m_Directory;
+        FlatAst m_Ast;
+    };
+}
@@ -0,0 +1,370 @@
+#include "AstPrinter.h"
+#include <charconv>
+#include <cstdio>
+namespace NajaLang
+{
+	std::string StringifyAst(Expr *expr)
+	{
+		AstPrinter printer;
+		printer.Print(expr);
+		return printer.TakeText();
+	}
+
+	std::string StringifyAst(Stmt *stmt)
+	{
+		AstPrinter printer;
+		printer.Print(stmt);
+		return printer.TakeText();
+	}
+
+	AstPrinter::AstPrinter()
+		: m_Out(nullptr)
+	{
+	}
+
+	AstPrinter::AstPrinter(std::ostream &out)
+		: m_Out(&out)
+	{
+		m_Buffer.reserve(FLUSH_SIZE + 256);
+	}
+
+	AstPrinter::~AstPrinter()
+	{
+		Flush();
+	}
+
+	void AstPrinter::Print(Stmt *stmt)
+	{
+		PrintStmt(stmt);
+	}
+
+	void AstPrinter::Print(Expr *expr)
+	{
+		PrintExpr(expr);
+	}
+
+	void AstPrinter::Flush()
+	{
+		if (!m_Out || m_Buffer.empty())
+			return;
+		m_Out->write(m_Buffer.data(), m_Buffer.size());
+		m_Buffer.clear();
+	}
+
+	const std::string &AstPrinter::GetText() const
+	{
+		return m_Buffer;
+	}
+
+	std::string AstPrinter::TakeText()
+	{
+		return std::move(m_Buffer);
+	}
+
+	void AstPrinter::Write(std::string_view text)
+	{
+		m_Buffer.append(text);
+		if (m_Out && m_Buffer.size() >= FLUSH_SIZE)
+			Flush();
+	}
+
+	void AstPrinter::Write(char c)
+	{
+		m_Buffer.push_back(c);
+		if (m_Out && m_Buffer.size() >= FLUSH_SIZE)
+			Flush();
+	}
+
+	//elements separated by ',',the separator is written in front of every element but the first so nothing has to
+	//be taken back from a buffer that may already be flushed
+	template <typename T>
+	void AstPrinter::PrintList(const T &list)
+	{
+		bool isFirst = true;
+		for (auto e : list)
+		{
+			if (!isFirst)
+				Write(',');
+			isFirst = false;
+			PrintExpr(e);
+		}
+	}
+
+	void AstPrinter::PrintExpr(Expr *expr)
+	{
+		switch (expr->Type())
+		{
+		case FLOAT_NUM_EXPR:
+		{
+			//same digits as std::to_string
+			char digits[512];
+			int length = snprintf(digits, sizeof(digits), "%f", ((FloatNumExpr *)expr)->value);
+			Write(std::string_view(digits, length));
+			break;
+		}
+		case INT_NUM_EXPR:
+		{
+			char digits[32];
+			auto result = std::to_chars(digits, digits + sizeof(digits), ((IntNumExpr *)expr)->value);
+			Write(std::string_view(digits, result.ptr - digits));
+			break;
+		}
+		case STR_EXPR:
+			Write(((StrExpr *)expr)->value);
+			break;
+		case NULL_EXPR:
+			Write("null");
+			break;
+		case TRUE_EXPR:
+			Write("true");
+			break;
+		case FALSE_EXPR:
+			Write("false");
+			break;
+		case IDENTIFIER_EXPR:
+			Write(((IdentifierExpr *)expr)->literal);
+			break;
+		case THIS_EXPR:
+			Write("this");
+			break;
+		case BASE_EXPR:
+			Write("base");
+			break;
+		case GROUP_EXPR:
+			Write('(');
+			PrintExpr(((GroupExpr *)expr)->expr);
+			Write(')');
+			break;
+		case FUNCTION_EXPR:
+		{
+			auto funcExpr = (FunctionExpr *)expr;
+			PrintFunction(nullptr, funcExpr->parameters, funcExpr->body);
+			break;
+		}
+		case ARRAY_EXPR:
+			Write('[');
+			PrintList(((ArrayExpr *)expr)->elements);
+			Write(']');
+			break;
+		case TABLE_EXPR:
+		{
+			Write('{');
+			bool isFirst = true;
+			for (auto [key, value] : ((TableExpr *)expr)->elements)
+			{
+				if (!isFirst)
+					Write(',');
+				isFirst = false;
+				PrintExpr(key);
+				Write(':');
+				PrintExpr(value);
+			}
+			Write('}');
+			break;
+		}
+		case PREFIX_EXPR:
+		{
+			auto prefixExpr = (PrefixExpr *)expr;
+			Write(GetOperatorLiteral(prefixExpr->op));
+			PrintExpr(prefixExpr->right);
+			break;
+		}
+		case INFIX_EXPR:
+		{
+			auto infixExpr = (InfixExpr *)expr;
+			PrintExpr(infixExpr->left);
+			Write(GetOperatorLiteral(infixExpr->op));
+			PrintExpr(infixExpr->right);
+			break;
+		}
+		case POSTFIX_EXPR:
+		{
+			auto postfixExpr = (PostfixExpr *)expr;
+			PrintExpr(postfixExpr->left);
+			Write(GetOperatorLiteral(postfixExpr->op));
+			break;
+		}
+		case TERNARY_EXPR:
+		{
+			auto ternaryExpr = (TernaryExpr *)expr;
+			PrintExpr(ternaryExpr->condition);
+			Write('?');
+			PrintExpr(ternaryExpr->trueBranch);
+			Write(':');
+			PrintExpr(ternaryExpr->falseBranch);
+			break;
+		}
+		case INDEX_EXPR:
+		{
+			auto indexExpr = (IndexExpr *)expr;
+			PrintExpr(indexExpr->array);
+			Write('[');
+			PrintExpr(indexExpr->index);
+			Write(']');
+			break;
+		}
+		case FUNCTION_CALL_EXPR:
+		{
+			auto callExpr = (FunctionCallExpr *)expr;
+			PrintExpr(callExpr->function);
+			Write('(');
+			PrintList(callExpr->arguments);
+			Write(')');
+			break;
+		}
+		case CLASS_CALL_EXPR:
+		{
+			auto classCallExpr = (ClassCallExpr *)expr;
+			PrintExpr(classCallExpr->classInstance);
+			Write('.');
+			PrintExpr(classCallExpr->callee);
+			break;
+		}
+		case NEW_EXPR:
+			Write("new ");
+			PrintExpr(((NewExpr *)expr)->object);
+			break;
+		default:
+			break;
+		}
+	}
+
+	void AstPrinter::PrintStmt(Stmt *stmt)
+	{
+		switch (stmt->Type())
+		{
+		case EXPR_STMT:
+			PrintExpr(((ExprStmt *)stmt)->expr);
+			Write(';');
+			break;
+		case VAR_STMT:
+		{
+			Write("var ");
+			bool isFirst = true;
+			for (const auto &[name, value] : ((VarStmt *)stmt)->variables)
+			{
+				if (!isFirst)
+					Write(',');
+				isFirst = false;
+				PrintExpr(name);
+				Write('=');
+				PrintExpr(value);
+			}
+			Write(';');
+			break;
+		}
+		case RETURN_STMT:
+		{
+			Write("return ");
+			if (auto expr = ((ReturnStmt *)stmt)->expr)
+				PrintExpr(expr);
+			Write(';');
+			break;
+		}
+		case IF_STMT:
+		{
+			auto ifStmt = (IfStmt *)stmt;
+			Write("if(");
+			PrintExpr(ifStmt->condition);
+			Write(')');
+			PrintStmt(ifStmt->thenBranch);
+			if (ifStmt->elseBranch)
+				PrintStmt(ifStmt->elseBranch);
+			break;
+		}
+		case SCOPE_STMT:
+			Write('{');
+			for (auto s : ((ScopeStmt *)stmt)->stmts)
+				PrintStmt(s);
+			Write('}');
+			break;
+		case WHILE_STMT:
+		{
+			auto whileStmt = (WhileStmt *)stmt;
+			Write("while(");
+			PrintExpr(whileStmt->condition);
+			Write(')');
+			PrintStmt(whileStmt->stmt);
+			break;
+		}
+		case BREAK_STMT:
+			Write("break;");
+			break;
+		case CONTINUE_STMT:
+			Write("continue;");
+			break;
+		case FUNCTION_STMT:
+		{
+			auto funcStmt = (FunctionStmt *)stmt;
+			PrintFunction(funcStmt->name, funcStmt->parameters, funcStmt->body);
+			break;
+		}
+		case CLASS_STMT:
+			PrintClass((ClassStmt *)stmt);
+			break;
+		case AST_STMTS:
+			for (auto s : ((AstStmts *)stmt)->stmts)
+				PrintStmt(s);
+			break;
+		default:
+			break;
+		}
+	}
+
+	void AstPrinter::PrintFunction(IdentifierExpr *name, const std::pmr::vector<IdentifierExpr *> &parameters, ScopeStmt *body)
+	{
+		Write("function");
+		if (name)
+		{
+			Write(' ');
+			Write(name->literal);
+		}
+		Write('(');
+		PrintList(parameters);
+		Write(')');
+		if (body)
+			PrintStmt(body);
+		else
+			Write("{...}");
+	}
+
+	void AstPrinter::PrintClass(ClassStmt *stmt)
+	{
+		Write("class ");
+		Write(stmt->name->literal);
+
+		//inherits are separated by ",\n"
+		bool isFirst = true;
+		auto printInherits = [&](std::string_view access, const std::pmr::vector<IdentifierExpr *> &inherits)
+		{
+			for (auto e : inherits)
+			{
+				Write(isFirst ? ":" : ",\n");
+				isFirst = false;
+				Write(access);
+				Write(e->literal);
+			}
+		};
+		printInherits("public ", stmt->publicInherits);
+		printInherits("protected ", stmt->protectedInherits);
+		printInherits("private ", stmt->privateInherits);
+		Write("\n{\n");
+
+		auto printMembers = [&](std::string_view access, const auto &members)
+		{
+			for (auto e : members)
+			{
+				Write(access);
+				PrintStmt(e);
+				Write('\n');
+			}
+		};
+		printMembers("\tpublic ", stmt->publicFunctions);
+		printMembers("\tprotected ", stmt->protectedFunctions);
+		printMembers("\tprivate ", stmt->privateFunctions);
+		printMembers("\tpublic ", stmt->publicVars);
+		printMembers("\tprotected ", stmt->protectedVars);
+		printMembers("private ", stmt->privateVars); //no tab,as Stringify always printed it
+		Write("}\n");
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <ostream>
+#include "Ast.h"
+namespace NajaLang
+{
+    // writes the text Stringify returns in one pass over the tree,appending to a single buffer instead of
+    // concatenating the text of every subtree.Given an ostream the buffer is handed to it whenever it grows past
+    // FLUSH_SIZE,so a tree of any size is printed with constant extra memory
+    class AstPrinter
+    {
+    public:
+        AstPrinter();
+        // streams to out,e.g. std::cout
+        AstPrinter(std::ostream &out);
+        ~AstPrinter();
+
+        AstPrinter(const AstPrinter &) = delete;
+        AstPrinter &operator=(const AstPrinter &) = delete;
+
+        void Print(Stmt *stmt);
+        void Print(Expr *expr);
+        // writes what is buffered to the stream,does nothing without one
+        void Flush();
+
+        // everything printed so far when there is no stream
+        const std::string &GetText() const;
+        std::string TakeText();
+
+    private:
+        static constexpr uint64_t FLUSH_SIZE = 64 * 1024;
+
+        void PrintExpr(Expr *expr);
+        void PrintStmt(Stmt *stmt);
+        template <typename T>
+        void PrintList(const T &list);
+        void PrintFunction(IdentifierExpr *name, const std::pmr::vector<IdentifierExpr *> &parameters, ScopeStmt *body);
+        void PrintClass(ClassStmt *stmt);
+
+        void Write(std::string_view text);
+        void Write(char c);
+
+        std::string m_Buffer;
+        std::ostream *m_Out;
+    };
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include "Ast.h"
+namespace NajaLang
+{
+    // statically dispatched visitor.A pass derives from AstVisitor<Pass> and defines Visit<Node> for the nodes it
+    // handles,e.g. VisitInfixExpr(InfixExpr *).Visit switches on the node's tag and calls the handler of the derived
+    // class directly,so handlers can be inlined and get the node with its exact type.Nodes without a handler go to
+    // DefaultExpr/DefaultStmt,which may be defined by the pass too and otherwise return a value initialized result
+    template <typename Derived, typename ExprResult = void, typename StmtResult = void>
+    class AstVisitor
+    {
+    public:
+        ExprResult Visit(Expr *expr)
+        {
+            switch (expr->type)
+            {
+            case FLOAT_NUM_EXPR:
+                return Self().VisitFloatNumExpr(static_cast<FloatNumExpr *>(expr));
+            case INT_NUM_EXPR:
+                return Self().VisitIntNumExpr(static_cast<IntNumExpr *>(expr));
+            case STR_EXPR:
+                return Self().VisitStrExpr(static_cast<StrExpr *>(expr));
+            case NULL_EXPR:
+                return Self().VisitNullExpr(static_cast<NullExpr *>(expr));
+            case TRUE_EXPR:
+                return Self().VisitTrueExpr(static_cast<TrueExpr *>(expr));
+            case FALSE_EXPR:
+                return Self().VisitFalseExpr(static_cast<FalseExpr *>(expr));
+            case IDENTIFIER_EXPR:
+                return Self().VisitIdentifierExpr(static_cast<IdentifierExpr *>(expr));
+            case THIS_EXPR:
+                return Self().VisitThisExpr(static_cast<ThisExpr *>(expr));
+            case BASE_EXPR:
+                return Self().VisitBaseExpr(static_cast<BaseExpr *>(expr));
+            case GROUP_EXPR:
+                return Self().VisitGroupExpr(static_cast<GroupExpr *>(expr));
+            case FUNCTION_EXPR:
+                return Self().VisitFunctionExpr(static_cast<FunctionExpr *>(expr));
+            case ARRAY_EXPR:
+                return Self().VisitArrayExpr(static_cast<ArrayExpr *>(expr));
+            case TABLE_EXPR:
+                return Self().VisitTableExpr(static_cast<TableExpr *>(expr));
+            case PREFIX_EXPR:
+                return Self().VisitPrefixExpr(static_cast<PrefixExpr *>(expr));
+            case INFIX_EXPR:
+                return Self().VisitInfixExpr(static_cast<InfixExpr *>(expr));
+            case POSTFIX_EXPR:
+                return Self().VisitPostfixExpr(static_cast<PostfixExpr *>(expr));
+            case TERNARY_EXPR:
+                return Self().VisitTernaryExpr(static_cast<TernaryExpr *>(expr));
+            case INDEX_EXPR:
+                return Self().VisitIndexExpr(static_cast<IndexExpr *>(expr));
+            case FUNCTION_CALL_EXPR:
+                return Self().VisitFunctionCallExpr(static_cast<FunctionCallExpr *>(expr));
+            case CLASS_CALL_EXPR:
+                return Self().VisitClassCallExpr(static_cast<ClassCallExpr *>(expr));
+            case NEW_EXPR:
+                return Self().VisitNewExpr(static_cast<NewExpr *>(expr));
+            default:
+                return Self().DefaultExpr(expr);
+            }
+        }
+
+        StmtResult Visit(Stmt *stmt)
+        {
+            switch (stmt->type)
+            {
+            case VAR_STMT:
+                return Self().VisitVarStmt(static_cast<VarStmt *>(stmt));
+            case EXPR_STMT:
+                return Self().VisitExprStmt(static_cast<ExprStmt *>(stmt));
+            case RETURN_STMT:
+                return Self().VisitReturnStmt(static_cast<ReturnStmt *>(stmt));
+            case IF_STMT:
+                return Self().VisitIfStmt(static_cast<IfStmt *>(stmt));
+            case SCOPE_STMT:
+                return Self().VisitScopeStmt(static_cast<ScopeStmt *>(stmt));
+            case WHILE_STMT:
+                return Self().VisitWhileStmt(static_cast<WhileStmt *>(stmt));
+            case BREAK_STMT:
+                return Self().VisitBreakStmt(static_cast<BreakStmt *>(stmt));
+            case CONTINUE_STMT:
+                return Self().VisitContinueStmt(static_cast<ContinueStmt *>(stmt));
+            case FUNCTION_STMT:
+                return Self().VisitFunctionStmt(static_cast<FunctionStmt *>(stmt));
+            case CLASS_STMT:
+                return Self().VisitClassStmt(static_cast<ClassStmt *>(stmt));
+            case AST_STMTS:
+                return Self().VisitAstStmts(static_cast<AstStmts *>(stmt));
+            default:
+                return Self().DefaultStmt(stmt);
+            }
+        }
+
+    protected:
+        Derived &Self() { return static_cast<Derived &>(*this); }
+
+        ExprResult DefaultExpr(Expr *) { return ExprResult(); }
+        StmtResult DefaultStmt(Stmt *) { return StmtResult(); }
+
+        ExprResult VisitFloatNumExpr(FloatNumExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitIntNumExpr(IntNumExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitStrExpr(StrExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitNullExpr(NullExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitTrueExpr(TrueExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitFalseExpr(FalseExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitIdentifierExpr(IdentifierExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitThisExpr(ThisExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitBaseExpr(BaseExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitGroupExpr(GroupExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitFunctionExpr(FunctionExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitArrayExpr(ArrayExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitTableExpr(TableExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitPrefixExpr(PrefixExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitInfixExpr(InfixExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitPostfixExpr(PostfixExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitTernaryExpr(TernaryExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitIndexExpr(IndexExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitFunctionCallExpr(FunctionCallExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitClassCallExpr(ClassCallExpr *expr) { return Self().DefaultExpr(expr); }
+        ExprResult VisitNewExpr(NewExpr *expr) { return Self().DefaultExpr(expr); }
+
+        StmtResult VisitVarStmt(VarStmt *stmt) { return Self().DefaultStmt(stmt); }
+        StmtResult VisitExprStmt(ExprStmt *stmt) { return Self().DefaultStmt(stmt); }
+        StmtResult VisitReturnStmt(ReturnStmt *stmt) { return Self().DefaultStmt(stmt); }
+        StmtResult VisitIfStmt(IfStmt *stmt) { return Self().DefaultStmt(stmt); }
+        StmtResult VisitScopeStmt(ScopeStmt *stmt) { return Self().DefaultStmt(stmt); }
+        StmtResult VisitWhileStmt(WhileStmt *stmt) { return Self().DefaultStmt(stmt); }
+        StmtResult VisitBreakStmt(BreakStmt *stmt) { return Self().DefaultStmt(stmt); }
+        StmtResult VisitContinueStmt(ContinueStmt *stmt) { return Self().DefaultStmt(stmt); }
+        StmtResult VisitFunctionStmt(FunctionStmt *stmt) { return Self().DefaultStmt(stmt); }
+        StmtResult VisitClassStmt(ClassStmt *stmt) { return Self().DefaultStmt(stmt); }
+        StmtResult VisitAstStmts(AstStmts *stmt) { return Self().DefaultStmt(stmt); }
+    };
+}
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <cstring>
+#include "SymbolTable.h"
 
 namespace NajaLang
 {
@@ -19,13 +21,70 @@ namespace NajaLang
         m_Codes.emplace_back(code);
     }
 
-    uint64_t Chunk::AddObject(Object *object)
+    uint32_t Chunk::AddInt(int64_t value)
     {
-        m_Objects.emplace_back(object);
-        return m_Objects.size() - 1;
+        auto [iter, inserted] = m_IntIndices.try_emplace(value, (uint32_t)m_Ints.size());
+        if (!inserted)
+            return iter->second;
+        if (Value::FitsSmallInt(value))
+            m_Ints.emplace_back(Value::SmallInt(value));
+        else
+        {
+            m_WideInts.emplace_back(std::make_unique<IntNumObject>(value));
+            m_Ints.emplace_back(Value::Obj(m_WideInts.back().get()));
+        }
+        return iter->second;
+    }
+
+    uint32_t Chunk::AddFloat(double value)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        auto [iter, inserted] = m_FloatIndices.try_emplace(bits, (uint32_t)m_Floats.size());
+        if (inserted)
+            m_Floats.emplace_back(value);
+        return iter->second;
+    }
+
+    uint32_t Chunk::AddStr(std::string_view value)
+    {
+        auto iter = m_StrIndices.find(value);
+        if (iter != m_StrIndices.end())
+            return iter->second;
+        m_Strs.emplace_back(std::make_unique<StrObject>(value));
+        return m_StrIndices.emplace(m_Strs.back()->value, (uint32_t)m_Strs.size() - 1).first->second;
     }
 
-    std::string Chunk::Stringify()
+    void Chunk::AddConstantOpCode(OpCode code, uint32_t index)
+    {
+        if (index <= UINT8_MAX)
+        {
+            m_Codes.emplace_back(code);
+            m_Codes.emplace_back((uint8_t)index);
+            return;
+        }
+        static_assert(STR_LONG_OP - FLOAT_NUM_LONG_OP == STR_OP - FLOAT_NUM_OP);
+        m_Codes.emplace_back(code - FLOAT_NUM_OP + FLOAT_NUM_LONG_OP);
+        AddLeb128(index);
+    }
+
+    void Chunk::AddLeb128(uint64_t value)
+    {
+        do
+        {
+            uint8_t byte = value & 0x7F;
+            value >>= 7;
+            m_Codes.emplace_back(value ? byte | 0x80 : byte);
+        } while (value);
+    }
+
+    void Chunk::AddSymbol(uint32_t symbol)
+    {
+        for (int i = 0; i < 4; ++i)
+            m_Codes.emplace_back((uint8_t)(symbol >> (i * 8)));
+    }
+
+    std::string Chunk::Stringify() const
     {
         std::stringstream result;
         for (size_t i = 0; i < m_Codes.size(); ++i)
@@ -37,31 +96,121 @@ namespace NajaLang
                        << "RETURN_OP\n";
                 break;
             case FLOAT_NUM_OP:
+            {
+                uint8_t index = m_Codes[i + 1];
                 result << std::setfill('0') << std::setw(8) << i << "     "
                        << "FLOAT_NUM_OP"
-                       << "     " << std::to_string(m_Codes[++i]) << "    " << m_Objects[m_Codes[i]]->Stringify() << "\n";
-
+                       << "     " << std::to_string(index) << "    " << StringifyConstant(FLOAT_NUM_OP, index) << "\n";
+                ++i;
                 break;
+            }
             case INT_NUM_OP:
+            {
+                uint8_t index = m_Codes[i + 1];
                 result << std::setfill('0') << std::setw(8) << i << "     "
                        << "INT_NUM_OP"
-                       << "     " << std::to_string(m_Codes[++i]) << "     " << m_Objects[m_Codes[i]]->Stringify() << "\n";
+                       << "     " << std::to_string(index) << "     " << StringifyConstant(INT_NUM_OP, index) << "\n";
+                ++i;
+                break;
+            }
+            case STR_OP:
+            {
+                uint8_t index = m_Codes[i + 1];
+                result << std::setfill('0') << std::setw(8) << i << "     "
+                       << "STR_OP"
+                       << "     " << std::to_string(index) << "     " << StringifyConstant(STR_OP, index) << "\n";
+                ++i;
                 break;
+            }
             case TRUE_OP:
                 result << std::setfill('0') << std::setw(8) << i << "     "
-                       << "TRUE_OP"
-                       << "     " << std::to_string(m_Codes[++i]) << "     " << m_Objects[m_Codes[i]]->Stringify() << "\n";
+                       << "TRUE_OP\n";
                 break;
             case FALSE_OP:
                 result << std::setfill('0') << std::setw(8) << i << "     "
-                       << "FALSE_OP"
-                       << "     " << std::to_string(m_Codes[++i]) << "     " << m_Objects[m_Codes[i]]->Stringify() << "\n";
+                       << "FALSE_OP\n";
                 break;
             case NULL_OP:
                 result << std::setfill('0') << std::setw(8) << i << "     "
-                       << "NULL_OP"
-                       << "     " << std::to_string(m_Codes[++i]) << "     " << m_Objects[m_Codes[i]]->Stringify() << "\n";
+                       << "NULL_OP\n";
+                break;
+            case PUSH_ZERO_OP:
+                result << std::setfill('0') << std::setw(8) << i << "     "
+                       << "PUSH_ZERO_OP\n";
+                break;
+            case PUSH_ONE_OP:
+                result << std::setfill('0') << std::setw(8) << i << "     "
+                       << "PUSH_ONE_OP\n";
+                break;
+            case PUSH_SMALL_INT_OP:
+                result << std::setfill('0') << std::setw(8) << i << "     "
+                       << "PUSH_SMALL_INT_OP"
+                       << "     " << std::to_string((int8_t)m_Codes[i + 1]) << "\n";
+                i += 1;
+                break;
+            case PUSH_SMALL_INT_16_OP:
+                result << std::setfill('0') << std::setw(8) << i << "     "
+                       << "PUSH_SMALL_INT_16_OP"
+                       << "     " << std::to_string((int16_t)(m_Codes[i + 1] | m_Codes[i + 2] << 8)) << "\n";
+                i += 2;
                 break;
+            case POP_OP:
+            case ADD_OP:
+            case SUB_OP:
+            case MUL_OP:
+            case DIV_OP:
+            case MOD_OP:
+            case BIT_AND_OP:
+            case BIT_OR_OP:
+            case BIT_XOR_OP:
+            case SHL_OP:
+            case SHR_OP:
+            case EQUAL_OP:
+            case NOT_EQUAL_OP:
+            case LESS_OP:
+            case LESS_EQUAL_OP:
+            case GREATER_OP:
+            case GREATER_EQUAL_OP:
+            case NEGATE_OP:
+            case NOT_OP:
+            case BIT_NOT_OP:
+            {
+                constexpr std::string_view names[] = {
+                    "POP_OP", "ADD_OP", "SUB_OP", "MUL_OP", "DIV_OP", "MOD_OP", "BIT_AND_OP", "BIT_OR_OP", "BIT_XOR_OP",
+                    "SHL_OP", "SHR_OP", "EQUAL_OP", "NOT_EQUAL_OP", "LESS_OP", "LESS_EQUAL_OP", "GREATER_OP",
+                    "GREATER_EQUAL_OP", "NEGATE_OP", "NOT_OP", "BIT_NOT_OP"};
+                result << std::setfill('0') << std::setw(8) << i << "     "
+                       << names[m_Codes[i] - POP_OP] << "\n";
+                break;
+            }
+            case DEFINE_GLOBAL_OP:
+            case GET_GLOBAL_OP:
+            case SET_GLOBAL_OP:
+            {
+                constexpr std::string_view names[] = {"DEFINE_GLOBAL_OP", "GET_GLOBAL_OP", "SET_GLOBAL_OP"};
+                uint32_t symbol = 0;
+                for (int j = 0; j < 4; ++j)
+                    symbol |= (uint32_t)m_Codes[i + 1 + j] << (j * 8);
+                result << std::setfill('0') << std::setw(8) << i << "     "
+                       << names[m_Codes[i] - DEFINE_GLOBAL_OP]
+                       << "     " << std::to_string(symbol) << "     " << GetSymbolTable().GetName(symbol) << "\n";
+                i += 4;
+                break;
+            }
+            case FLOAT_NUM_LONG_OP:
+            case INT_NUM_LONG_OP:
+            case STR_LONG_OP:
+            {
+                constexpr std::string_view names[] = {"FLOAT_NUM_LONG_OP", "INT_NUM_LONG_OP", "STR_LONG_OP"};
+                uint8_t code = m_Codes[i] - FLOAT_NUM_LONG_OP;
+                const uint8_t *operand = m_Codes.data() + i + 1;
+                uint64_t index = ReadLeb128(operand);
+                result << std::setfill('0') << std::setw(8) << i << "     "
+                       << names[code]
+                       << "     " << std::to_string(index) << "     " << StringifyConstant(FLOAT_NUM_OP + code, index) << "\n";
+                i = operand - m_Codes.data() - 1;
+                break;
+            }
             default:
                 result << std::setfill('0') << std::setw(8) << i << "     "
                        << "Unknown Op\n";
@@ -70,4 +219,17 @@ namespace NajaLang
         }
         return result.str();
     }
+
+    std::string Chunk::StringifyConstant(uint8_t code, uint64_t index) const
+    {
+        switch (code)
+        {
+        case FLOAT_NUM_OP:
+            return std::to_string(m_Floats[index]);
+        case INT_NUM_OP:
+            return std::to_string(m_Ints[index].AsInt());
+        default:
+            return m_Strs[index]->value;
+        }
+    }
 }
\ No newline at end of file
@@ -1,18 +1,80 @@
 #pragma once 
 #include <cstdint>
 #include <vector>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include "Object.h"
+#include "Value.h"
 namespace NajaLang
 {
     enum OpCode
     {
+        // followed by a one byte index into the constants of their type
         FLOAT_NUM_OP,
         INT_NUM_OP,
+        STR_OP,
         RETURN_OP,
         TRUE_OP,
         FALSE_OP,
         NULL_OP,
+        // ints without a pool entry:PUSH_SMALL_INT_OP is followed by a signed byte,PUSH_SMALL_INT_16_OP by a signed
+        // little endian 16 bit value
+        PUSH_ZERO_OP,
+        PUSH_ONE_OP,
+        PUSH_SMALL_INT_OP,
+        PUSH_SMALL_INT_16_OP,
+        POP_OP,
+
+        // binary ops pop the right and then the left operand and push the result
+        ADD_OP,
+        SUB_OP,
+        MUL_OP,
+        DIV_OP,
+        MOD_OP,
+        BIT_AND_OP,
+        BIT_OR_OP,
+        BIT_XOR_OP,
+        SHL_OP,
+        SHR_OP,
+        EQUAL_OP,
+        NOT_EQUAL_OP,
+        LESS_OP,
+        LESS_EQUAL_OP,
+        GREATER_OP,
+        GREATER_EQUAL_OP,
+
+        NEGATE_OP,
+        NOT_OP,
+        BIT_NOT_OP,
+
+        // followed by a 4 byte little endian symbol,SET_GLOBAL_OP leaves the assigned value on the stack
+        DEFINE_GLOBAL_OP,
+        GET_GLOBAL_OP,
+        SET_GLOBAL_OP,
+
+        // the constant ops above with an unsigned LEB128 index,for constants past the first 256 of a type
+        FLOAT_NUM_LONG_OP,
+        INT_NUM_LONG_OP,
+        STR_LONG_OP,
+    };
+
+    // reads an unsigned LEB128 operand and moves ip behind it
+    inline uint64_t ReadLeb128(const uint8_t *&ip)
+    {
+        uint64_t value = *ip & 0x7F;
+        for (uint32_t shift = 7; *ip++ & 0x80; shift += 7)
+            value |= (uint64_t)(*ip & 0x7F) << shift;
+        return value;
+    }
+
+    // the constants of a Chunk as the VM reads them,one contiguous array per type indexed by the operand
+    struct ConstantPool
+    {
+        const Value *ints; // ints outside the small int range are boxed once by the Chunk
+        const double *floats;
+        const std::unique_ptr<StrObject> *strs;
     };
 
     class Chunk
@@ -21,13 +83,42 @@ namespace NajaLang
             Chunk();
             ~Chunk();
 
+            // owns the string and boxed int constants,so it moves but does not copy
+            Chunk(Chunk&&) = default;
+            Chunk& operator=(Chunk&&) = default;
+
             void AddOpCode(uint8_t code);
-            uint64_t AddObject(Object* object);
+            // constants are deduplicated per type,a value that is already in the pool keeps its first index.
+            // Floats compare by bits,so 0.0 and -0.0 stay apart
+            uint32_t AddInt(int64_t value);
+            uint32_t AddFloat(double value);
+            uint32_t AddStr(std::string_view value);
+            // FLOAT_NUM_OP,INT_NUM_OP or STR_OP,switched to its _LONG variant when index does not fit a byte
+            void AddConstantOpCode(OpCode code, uint32_t index);
+            void AddSymbol(uint32_t symbol);
+            // set by the Compiler when it could not lower part of the source,the VM refuses to run such a chunk
+            void MarkIncomplete() { m_Complete = false; }
+            bool IsComplete() const { return m_Complete; }
 
-            std::string Stringify();
+            std::string Stringify() const;
+
+            const std::vector<uint8_t>& GetCodes() const { return m_Codes; }
+            ConstantPool GetConstantPool() const { return {m_Ints.data(), m_Floats.data(), m_Strs.data()}; }
+            uint64_t GetConstantCount() const { return m_Ints.size() + m_Floats.size() + m_Strs.size(); }
         private:
+            void AddLeb128(uint64_t value);
+            std::string StringifyConstant(uint8_t code, uint64_t index) const;
+
             std::vector<uint8_t> m_Codes;
-            std::vector<Object*> m_Objects;
+            bool m_Complete = true;
+
+            std::vector<Value> m_Ints;
+            std::vector<std::unique_ptr<IntNumObject>> m_WideInts; // the boxes m_Ints points at
+            std::vector<double> m_Floats;
+            std::vector<std::unique_ptr<StrObject>> m_Strs;
+            std::unordered_map<int64_t, uint32_t> m_IntIndices;
+            std::unordered_map<uint64_t, uint32_t> m_FloatIndices; // by bits
+            std::unordered_map<std::string_view, uint32_t> m_StrIndices; // views into m_Strs
     };
 
 } // namespace NajaLang
@@ -1,8 +1,74 @@
 #include "Compiler.h"
+#include <iostream>
 #include "Object.h"
-#include "Constant.h"
 namespace NajaLang
 {
+    //the nodes neither walk lowers yet,as named in an unsupported construct error
+    static std::string_view GetConstructName(AstType type)
+    {
+        switch (type)
+        {
+        case THIS_EXPR:
+            return "'this'";
+        case BASE_EXPR:
+            return "'base'";
+        case FUNCTION_EXPR:
+            return "function expression";
+        case ARRAY_EXPR:
+            return "array literal";
+        case TABLE_EXPR:
+            return "table literal";
+        case TERNARY_EXPR:
+            return "ternary expression";
+        case INDEX_EXPR:
+            return "index expression";
+        case FUNCTION_CALL_EXPR:
+            return "function call";
+        case CLASS_CALL_EXPR:
+            return "member access";
+        case NEW_EXPR:
+            return "'new' expression";
+        case IF_STMT:
+            return "if statement";
+        case SCOPE_STMT:
+            return "block";
+        case WHILE_STMT:
+            return "while statement";
+        case BREAK_STMT:
+            return "'break'";
+        case CONTINUE_STMT:
+            return "'continue'";
+        case FUNCTION_STMT:
+            return "function declaration";
+        case CLASS_STMT:
+            return "class declaration";
+        default:
+            return "nested statement list";
+        }
+    }
+
+    constexpr std::array<OpCode, OPERATOR_COUNT> Compiler::m_BinaryOpCodes = []
+    {
+        std::array<OpCode, OPERATOR_COUNT> table{}; // only read for binary and compound assignment operators
+        table[OPERATOR_ADD_ASSIGN] = table[OPERATOR_ADD] = ADD_OP;
+        table[OPERATOR_SUB_ASSIGN] = table[OPERATOR_SUB] = SUB_OP;
+        table[OPERATOR_MUL_ASSIGN] = table[OPERATOR_MUL] = MUL_OP;
+        table[OPERATOR_DIV_ASSIGN] = table[OPERATOR_DIV] = DIV_OP;
+        table[OPERATOR_MOD_ASSIGN] = table[OPERATOR_MOD] = MOD_OP;
+        table[OPERATOR_BIT_AND_ASSIGN] = table[OPERATOR_BIT_AND] = BIT_AND_OP;
+        table[OPERATOR_BIT_OR_ASSIGN] = table[OPERATOR_BIT_OR] = BIT_OR_OP;
+        table[OPERATOR_BIT_XOR_ASSIGN] = table[OPERATOR_BIT_XOR] = BIT_XOR_OP;
+        table[OPERATOR_SHL_ASSIGN] = table[OPERATOR_SHL] = SHL_OP;
+        table[OPERATOR_SHR_ASSIGN] = table[OPERATOR_SHR] = SHR_OP;
+        table[OPERATOR_EQUAL] = EQUAL_OP;
+        table[OPERATOR_NOT_EQUAL] = NOT_EQUAL_OP;
+        table[OPERATOR_LESS] = LESS_OP;
+        table[OPERATOR_LESS_EQUAL] = LESS_EQUAL_OP;
+        table[OPERATOR_GREATER] = GREATER_OP;
+        table[OPERATOR_GREATER_EQUAL] = GREATER_EQUAL_OP;
+        return table;
+    }();
+
     Compiler::Compiler()
     {
     }
@@ -10,96 +76,395 @@ namespace NajaLang
     {
     }
 
+    //every chunk ends in RETURN_OP,so the VM can run it without checking for the end of the code
     const Chunk &Compiler::Compile(Stmt *stmt)
     {
-        CompileAstStmts((AstStmts *)stmt);
+        m_Chunk = Chunk();
+        m_ErrorMsgs.clear();
+        Visit(stmt);
+        m_Chunk.AddOpCode(RETURN_OP);
         return m_Chunk;
     }
 
-    void Compiler::CompileAstStmts(AstStmts *stmt)
+    const Chunk &Compiler::Compile(const FlatAst &ast)
+    {
+        m_Chunk = Chunk();
+        m_ErrorMsgs.clear();
+        const FlatNode &root = ast.GetNode(ast.GetRoot());
+        for (auto stmt : ast.GetList(root.a, root.b))
+            CompileFlatStmt(ast, stmt);
+        m_Chunk.AddOpCode(RETURN_OP);
+        return m_Chunk;
+    }
+
+    bool Compiler::HasError() const
+    {
+        return !m_ErrorMsgs.empty();
+    }
+
+    const std::vector<std::string> &Compiler::GetErrors() const
+    {
+        return m_ErrorMsgs;
+    }
+
+    void Compiler::PrintErrors()
+    {
+        std::cout << "Compile Error:" << std::endl;
+        for (const auto &err : m_ErrorMsgs)
+            std::cout << err << std::endl;
+    }
+
+    void Compiler::VisitAstStmts(AstStmts *stmt)
     {
         for (const auto &s : stmt->stmts)
-            CompileStmt(s);
+            Visit(s);
+    }
+
+    void Compiler::VisitReturnStmt(ReturnStmt *stmt)
+    {
+        if (stmt->expr)
+            Visit(stmt->expr);
+        m_Chunk.AddOpCode(RETURN_OP);
+    }
+
+    void Compiler::VisitExprStmt(ExprStmt *stmt)
+    {
+        Visit(stmt->expr);
+        m_Chunk.AddOpCode(POP_OP);
     }
 
-    void Compiler::CompileStmt(Stmt *stmt)
+    void Compiler::VisitVarStmt(VarStmt *stmt)
     {
-        switch (stmt->Type())
+        for (const auto &[name, value] : stmt->variables)
         {
-        case RETURN_STMT:
-            CompileReturnStmt((ReturnStmt *)stmt);
-            break;
-        default:
-            break;
+            Visit(value);
+            EmitGlobal(DEFINE_GLOBAL_OP, name->symbol);
         }
     }
-    void Compiler::CompileReturnStmt(ReturnStmt *stmt)
+
+    void Compiler::DefaultExpr(Expr *expr)
     {
-        if (stmt->expr)
-            CompileExpr(stmt->expr);
-        m_Chunk.AddOpCode(RETURN_OP);
+        UnsupportedError(expr->Type());
+    }
+
+    void Compiler::DefaultStmt(Stmt *stmt)
+    {
+        UnsupportedError(stmt->Type());
+    }
+
+    void Compiler::VisitFloatNumExpr(FloatNumExpr *expr)
+    {
+        EmitFloatNum(expr->value);
+    }
+
+    void Compiler::VisitIntNumExpr(IntNumExpr *expr)
+    {
+        EmitIntNum(expr->value);
+    }
+
+    void Compiler::VisitStrExpr(StrExpr *expr)
+    {
+        EmitStr(expr->value);
+    }
+
+    void Compiler::VisitTrueExpr(TrueExpr *)
+    {
+        m_Chunk.AddOpCode(TRUE_OP);
+    }
+    void Compiler::VisitFalseExpr(FalseExpr *)
+    {
+        m_Chunk.AddOpCode(FALSE_OP);
+    }
+    void Compiler::VisitNullExpr(NullExpr *)
+    {
+        m_Chunk.AddOpCode(NULL_OP);
+    }
+
+    void Compiler::VisitIdentifierExpr(IdentifierExpr *expr)
+    {
+        EmitGlobal(GET_GLOBAL_OP, expr->symbol);
+    }
+
+    void Compiler::VisitGroupExpr(GroupExpr *expr)
+    {
+        Visit(expr->expr);
+    }
+
+    void Compiler::VisitPrefixExpr(PrefixExpr *expr)
+    {
+        EmitPrefix(expr->op, GetTarget(expr->right), [&]()
+                   { Visit(expr->right); });
     }
 
-    void Compiler::CompileExprStmt(ExprStmt *stmt)
+    void Compiler::VisitInfixExpr(InfixExpr *expr)
     {
-        CompileExpr(stmt->expr);
+        EmitInfix(
+            expr->op, GetTarget(expr->left), [&]()
+            { Visit(expr->left); },
+            [&]()
+            { Visit(expr->right); });
     }
 
-    void Compiler::CompileExpr(Expr *expr)
+    void Compiler::VisitPostfixExpr(PostfixExpr *expr)
     {
-        switch (expr->Type())
+        EmitPostfix(expr->op, GetTarget(expr->left));
+    }
+
+    void Compiler::CompileFlatStmt(const FlatAst &ast, uint32_t index)
+    {
+        const FlatNode &node = ast.GetNode(index);
+        switch (node.tag)
+        {
+        case RETURN_STMT:
+            if (node.a != FlatAst::INVALID_INDEX)
+                CompileFlatExpr(ast, node.a);
+            m_Chunk.AddOpCode(RETURN_OP);
+            break;
+        case EXPR_STMT:
+            CompileFlatExpr(ast, node.a);
+            m_Chunk.AddOpCode(POP_OP);
+            break;
+        case VAR_STMT:
+        {
+            auto pairs = ast.GetList(node.a, node.b * 2);
+            for (uint32_t i = 0; i < pairs.size(); i += 2)
+            {
+                CompileFlatExpr(ast, pairs[i + 1]);
+                EmitGlobal(DEFINE_GLOBAL_OP, ast.GetNode(pairs[i]).a);
+            }
+            break;
+        }
+        default:
+            UnsupportedError((AstType)node.tag);
+            break;
+        }
+    }
+
+    void Compiler::CompileFlatExpr(const FlatAst &ast, uint32_t index)
+    {
+        const FlatNode &node = ast.GetNode(index);
+        switch (node.tag)
         {
         case FLOAT_NUM_EXPR:
-            CompileFloatNumExpr((FloatNumExpr *)expr);
+            EmitFloatNum(ast.GetFloat(index));
             break;
         case INT_NUM_EXPR:
-            CompileIntNumExpr((IntNumExpr *)expr);
+            EmitIntNum(ast.GetInt(index));
+            break;
+        case STR_EXPR:
+            EmitStr(ast.GetStr(index));
             break;
         case TRUE_EXPR:
-            CompileTrueExpr((TrueExpr*)expr);
+            m_Chunk.AddOpCode(TRUE_OP);
             break;
         case FALSE_EXPR:
-            CompileFalseExpr((FalseExpr*)expr);
+            m_Chunk.AddOpCode(FALSE_OP);
             break;
         case NULL_EXPR:
-            CompileNullExpr((NullExpr*)expr);
+            m_Chunk.AddOpCode(NULL_OP);
+            break;
+        case IDENTIFIER_EXPR:
+            EmitGlobal(GET_GLOBAL_OP, node.a);
+            break;
+        case GROUP_EXPR:
+            CompileFlatExpr(ast, node.a);
+            break;
+        case PREFIX_EXPR:
+            EmitPrefix(ast.GetOp(index), GetTarget(ast, node.a), [&]()
+                       { CompileFlatExpr(ast, node.a); });
+            break;
+        case INFIX_EXPR:
+            EmitInfix(
+                ast.GetOp(index), GetTarget(ast, node.a), [&]()
+                { CompileFlatExpr(ast, node.a); },
+                [&]()
+                { CompileFlatExpr(ast, node.b); });
+            break;
+        case POSTFIX_EXPR:
+            EmitPostfix(ast.GetOp(index), GetTarget(ast, node.a));
             break;
         default:
+            UnsupportedError((AstType)node.tag);
             break;
         }
     }
 
-    void Compiler::CompileFloatNumExpr(FloatNumExpr *expr)
+    uint32_t Compiler::GetTarget(Expr *expr)
     {
-        m_Chunk.AddOpCode(FLOAT_NUM_OP);
-        size_t offset = m_Chunk.AddObject(new FloatNumObject(expr->value));
-        m_Chunk.AddOpCode(offset);
+        auto identifier = AstCast<IdentifierExpr>(expr);
+        return identifier ? identifier->symbol : NO_TARGET;
     }
 
-    void Compiler::CompileIntNumExpr(IntNumExpr *expr)
+    uint32_t Compiler::GetTarget(const FlatAst &ast, uint32_t index)
     {
-        m_Chunk.AddOpCode(INT_NUM_OP);
-        uint64_t offset = m_Chunk.AddObject(new IntNumObject(expr->value));
-        m_Chunk.AddOpCode(offset);
+        return ast.GetTag(index) == IDENTIFIER_EXPR ? ast.GetNode(index).a : NO_TARGET;
     }
 
-    void Compiler::CompileTrueExpr(TrueExpr *expr)
+    //assignments only lower for plain names so far,other targets and '&&'/'||'(which need jumps) are reported
+    template <typename LeftFn, typename RightFn>
+    void Compiler::EmitInfix(Operator op, uint32_t target, LeftFn &&compileLeft, RightFn &&compileRight)
     {
-         m_Chunk.AddOpCode(TRUE_OP);
-        uint64_t offset = m_Chunk.AddObject(trueObject);
-        m_Chunk.AddOpCode(offset);
+        switch (op)
+        {
+        case OPERATOR_ASSIGN:
+            if (target == NO_TARGET)
+            {
+                UnsupportedError("assignment to a target other than a variable");
+                break;
+            }
+            compileRight();
+            EmitGlobal(SET_GLOBAL_OP, target);
+            break;
+        case OPERATOR_ADD_ASSIGN:
+        case OPERATOR_SUB_ASSIGN:
+        case OPERATOR_MUL_ASSIGN:
+        case OPERATOR_DIV_ASSIGN:
+        case OPERATOR_MOD_ASSIGN:
+        case OPERATOR_BIT_AND_ASSIGN:
+        case OPERATOR_BIT_OR_ASSIGN:
+        case OPERATOR_BIT_XOR_ASSIGN:
+        case OPERATOR_SHL_ASSIGN:
+        case OPERATOR_SHR_ASSIGN:
+            if (target == NO_TARGET)
+            {
+                UnsupportedError("compound assignment to a target other than a variable");
+                break;
+            }
+            EmitGlobal(GET_GLOBAL_OP, target);
+            compileRight();
+            m_Chunk.AddOpCode(m_BinaryOpCodes[op]);
+            EmitGlobal(SET_GLOBAL_OP, target);
+            break;
+        case OPERATOR_BIT_OR:
+        case OPERATOR_BIT_XOR:
+        case OPERATOR_BIT_AND:
+        case OPERATOR_EQUAL:
+        case OPERATOR_NOT_EQUAL:
+        case OPERATOR_LESS:
+        case OPERATOR_LESS_EQUAL:
+        case OPERATOR_GREATER:
+        case OPERATOR_GREATER_EQUAL:
+        case OPERATOR_SHL:
+        case OPERATOR_SHR:
+        case OPERATOR_ADD:
+        case OPERATOR_SUB:
+        case OPERATOR_MUL:
+        case OPERATOR_DIV:
+        case OPERATOR_MOD:
+            compileLeft();
+            compileRight();
+            m_Chunk.AddOpCode(m_BinaryOpCodes[op]);
+            break;
+        default:
+            UnsupportedError("operator '" + std::string(GetOperatorLiteral(op)) + "'");
+            break;
+        }
     }
-    void Compiler::CompileFalseExpr(FalseExpr *expr)
+
+    template <typename OperandFn>
+    void Compiler::EmitPrefix(Operator op, uint32_t target, OperandFn &&compileOperand)
     {
-         m_Chunk.AddOpCode(FALSE_OP);
-        uint64_t offset = m_Chunk.AddObject(falseObject);
-        m_Chunk.AddOpCode(offset);
+        switch (op)
+        {
+        case OPERATOR_NEGATE:
+            compileOperand();
+            m_Chunk.AddOpCode(NEGATE_OP);
+            break;
+        case OPERATOR_NOT:
+            compileOperand();
+            m_Chunk.AddOpCode(NOT_OP);
+            break;
+        case OPERATOR_BIT_NOT:
+            compileOperand();
+            m_Chunk.AddOpCode(BIT_NOT_OP);
+            break;
+        case OPERATOR_INCREMENT:
+        case OPERATOR_DECREMENT:
+            if (target == NO_TARGET)
+            {
+                UnsupportedError("'" + std::string(GetOperatorLiteral(op)) + "' on a target other than a variable");
+                break;
+            }
+            EmitGlobal(GET_GLOBAL_OP, target);
+            EmitIntNum(1);
+            m_Chunk.AddOpCode(op == OPERATOR_INCREMENT ? ADD_OP : SUB_OP);
+            EmitGlobal(SET_GLOBAL_OP, target);
+            break;
+        default:
+            UnsupportedError("prefix operator '" + std::string(GetOperatorLiteral(op)) + "'");
+            break;
+        }
+    }
+
+    //leaves the old value:the variable is read twice and the updated copy is dropped after the store
+    void Compiler::EmitPostfix(Operator op, uint32_t target)
+    {
+        if (op != OPERATOR_INCREMENT && op != OPERATOR_DECREMENT)
+        {
+            UnsupportedError("postfix operator '" + std::string(GetOperatorLiteral(op)) + "'");
+            return;
+        }
+        if (target == NO_TARGET)
+        {
+            UnsupportedError("'" + std::string(GetOperatorLiteral(op)) + "' on a target other than a variable");
+            return;
+        }
+        EmitGlobal(GET_GLOBAL_OP, target);
+        EmitGlobal(GET_GLOBAL_OP, target);
+        EmitIntNum(1);
+        m_Chunk.AddOpCode(op == OPERATOR_INCREMENT ? ADD_OP : SUB_OP);
+        EmitGlobal(SET_GLOBAL_OP, target);
+        m_Chunk.AddOpCode(POP_OP);
+    }
+
+    void Compiler::EmitFloatNum(double value)
+    {
+        m_Chunk.AddConstantOpCode(FLOAT_NUM_OP, m_Chunk.AddFloat(value));
+    }
+
+    //ints that fit 16 bits are immediates,only wider ones go through the pool
+    void Compiler::EmitIntNum(int64_t value)
+    {
+        if (value == 0)
+            m_Chunk.AddOpCode(PUSH_ZERO_OP);
+        else if (value == 1)
+            m_Chunk.AddOpCode(PUSH_ONE_OP);
+        else if (value >= INT8_MIN && value <= INT8_MAX)
+        {
+            m_Chunk.AddOpCode(PUSH_SMALL_INT_OP);
+            m_Chunk.AddOpCode((uint8_t)value);
+        }
+        else if (value >= INT16_MIN && value <= INT16_MAX)
+        {
+            m_Chunk.AddOpCode(PUSH_SMALL_INT_16_OP);
+            m_Chunk.AddOpCode((uint8_t)value);
+            m_Chunk.AddOpCode((uint8_t)(value >> 8));
+        }
+        else
+            m_Chunk.AddConstantOpCode(INT_NUM_OP, m_Chunk.AddInt(value));
+    }
+
+    void Compiler::EmitStr(std::string_view value)
+    {
+        m_Chunk.AddConstantOpCode(STR_OP, m_Chunk.AddStr(value));
+    }
+
+    void Compiler::EmitGlobal(OpCode op, uint32_t symbol)
+    {
+        m_Chunk.AddOpCode(op);
+        m_Chunk.AddSymbol(symbol);
     }
-    void Compiler::CompileNullExpr(NullExpr *expr)
+
+    //no code is emitted for the construct,so the chunk is only good for printing once there is an error
+    void Compiler::UnsupportedError(std::string_view construct)
+    {
+        m_Chunk.MarkIncomplete();
+        m_ErrorMsgs.emplace_back("Unsupported construct:" + std::string(construct) + ".");
+    }
+
+    void Compiler::UnsupportedError(AstType type)
     {
-          m_Chunk.AddOpCode(NULL_OP);
-        uint64_t offset = m_Chunk.AddObject(nullObject);
-        m_Chunk.AddOpCode(offset);
+        UnsupportedError(GetConstructName(type));
     }
 
-}
\ No newline at end of file
+}
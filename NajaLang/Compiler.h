@@ -1,29 +1,79 @@
 #pragma once
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
 #include "Ast.h"
+#include "AstVisitor.h"
+#include "FlatAst.h"
 #include "Chunk.h"
 namespace NajaLang
 {
 
-    class Compiler
+    class Compiler : public AstVisitor<Compiler>
     {
     public:
         Compiler();
         ~Compiler();
 
         const Chunk& Compile(Stmt* stmt);
+        // emits the same code as the tree version,dispatching on the node tags without virtual calls
+        const Chunk& Compile(const FlatAst& ast);
+
+        // constructs the last Compile could not lower yet,its chunk is incomplete while there are any
+        bool HasError() const;
+        const std::vector<std::string>& GetErrors() const;
+        void PrintErrors();
     private:
-        void CompileAstStmts(AstStmts* stmt);
-        void CompileStmt(Stmt* stmt);
-        void CompileReturnStmt(ReturnStmt* stmt);
-        void CompileExprStmt(ExprStmt* stmt);
-
-        void CompileExpr(Expr* expr);
-        void CompileFloatNumExpr(FloatNumExpr* expr);
-        void CompileIntNumExpr(IntNumExpr* expr);
-        void CompileTrueExpr(TrueExpr* expr);
-        void CompileFalseExpr(FalseExpr* expr);
-        void CompileNullExpr(NullExpr* expr);
+        friend class AstVisitor<Compiler>;
+
+        // handlers of the tree walk,nodes without one are reported as unsupported
+        void DefaultExpr(Expr* expr);
+        void DefaultStmt(Stmt* stmt);
+        void VisitAstStmts(AstStmts* stmt);
+        void VisitReturnStmt(ReturnStmt* stmt);
+        void VisitExprStmt(ExprStmt* stmt);
+        void VisitVarStmt(VarStmt* stmt);
+
+        void VisitFloatNumExpr(FloatNumExpr* expr);
+        void VisitIntNumExpr(IntNumExpr* expr);
+        void VisitStrExpr(StrExpr* expr);
+        void VisitTrueExpr(TrueExpr* expr);
+        void VisitFalseExpr(FalseExpr* expr);
+        void VisitNullExpr(NullExpr* expr);
+        void VisitIdentifierExpr(IdentifierExpr* expr);
+        void VisitGroupExpr(GroupExpr* expr);
+        void VisitPrefixExpr(PrefixExpr* expr);
+        void VisitInfixExpr(InfixExpr* expr);
+        void VisitPostfixExpr(PostfixExpr* expr);
+
+        void CompileFlatStmt(const FlatAst& ast, uint32_t index);
+        void CompileFlatExpr(const FlatAst& ast, uint32_t index);
+
+        // symbol of the variable an expression names,NO_TARGET if it is not a plain identifier
+        static constexpr uint32_t NO_TARGET = UINT32_MAX;
+        static uint32_t GetTarget(Expr* expr);
+        static uint32_t GetTarget(const FlatAst& ast, uint32_t index);
+
+        // operator lowering shared by both walks,operands are compiled through the passed callables
+        template <typename LeftFn, typename RightFn>
+        void EmitInfix(Operator op, uint32_t target, LeftFn&& compileLeft, RightFn&& compileRight);
+        template <typename OperandFn>
+        void EmitPrefix(Operator op, uint32_t target, OperandFn&& compileOperand);
+        void EmitPostfix(Operator op, uint32_t target);
+
+        void EmitFloatNum(double value);
+        void EmitIntNum(int64_t value);
+        void EmitStr(std::string_view value);
+        void EmitGlobal(OpCode op, uint32_t symbol);
+
+        void UnsupportedError(std::string_view construct);
+        void UnsupportedError(AstType type);
+
+        // opcode of a binary operator,compound assignments map to the operation they apply
+        static const std::array<OpCode, OPERATOR_COUNT> m_BinaryOpCodes;
 
         Chunk m_Chunk;
+        std::vector<std::string> m_ErrorMsgs;
     };
-}
\ No newline at end of file
+}
@@ -1,6 +1,5 @@
 #pragma once
 #include "Ast.h"
-#include "Object.h"
 namespace NajaLang
 {
     static NullExpr *nullExpr = new NullExpr();
@@ -8,8 +7,4 @@ namespace NajaLang
     static FalseExpr *falseExpr = new FalseExpr();
     static ThisExpr *thisExpr = new ThisExpr();
     static BaseExpr *baseExpr = new BaseExpr();
-
-    static TrueObject *trueObject = new TrueObject();
-    static FalseObject *falseObject = new FalseObject();
-    static NullObject *nullObject = new NullObject();
 }
\ No newline at end of file
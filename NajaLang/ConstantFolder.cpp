@@ -0,0 +1,512 @@
+#include "ConstantFolder.h"
+#include <cmath>
+#include "Constant.h"
+namespace NajaLang
+{
+	ConstantFolder::ConstantFolder()
+		: m_FoldCount(0)
+	{
+	}
+	ConstantFolder::~ConstantFolder()
+	{
+	}
+
+	Stmt *ConstantFolder::Fold(Stmt *stmt)
+	{
+		m_Arena.Reset();
+		m_FoldCount = 0;
+		return Visit(stmt);
+	}
+
+	uint64_t ConstantFolder::GetFoldCount() const
+	{
+		return m_FoldCount;
+	}
+
+	Expr *ConstantFolder::VisitGroupExpr(GroupExpr *expr)
+	{
+		expr->expr = Visit(expr->expr);
+		//(1+2)*x becomes 3*x,groups around anything else are kept for the printed form
+		if (GetConstant(expr->expr).kind != CONSTANT_NONE)
+		{
+			m_FoldCount++;
+			return expr->expr;
+		}
+		return expr;
+	}
+
+	Expr *ConstantFolder::VisitFunctionExpr(FunctionExpr *expr)
+	{
+		if (expr->body) //a skipped lazy body is folded once it is parsed
+			expr->body = (ScopeStmt *)Visit(expr->body);
+		return expr;
+	}
+
+	Expr *ConstantFolder::VisitArrayExpr(ArrayExpr *expr)
+	{
+		for (auto &e : expr->elements)
+			e = Visit(e);
+		return expr;
+	}
+
+	Expr *ConstantFolder::VisitTableExpr(TableExpr *expr)
+	{
+		//keys are part of the map's ordering,so the pairs are inserted again
+		std::vector<std::pair<Expr *, Expr *>> pairs(expr->elements.begin(), expr->elements.end());
+		expr->elements.clear();
+		for (auto [key, value] : pairs)
+		{
+			Expr *k = Visit(key);
+			expr->elements.emplace(k, Visit(value));
+		}
+		return expr;
+	}
+
+	Expr *ConstantFolder::VisitPrefixExpr(PrefixExpr *expr)
+	{
+		expr->right = Visit(expr->right);
+
+		Constant result;
+		if (!FoldPrefix(expr->op, GetConstant(expr->right), result))
+			return expr;
+		m_FoldCount++;
+		return MakeExpr(result);
+	}
+
+	Expr *ConstantFolder::VisitInfixExpr(InfixExpr *expr)
+	{
+		expr->left = Visit(expr->left);
+		expr->right = Visit(expr->right);
+
+		Constant result;
+		if (FoldInfix(expr->op, GetConstant(expr->left), GetConstant(expr->right), result))
+		{
+			m_FoldCount++;
+			return MakeExpr(result);
+		}
+		if (Expr *operand = FoldIdentity(expr))
+		{
+			m_FoldCount++;
+			return operand;
+		}
+		return expr;
+	}
+
+	Expr *ConstantFolder::VisitPostfixExpr(PostfixExpr *expr)
+	{
+		expr->left = Visit(expr->left);
+		return expr;
+	}
+
+	Expr *ConstantFolder::VisitTernaryExpr(TernaryExpr *expr)
+	{
+		expr->condition = Visit(expr->condition);
+		expr->trueBranch = Visit(expr->trueBranch);
+		expr->falseBranch = Visit(expr->falseBranch);
+
+		Constant condition = GetConstant(expr->condition);
+		if (condition.kind != CONSTANT_BOOL)
+			return expr;
+		m_FoldCount++;
+		return condition.boolValue ? expr->trueBranch : expr->falseBranch;
+	}
+
+	Expr *ConstantFolder::VisitIndexExpr(IndexExpr *expr)
+	{
+		expr->array = Visit(expr->array);
+		expr->index = Visit(expr->index);
+		return expr;
+	}
+
+	Expr *ConstantFolder::VisitFunctionCallExpr(FunctionCallExpr *expr)
+	{
+		expr->function = Visit(expr->function);
+		for (auto &arg : expr->arguments)
+			arg = Visit(arg);
+		return expr;
+	}
+
+	Expr *ConstantFolder::VisitClassCallExpr(ClassCallExpr *expr)
+	{
+		expr->classInstance = Visit(expr->classInstance);
+		expr->callee = Visit(expr->callee);
+		return expr;
+	}
+
+	Expr *ConstantFolder::VisitNewExpr(NewExpr *expr)
+	{
+		expr->object = Visit(expr->object);
+		return expr;
+	}
+
+	Stmt *ConstantFolder::VisitVarStmt(VarStmt *stmt)
+	{
+		for (auto &[name, value] : stmt->variables)
+			value = Visit(value);
+		return stmt;
+	}
+
+	Stmt *ConstantFolder::VisitExprStmt(ExprStmt *stmt)
+	{
+		stmt->expr = Visit(stmt->expr);
+		return stmt;
+	}
+
+	Stmt *ConstantFolder::VisitReturnStmt(ReturnStmt *stmt)
+	{
+		if (stmt->expr)
+			stmt->expr = Visit(stmt->expr);
+		return stmt;
+	}
+
+	Stmt *ConstantFolder::VisitIfStmt(IfStmt *stmt)
+	{
+		stmt->condition = Visit(stmt->condition);
+		Stmt *thenBranch = Visit(stmt->thenBranch);
+		Stmt *elseBranch = stmt->elseBranch ? Visit(stmt->elseBranch) : nullptr;
+
+		Constant condition = GetConstant(stmt->condition);
+		if (condition.kind == CONSTANT_BOOL)
+		{
+			//the branch that runs takes the if's place,an if whose only branch never runs goes away
+			m_FoldCount++;
+			return condition.boolValue ? FoldBranch(thenBranch) : elseBranch;
+		}
+		stmt->thenBranch = FoldBranch(thenBranch);
+		stmt->elseBranch = elseBranch;
+		return stmt;
+	}
+
+	Stmt *ConstantFolder::VisitScopeStmt(ScopeStmt *stmt)
+	{
+		FoldStmts(stmt->stmts);
+		return stmt;
+	}
+
+	Stmt *ConstantFolder::VisitWhileStmt(WhileStmt *stmt)
+	{
+		stmt->condition = Visit(stmt->condition);
+		Constant condition = GetConstant(stmt->condition);
+		if (condition.kind == CONSTANT_BOOL && !condition.boolValue)
+		{
+			m_FoldCount++;
+			return nullptr;
+		}
+		stmt->stmt = FoldBranch(Visit(stmt->stmt));
+		return stmt;
+	}
+
+	Stmt *ConstantFolder::VisitFunctionStmt(FunctionStmt *stmt)
+	{
+		if (stmt->body)
+			stmt->body = (ScopeStmt *)Visit(stmt->body);
+		return stmt;
+	}
+
+	Stmt *ConstantFolder::VisitClassStmt(ClassStmt *stmt)
+	{
+		for (auto vars : {&stmt->publicVars, &stmt->protectedVars, &stmt->privateVars})
+			for (auto var : *vars)
+				Visit(var);
+		for (auto functions : {&stmt->publicFunctions, &stmt->protectedFunctions, &stmt->privateFunctions})
+			for (auto function : *functions)
+				Visit(function);
+		return stmt;
+	}
+
+	Stmt *ConstantFolder::VisitAstStmts(AstStmts *stmt)
+	{
+		FoldStmts(stmt->stmts);
+		return stmt;
+	}
+
+	void ConstantFolder::FoldStmts(std::pmr::vector<Stmt *> &stmts)
+	{
+		uint64_t count = 0;
+		for (auto s : stmts)
+			if (Stmt *folded = Visit(s))
+				stmts[count++] = folded;
+		stmts.resize(count);
+	}
+
+	Stmt *ConstantFolder::FoldBranch(Stmt *stmt)
+	{
+		return stmt ? stmt : m_Arena.New<ScopeStmt>();
+	}
+
+	ConstantFolder::Constant ConstantFolder::GetConstant(Expr *expr)
+	{
+		Constant constant;
+		switch (expr->type)
+		{
+		case INT_NUM_EXPR:
+			constant.kind = CONSTANT_INT;
+			constant.intValue = ((IntNumExpr *)expr)->value;
+			break;
+		case FLOAT_NUM_EXPR:
+			constant.kind = CONSTANT_FLOAT;
+			constant.floatValue = ((FloatNumExpr *)expr)->value;
+			break;
+		case TRUE_EXPR:
+		case FALSE_EXPR:
+			constant.kind = CONSTANT_BOOL;
+			constant.boolValue = expr->type == TRUE_EXPR;
+			break;
+		case NULL_EXPR:
+			constant.kind = CONSTANT_NULL;
+			break;
+		default:
+			break;
+		}
+		return constant;
+	}
+
+	ConstantFolder::NumberKind ConstantFolder::GetNumberKind(Expr *expr)
+	{
+		auto combine = [](NumberKind left, NumberKind right)
+		{
+			if (left == NUMBER_FLOAT || right == NUMBER_FLOAT)
+				return NUMBER_FLOAT;
+			return left == NUMBER_INT && right == NUMBER_INT ? NUMBER_INT : NUMBER_ANY;
+		};
+
+		switch (expr->type)
+		{
+		case INT_NUM_EXPR:
+			return NUMBER_INT;
+		case FLOAT_NUM_EXPR:
+			return NUMBER_FLOAT;
+		case GROUP_EXPR:
+			return GetNumberKind(((GroupExpr *)expr)->expr);
+		case PREFIX_EXPR:
+		{
+			auto prefixExpr = (PrefixExpr *)expr;
+			if (prefixExpr->op == OPERATOR_BIT_NOT)
+				return NUMBER_INT;
+			if (prefixExpr->op == OPERATOR_NEGATE)
+			{
+				NumberKind right = GetNumberKind(prefixExpr->right);
+				return right == NUMBER_UNKNOWN ? NUMBER_ANY : right;
+			}
+			return NUMBER_UNKNOWN;
+		}
+		case INFIX_EXPR:
+		{
+			auto infixExpr = (InfixExpr *)expr;
+			switch (infixExpr->op)
+			{
+			case OPERATOR_SUB:
+			case OPERATOR_MUL:
+			case OPERATOR_DIV:
+			case OPERATOR_MOD:
+				return combine(GetNumberKind(infixExpr->left), GetNumberKind(infixExpr->right));
+			case OPERATOR_ADD:
+			{
+				//'+' may not be arithmetic unless both sides are numbers
+				NumberKind left = GetNumberKind(infixExpr->left);
+				NumberKind right = GetNumberKind(infixExpr->right);
+				return left == NUMBER_UNKNOWN || right == NUMBER_UNKNOWN ? NUMBER_UNKNOWN : combine(left, right);
+			}
+			case OPERATOR_BIT_AND:
+			case OPERATOR_BIT_OR:
+			case OPERATOR_BIT_XOR:
+			case OPERATOR_SHL:
+			case OPERATOR_SHR:
+				return NUMBER_INT;
+			default:
+				return NUMBER_UNKNOWN;
+			}
+		}
+		default:
+			return NUMBER_UNKNOWN;
+		}
+	}
+
+	Expr *ConstantFolder::MakeExpr(const Constant &constant)
+	{
+		switch (constant.kind)
+		{
+		case CONSTANT_INT:
+			return m_Arena.New<IntNumExpr>(constant.intValue);
+		case CONSTANT_FLOAT:
+			return m_Arena.New<FloatNumExpr>(constant.floatValue);
+		case CONSTANT_BOOL:
+			return constant.boolValue ? (Expr *)trueExpr : (Expr *)falseExpr;
+		default:
+			return nullExpr;
+		}
+	}
+
+	bool ConstantFolder::FoldPrefix(Operator op, const Constant &right, Constant &result)
+	{
+		result.kind = right.kind;
+		switch (op)
+		{
+		case OPERATOR_NEGATE:
+			if (right.kind == CONSTANT_INT && right.intValue != INT64_MIN)
+				result.intValue = -right.intValue;
+			else if (right.kind == CONSTANT_FLOAT)
+				result.floatValue = -right.floatValue;
+			else
+				return false;
+			return true;
+		case OPERATOR_NOT:
+			result.boolValue = !right.boolValue;
+			return right.kind == CONSTANT_BOOL;
+		case OPERATOR_BIT_NOT:
+			result.intValue = ~right.intValue;
+			return right.kind == CONSTANT_INT;
+		default:
+			return false;
+		}
+	}
+
+	bool ConstantFolder::FoldInfix(Operator op, const Constant &left, const Constant &right, Constant &result)
+	{
+		bool isInt = left.kind == CONSTANT_INT && right.kind == CONSTANT_INT;
+		bool isNumber = left.IsNumber() && right.IsNumber();
+		bool isBool = left.kind == CONSTANT_BOOL && right.kind == CONSTANT_BOOL;
+
+		auto setBool = [&](bool value)
+		{
+			result.kind = CONSTANT_BOOL;
+			result.boolValue = value;
+			return true;
+		};
+		auto setInt = [&](int64_t value)
+		{
+			result.kind = CONSTANT_INT;
+			result.intValue = value;
+			return true;
+		};
+		auto setFloat = [&](double value)
+		{
+			result.kind = CONSTANT_FLOAT;
+			result.floatValue = value;
+			return true;
+		};
+
+		switch (op)
+		{
+		case OPERATOR_LOGIC_OR:
+			return isBool && setBool(left.boolValue || right.boolValue);
+		case OPERATOR_LOGIC_AND:
+			return isBool && setBool(left.boolValue && right.boolValue);
+		case OPERATOR_EQUAL:
+		case OPERATOR_NOT_EQUAL:
+		{
+			//values of different types are left to the runtime
+			bool isEqual;
+			if (isInt)
+				isEqual = left.intValue == right.intValue;
+			else if (isNumber)
+				isEqual = left.AsFloat() == right.AsFloat();
+			else if (isBool)
+				isEqual = left.boolValue == right.boolValue;
+			else if (left.kind == CONSTANT_NULL && right.kind == CONSTANT_NULL)
+				isEqual = true;
+			else
+				return false;
+			return setBool(op == OPERATOR_EQUAL ? isEqual : !isEqual);
+		}
+		case OPERATOR_LESS:
+			return isNumber && setBool(isInt ? left.intValue < right.intValue : left.AsFloat() < right.AsFloat());
+		case OPERATOR_LESS_EQUAL:
+			return isNumber && setBool(isInt ? left.intValue <= right.intValue : left.AsFloat() <= right.AsFloat());
+		case OPERATOR_GREATER:
+			return isNumber && setBool(isInt ? left.intValue > right.intValue : left.AsFloat() > right.AsFloat());
+		case OPERATOR_GREATER_EQUAL:
+			return isNumber && setBool(isInt ? left.intValue >= right.intValue : left.AsFloat() >= right.AsFloat());
+		case OPERATOR_ADD:
+		case OPERATOR_SUB:
+		case OPERATOR_MUL:
+		{
+			if (isInt)
+			{
+				//an overflowing result is the runtime's to produce
+				int64_t value;
+				bool isOverflow = op == OPERATOR_ADD   ? __builtin_add_overflow(left.intValue, right.intValue, &value)
+								  : op == OPERATOR_SUB ? __builtin_sub_overflow(left.intValue, right.intValue, &value)
+													   : __builtin_mul_overflow(left.intValue, right.intValue, &value);
+				return !isOverflow && setInt(value);
+			}
+			if (!isNumber)
+				return false;
+			double l = left.AsFloat(), r = right.AsFloat();
+			return setFloat(op == OPERATOR_ADD ? l + r : op == OPERATOR_SUB ? l - r : l * r);
+		}
+		case OPERATOR_DIV:
+		case OPERATOR_MOD:
+		{
+			//division by zero is the runtime's to report
+			if (isInt)
+			{
+				if (right.intValue == 0 || (left.intValue == INT64_MIN && right.intValue == -1))
+					return false;
+				return setInt(op == OPERATOR_DIV ? left.intValue / right.intValue : left.intValue % right.intValue);
+			}
+			if (!isNumber || right.AsFloat() == 0.0)
+				return false;
+			return setFloat(op == OPERATOR_DIV ? left.AsFloat() / right.AsFloat() : std::fmod(left.AsFloat(), right.AsFloat()));
+		}
+		case OPERATOR_BIT_AND:
+			return isInt && setInt(left.intValue & right.intValue);
+		case OPERATOR_BIT_OR:
+			return isInt && setInt(left.intValue | right.intValue);
+		case OPERATOR_BIT_XOR:
+			return isInt && setInt(left.intValue ^ right.intValue);
+		case OPERATOR_SHL:
+		{
+			if (!isInt || right.intValue < 0 || right.intValue > 63)
+				return false;
+			int64_t value = (int64_t)((uint64_t)left.intValue << right.intValue);
+			return (value >> right.intValue) == left.intValue && setInt(value); //no bits shifted out
+		}
+		case OPERATOR_SHR:
+			return isInt && right.intValue >= 0 && right.intValue <= 63 && setInt(left.intValue >> right.intValue);
+		default:
+			return false;
+		}
+	}
+
+	//an identity only holds for numbers of the right kind:x+0 turns -0.0 into 0.0 and x*1 must not touch a string,
+	//so the other operand's kind has to be known from the shape of the expression
+	Expr *ConstantFolder::FoldIdentity(InfixExpr *expr)
+	{
+		Constant left = GetConstant(expr->left);
+		Constant right = GetConstant(expr->right);
+		auto isInt = [](const Constant &constant, int64_t value)
+		{ return constant.kind == CONSTANT_INT && constant.intValue == value; };
+		auto isNumber = [](Expr *e)
+		{ return GetNumberKind(e) != NUMBER_UNKNOWN; };
+		auto isIntNumber = [](Expr *e)
+		{ return GetNumberKind(e) == NUMBER_INT; };
+
+		switch (expr->op)
+		{
+		case OPERATOR_MUL:
+			if (isInt(right, 1) && isNumber(expr->left))
+				return expr->left;
+			if (isInt(left, 1) && isNumber(expr->right))
+				return expr->right;
+			return nullptr;
+		case OPERATOR_DIV:
+			return isInt(right, 1) && isNumber(expr->left) ? expr->left : nullptr;
+		case OPERATOR_SUB:
+			return isInt(right, 0) && isNumber(expr->left) ? expr->left : nullptr;
+		case OPERATOR_ADD:
+		case OPERATOR_BIT_OR:
+		case OPERATOR_BIT_XOR:
+			if (isInt(right, 0) && isIntNumber(expr->left))
+				return expr->left;
+			if (isInt(left, 0) && isIntNumber(expr->right))
+				return expr->right;
+			return nullptr;
+		case OPERATOR_SHL:
+		case OPERATOR_SHR:
+			return isInt(right, 0) && isIntNumber(expr->left) ? expr->left : nullptr;
+		default:
+			return nullptr;
+		}
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include "Ast.h"
+#include "AstArena.h"
+#include "AstVisitor.h"
+namespace NajaLang
+{
+    // optimisation pass between the Parser and the Compiler:evaluates operators whose operands are literals,applies
+    // identities such as x*1 and removes if branches and while loops that can never run.Only what the runtime would
+    // compute the same way is folded,integer overflow,division by zero and out of range shifts stay in the tree so
+    // the runtime still reports them
+    class ConstantFolder : public AstVisitor<ConstantFolder, Expr *, Stmt *>
+    {
+    public:
+        ConstantFolder();
+        ~ConstantFolder();
+
+        // rewrites the tree in place and returns its new root.Nodes the folder creates live in its own arena until
+        // the next Fold,the rest of the tree stays where the Parser built it
+        Stmt *Fold(Stmt *stmt);
+
+        // expressions and statements replaced by the last Fold
+        uint64_t GetFoldCount() const;
+
+    private:
+        friend class AstVisitor<ConstantFolder, Expr *, Stmt *>;
+
+        enum ConstantKind
+        {
+            CONSTANT_NONE,
+            CONSTANT_INT,
+            CONSTANT_FLOAT,
+            CONSTANT_BOOL,
+            CONSTANT_NULL,
+        };
+
+        struct Constant
+        {
+            ConstantKind kind = CONSTANT_NONE;
+            int64_t intValue = 0;
+            double floatValue = 0.0;
+            bool boolValue = false;
+
+            double AsFloat() const { return kind == CONSTANT_INT ? (double)intValue : floatValue; }
+            bool IsNumber() const { return kind == CONSTANT_INT || kind == CONSTANT_FLOAT; }
+        };
+
+        // what an expression is known to evaluate to if it evaluates at all,arithmetic on anything but numbers fails
+        enum NumberKind
+        {
+            NUMBER_UNKNOWN,
+            NUMBER_ANY,
+            NUMBER_INT,
+            NUMBER_FLOAT,
+        };
+
+        Expr *DefaultExpr(Expr *expr) { return expr; }
+        Stmt *DefaultStmt(Stmt *stmt) { return stmt; }
+
+        Expr *VisitGroupExpr(GroupExpr *expr);
+        Expr *VisitFunctionExpr(FunctionExpr *expr);
+        Expr *VisitArrayExpr(ArrayExpr *expr);
+        Expr *VisitTableExpr(TableExpr *expr);
+        Expr *VisitPrefixExpr(PrefixExpr *expr);
+        Expr *VisitInfixExpr(InfixExpr *expr);
+        Expr *VisitPostfixExpr(PostfixExpr *expr);
+        Expr *VisitTernaryExpr(TernaryExpr *expr);
+        Expr *VisitIndexExpr(IndexExpr *expr);
+        Expr *VisitFunctionCallExpr(FunctionCallExpr *expr);
+        Expr *VisitClassCallExpr(ClassCallExpr *expr);
+        Expr *VisitNewExpr(NewExpr *expr);
+
+        Stmt *VisitVarStmt(VarStmt *stmt);
+        Stmt *VisitExprStmt(ExprStmt *stmt);
+        Stmt *VisitReturnStmt(ReturnStmt *stmt);
+        Stmt *VisitIfStmt(IfStmt *stmt);
+        Stmt *VisitScopeStmt(ScopeStmt *stmt);
+        Stmt *VisitWhileStmt(WhileStmt *stmt);
+        Stmt *VisitFunctionStmt(FunctionStmt *stmt);
+        Stmt *VisitClassStmt(ClassStmt *stmt);
+        Stmt *VisitAstStmts(AstStmts *stmt);
+
+        // statements folded away(nullptr) are dropped from the list
+        void FoldStmts(std::pmr::vector<Stmt *> &stmts);
+        // a branch that was folded away becomes an empty scope,its parent still needs a statement
+        Stmt *FoldBranch(Stmt *stmt);
+
+        static Constant GetConstant(Expr *expr);
+        static NumberKind GetNumberKind(Expr *expr);
+        Expr *MakeExpr(const Constant &constant);
+        bool FoldPrefix(Operator op, const Constant &right, Constant &result);
+        bool FoldInfix(Operator op, const Constant &left, const Constant &right, Constant &result);
+        // x*1,x+0 and the like,nullptr if none applies
+        Expr *FoldIdentity(InfixExpr *expr);
+
+        AstArena m_Arena;
+        uint64_t m_FoldCount;
+    };
+}
@@ -0,0 +1,965 @@
+#include "FlatAst.h"
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+#include "SymbolTable.h"
+#include "Constant.h"
+namespace NajaLang
+{
+	//child kinds IsValidChild accepts besides a single AstType
+	constexpr int32_t EXPECT_EXPR = -1;
+	constexpr int32_t EXPECT_STMT = -2;
+
+	constexpr char IMAGE_MAGIC[4] = {'N', 'A', 'S', 'T'};
+
+	static void WriteU32(std::string &out, uint32_t value)
+	{
+		char bytes[4] = {(char)value, (char)(value >> 8), (char)(value >> 16), (char)(value >> 24)};
+		out.append(bytes, 4);
+	}
+
+	static bool ReadU32(std::string_view &in, uint32_t &value)
+	{
+		if (in.size() < 4)
+			return false;
+		value = (uint32_t)(uint8_t)in[0] | (uint32_t)(uint8_t)in[1] << 8 | (uint32_t)(uint8_t)in[2] << 16 | (uint32_t)(uint8_t)in[3] << 24;
+		in.remove_prefix(4);
+		return true;
+	}
+
+	FlatAst::FlatAst()
+		: m_Root(INVALID_INDEX)
+	{
+	}
+	FlatAst::~FlatAst()
+	{
+	}
+
+	void FlatAst::Clear()
+	{
+		m_Nodes.clear();
+		m_Extra.clear();
+		m_Strings.clear();
+		m_Root = INVALID_INDEX;
+	}
+
+	void FlatAst::Build(Stmt *root)
+	{
+		Clear();
+		m_Root = FlattenStmt(root);
+	}
+
+	uint32_t FlatAst::GetRoot() const
+	{
+		return m_Root;
+	}
+
+	uint32_t FlatAst::GetNodeCount() const
+	{
+		return (uint32_t)m_Nodes.size();
+	}
+
+	uint64_t FlatAst::GetUsedBytes() const
+	{
+		return m_Nodes.size() * sizeof(FlatNode) + m_Extra.size() * sizeof(uint32_t) + m_Strings.size();
+	}
+
+	int64_t FlatAst::GetInt(uint32_t index) const
+	{
+		return (int64_t)GetValue(index);
+	}
+
+	double FlatAst::GetFloat(uint32_t index) const
+	{
+		uint64_t bits = GetValue(index);
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	std::string_view FlatAst::GetStr(uint32_t index) const
+	{
+		const FlatNode &node = m_Nodes[index];
+		return std::string_view(m_Strings).substr(node.a, node.b);
+	}
+
+	std::string_view FlatAst::GetIdentifier(uint32_t index) const
+	{
+		return GetSymbolTable().GetName(m_Nodes[index].a);
+	}
+
+	std::string FlatAst::Stringify() const
+	{
+		if (m_Root == INVALID_INDEX)
+			return "";
+		return Stringify(m_Root);
+	}
+
+	void FlatAst::Serialize(std::string &out) const
+	{
+		//symbols are only meaningful in this process,identifiers refer to a name table of the image instead
+		std::unordered_map<uint32_t, uint32_t> localSymbols;
+		std::vector<uint32_t> symbols;
+		for (const auto &node : m_Nodes)
+			if (node.tag == IDENTIFIER_EXPR && localSymbols.emplace(node.a, (uint32_t)symbols.size()).second)
+				symbols.push_back(node.a);
+
+		out.append(IMAGE_MAGIC, sizeof(IMAGE_MAGIC));
+		WriteU32(out, IMAGE_VERSION);
+		WriteU32(out, (uint32_t)m_Nodes.size());
+		WriteU32(out, (uint32_t)m_Extra.size());
+		WriteU32(out, (uint32_t)m_Strings.size());
+		WriteU32(out, (uint32_t)symbols.size());
+		WriteU32(out, m_Root);
+
+		for (auto symbol : symbols)
+		{
+			std::string_view name = GetSymbolTable().GetName(symbol);
+			WriteU32(out, (uint32_t)name.size());
+			out.append(name);
+		}
+		for (const auto &node : m_Nodes)
+		{
+			out.push_back((char)node.tag);
+			out.push_back((char)node.op);
+			WriteU32(out, node.tag == IDENTIFIER_EXPR ? localSymbols[node.a] : node.a);
+			WriteU32(out, node.b);
+			WriteU32(out, node.c);
+		}
+		for (auto e : m_Extra)
+			WriteU32(out, e);
+		out.append(m_Strings);
+	}
+
+	bool FlatAst::Deserialize(std::string_view image)
+	{
+		Clear();
+
+		uint32_t version, nodeCount, extraCount, stringBytes, symbolCount, root;
+		if (image.size() < sizeof(IMAGE_MAGIC) || image.substr(0, sizeof(IMAGE_MAGIC)) != std::string_view(IMAGE_MAGIC, sizeof(IMAGE_MAGIC)))
+			return false;
+		image.remove_prefix(sizeof(IMAGE_MAGIC));
+		if (!ReadU32(image, version) || version != IMAGE_VERSION ||
+			!ReadU32(image, nodeCount) || !ReadU32(image, extraCount) || !ReadU32(image, stringBytes) ||
+			!ReadU32(image, symbolCount) || !ReadU32(image, root))
+			return false;
+
+		//every count is checked against the bytes left before anything is allocated for it
+		std::vector<uint32_t> symbols;
+		for (uint32_t i = 0; i < symbolCount; ++i)
+		{
+			uint32_t length;
+			if (!ReadU32(image, length) || image.size() < length)
+				return false;
+			symbols.push_back(GetSymbolTable().Intern(image.substr(0, length)));
+			image.remove_prefix(length);
+		}
+
+		if (image.size() != (uint64_t)nodeCount * 14 + (uint64_t)extraCount * 4 + stringBytes)
+			return false;
+
+		m_Nodes.resize(nodeCount);
+		for (auto &node : m_Nodes)
+		{
+			node.tag = (uint8_t)image[0];
+			node.op = (uint8_t)image[1];
+			image.remove_prefix(2);
+			ReadU32(image, node.a);
+			ReadU32(image, node.b);
+			ReadU32(image, node.c);
+		}
+		m_Extra.resize(extraCount);
+		for (auto &e : m_Extra)
+			ReadU32(image, e);
+		m_Strings.assign(image);
+
+		bool isValid = root < nodeCount && m_Nodes[root].tag == AST_STMTS;
+		std::vector<bool> referenced(nodeCount, false);
+		for (uint32_t i = 0; isValid && i < nodeCount; ++i)
+			isValid = IsValidNode(i, symbolCount, referenced);
+		if (!isValid)
+		{
+			Clear();
+			return false;
+		}
+
+		for (auto &node : m_Nodes)
+			if (node.tag == IDENTIFIER_EXPR)
+				node.a = symbols[node.a];
+		m_Root = root;
+		return true;
+	}
+
+	Stmt *FlatAst::BuildTree(AstArena &arena) const
+	{
+		if (m_Root == INVALID_INDEX)
+			return arena.New<AstStmts>();
+		return BuildStmt(m_Root, arena);
+	}
+
+	uint32_t FlatAst::AddNode(AstType tag)
+	{
+		FlatNode node;
+		node.tag = (uint8_t)tag;
+		node.op = OPERATOR_UNDEFINED;
+		node.a = node.b = node.c = INVALID_INDEX;
+		m_Nodes.push_back(node);
+		return (uint32_t)m_Nodes.size() - 1;
+	}
+
+	uint32_t FlatAst::AddString(std::string_view str)
+	{
+		uint32_t offset = (uint32_t)m_Strings.size();
+		m_Strings.append(str);
+		return offset;
+	}
+
+	uint32_t FlatAst::AddList(const std::vector<uint32_t> &list)
+	{
+		uint32_t offset = (uint32_t)m_Extra.size();
+		m_Extra.insert(m_Extra.end(), list.begin(), list.end());
+		return offset;
+	}
+
+	void FlatAst::SetValue(uint32_t index, uint64_t bits)
+	{
+		m_Nodes[index].a = (uint32_t)bits;
+		m_Nodes[index].b = (uint32_t)(bits >> 32);
+	}
+
+	uint64_t FlatAst::GetValue(uint32_t index) const
+	{
+		return (uint64_t)m_Nodes[index].a | ((uint64_t)m_Nodes[index].b << 32);
+	}
+
+	template <typename T>
+	void FlatAst::FlattenList(const T &list, std::vector<uint32_t> &out)
+	{
+		for (const auto &e : list)
+		{
+			if constexpr (std::is_base_of_v<Stmt, std::remove_pointer_t<std::decay_t<decltype(e)>>>)
+				out.push_back(FlattenStmt(e));
+			else
+				out.push_back(FlattenExpr(e));
+		}
+	}
+
+	//the node is added before its children,so a parent always precedes its subtree
+	uint32_t FlatAst::FlattenExpr(Expr *expr)
+	{
+		if (!expr)
+			return INVALID_INDEX;
+
+		AstType type = expr->Type();
+		uint32_t index = AddNode(type);
+		switch (type)
+		{
+		case FLOAT_NUM_EXPR:
+		{
+			double value = ((FloatNumExpr *)expr)->value;
+			uint64_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			SetValue(index, bits);
+			break;
+		}
+		case INT_NUM_EXPR:
+			SetValue(index, (uint64_t)((IntNumExpr *)expr)->value);
+			break;
+		case STR_EXPR:
+		{
+			std::string_view str = ((StrExpr *)expr)->value;
+			m_Nodes[index].a = AddString(str);
+			m_Nodes[index].b = (uint32_t)str.size();
+			break;
+		}
+		case IDENTIFIER_EXPR:
+			m_Nodes[index].a = ((IdentifierExpr *)expr)->symbol;
+			break;
+		case GROUP_EXPR:
+		{
+			uint32_t child = FlattenExpr(((GroupExpr *)expr)->expr);
+			m_Nodes[index].a = child;
+			break;
+		}
+		case NEW_EXPR:
+		{
+			uint32_t child = FlattenExpr(((NewExpr *)expr)->object);
+			m_Nodes[index].a = child;
+			break;
+		}
+		case FUNCTION_EXPR:
+		{
+			auto funcExpr = (FunctionExpr *)expr;
+			std::vector<uint32_t> params;
+			FlattenList(funcExpr->parameters, params);
+			uint32_t body = FlattenStmt(funcExpr->body);
+			m_Nodes[index].a = body;
+			m_Nodes[index].b = AddList(params);
+			m_Nodes[index].c = (uint32_t)params.size();
+			break;
+		}
+		case ARRAY_EXPR:
+		{
+			std::vector<uint32_t> elements;
+			FlattenList(((ArrayExpr *)expr)->elements, elements);
+			m_Nodes[index].a = AddList(elements);
+			m_Nodes[index].b = (uint32_t)elements.size();
+			break;
+		}
+		case TABLE_EXPR:
+		{
+			std::vector<uint32_t> pairs;
+			for (auto [key, value] : ((TableExpr *)expr)->elements)
+			{
+				pairs.push_back(FlattenExpr(key));
+				pairs.push_back(FlattenExpr(value));
+			}
+			m_Nodes[index].a = AddList(pairs);
+			m_Nodes[index].b = (uint32_t)pairs.size() / 2;
+			break;
+		}
+		case PREFIX_EXPR:
+		{
+			auto prefixExpr = (PrefixExpr *)expr;
+			uint32_t right = FlattenExpr(prefixExpr->right);
+			m_Nodes[index].a = right;
+			m_Nodes[index].op = prefixExpr->op;
+			break;
+		}
+		case INFIX_EXPR:
+		{
+			auto infixExpr = (InfixExpr *)expr;
+			uint32_t left = FlattenExpr(infixExpr->left);
+			uint32_t right = FlattenExpr(infixExpr->right);
+			m_Nodes[index].a = left;
+			m_Nodes[index].b = right;
+			m_Nodes[index].op = infixExpr->op;
+			break;
+		}
+		case POSTFIX_EXPR:
+		{
+			auto postfixExpr = (PostfixExpr *)expr;
+			uint32_t left = FlattenExpr(postfixExpr->left);
+			m_Nodes[index].a = left;
+			m_Nodes[index].op = postfixExpr->op;
+			break;
+		}
+		case TERNARY_EXPR:
+		{
+			auto ternaryExpr = (TernaryExpr *)expr;
+			uint32_t condition = FlattenExpr(ternaryExpr->condition);
+			uint32_t trueBranch = FlattenExpr(ternaryExpr->trueBranch);
+			uint32_t falseBranch = FlattenExpr(ternaryExpr->falseBranch);
+			m_Nodes[index].a = condition;
+			m_Nodes[index].b = trueBranch;
+			m_Nodes[index].c = falseBranch;
+			break;
+		}
+		case INDEX_EXPR:
+		{
+			auto indexExpr = (IndexExpr *)expr;
+			uint32_t array = FlattenExpr(indexExpr->array);
+			uint32_t idx = FlattenExpr(indexExpr->index);
+			m_Nodes[index].a = array;
+			m_Nodes[index].b = idx;
+			break;
+		}
+		case FUNCTION_CALL_EXPR:
+		{
+			auto callExpr = (FunctionCallExpr *)expr;
+			uint32_t function = FlattenExpr(callExpr->function);
+			std::vector<uint32_t> arguments;
+			FlattenList(callExpr->arguments, arguments);
+			m_Nodes[index].a = function;
+			m_Nodes[index].b = AddList(arguments);
+			m_Nodes[index].c = (uint32_t)arguments.size();
+			break;
+		}
+		case CLASS_CALL_EXPR:
+		{
+			auto classCallExpr = (ClassCallExpr *)expr;
+			uint32_t instance = FlattenExpr(classCallExpr->classInstance);
+			uint32_t callee = FlattenExpr(classCallExpr->callee);
+			m_Nodes[index].a = instance;
+			m_Nodes[index].b = callee;
+			break;
+		}
+		default: //null,true,false,this,base carry nothing
+			break;
+		}
+		return index;
+	}
+
+	uint32_t FlatAst::FlattenStmt(Stmt *stmt)
+	{
+		if (!stmt)
+			return INVALID_INDEX;
+
+		uint32_t index = AddNode(stmt->Type());
+		switch (stmt->Type())
+		{
+		case EXPR_STMT:
+		{
+			uint32_t expr = FlattenExpr(((ExprStmt *)stmt)->expr);
+			m_Nodes[index].a = expr;
+			break;
+		}
+		case RETURN_STMT:
+		{
+			uint32_t expr = FlattenExpr(((ReturnStmt *)stmt)->expr);
+			m_Nodes[index].a = expr;
+			break;
+		}
+		case VAR_STMT:
+		{
+			std::vector<uint32_t> pairs;
+			for (const auto &[name, value] : ((VarStmt *)stmt)->variables)
+			{
+				pairs.push_back(FlattenExpr(name));
+				pairs.push_back(FlattenExpr(value));
+			}
+			m_Nodes[index].a = AddList(pairs);
+			m_Nodes[index].b = (uint32_t)pairs.size() / 2;
+			break;
+		}
+		case IF_STMT:
+		{
+			auto ifStmt = (IfStmt *)stmt;
+			uint32_t condition = FlattenExpr(ifStmt->condition);
+			uint32_t thenBranch = FlattenStmt(ifStmt->thenBranch);
+			uint32_t elseBranch = FlattenStmt(ifStmt->elseBranch);
+			m_Nodes[index].a = condition;
+			m_Nodes[index].b = thenBranch;
+			m_Nodes[index].c = elseBranch;
+			break;
+		}
+		case WHILE_STMT:
+		{
+			auto whileStmt = (WhileStmt *)stmt;
+			uint32_t condition = FlattenExpr(whileStmt->condition);
+			uint32_t body = FlattenStmt(whileStmt->stmt);
+			m_Nodes[index].a = condition;
+			m_Nodes[index].b = body;
+			break;
+		}
+		case SCOPE_STMT:
+		case AST_STMTS:
+		{
+			std::vector<uint32_t> stmts;
+			if (stmt->Type() == SCOPE_STMT)
+				FlattenList(((ScopeStmt *)stmt)->stmts, stmts);
+			else
+				FlattenList(((AstStmts *)stmt)->stmts, stmts);
+			m_Nodes[index].a = AddList(stmts);
+			m_Nodes[index].b = (uint32_t)stmts.size();
+			break;
+		}
+		case FUNCTION_STMT:
+		{
+			auto funcStmt = (FunctionStmt *)stmt;
+			uint32_t name = FlattenExpr(funcStmt->name);
+			std::vector<uint32_t> list;
+			list.push_back(INVALID_INDEX);
+			FlattenList(funcStmt->parameters, list);
+			list[0] = FlattenStmt(funcStmt->body);
+			m_Nodes[index].a = name;
+			m_Nodes[index].b = AddList(list);
+			m_Nodes[index].c = (uint32_t)list.size() - 1;
+			break;
+		}
+		case CLASS_STMT:
+		{
+			auto classStmt = (ClassStmt *)stmt;
+			uint32_t name = FlattenExpr(classStmt->name);
+			std::vector<uint32_t> lists[9];
+			FlattenList(classStmt->publicVars, lists[0]);
+			FlattenList(classStmt->protectedVars, lists[1]);
+			FlattenList(classStmt->privateVars, lists[2]);
+			FlattenList(classStmt->publicFunctions, lists[3]);
+			FlattenList(classStmt->protectedFunctions, lists[4]);
+			FlattenList(classStmt->privateFunctions, lists[5]);
+			FlattenList(classStmt->publicInherits, lists[6]);
+			FlattenList(classStmt->protectedInherits, lists[7]);
+			FlattenList(classStmt->privateInherits, lists[8]);
+
+			std::vector<uint32_t> extra;
+			for (const auto &list : lists)
+				extra.push_back((uint32_t)list.size());
+			for (const auto &list : lists)
+				extra.insert(extra.end(), list.begin(), list.end());
+			m_Nodes[index].a = name;
+			m_Nodes[index].b = AddList(extra);
+			break;
+		}
+		default: //break,continue carry nothing
+			break;
+		}
+		return index;
+	}
+
+	std::string FlatAst::StringifyList(uint32_t offset, uint32_t count) const
+	{
+		std::string result;
+		for (auto e : GetList(offset, count))
+			result += Stringify(e) + ",";
+		if (!result.empty())
+			result.pop_back();
+		return result;
+	}
+
+	std::string FlatAst::Stringify(uint32_t index) const
+	{
+		const FlatNode &node = m_Nodes[index];
+		switch (node.tag)
+		{
+		case FLOAT_NUM_EXPR:
+			return std::to_string(GetFloat(index));
+		case INT_NUM_EXPR:
+			return std::to_string(GetInt(index));
+		case STR_EXPR:
+			return std::string(GetStr(index));
+		case NULL_EXPR:
+			return "null";
+		case TRUE_EXPR:
+			return "true";
+		case FALSE_EXPR:
+			return "false";
+		case IDENTIFIER_EXPR:
+			return std::string(GetIdentifier(index));
+		case THIS_EXPR:
+			return "this";
+		case BASE_EXPR:
+			return "base";
+		case GROUP_EXPR:
+			return "(" + Stringify(node.a) + ")";
+		case FUNCTION_EXPR:
+			return "function(" + StringifyList(node.b, node.c) + ")" + (node.a != INVALID_INDEX ? Stringify(node.a) : "{...}");
+		case ARRAY_EXPR:
+			return "[" + StringifyList(node.a, node.b) + "]";
+		case TABLE_EXPR:
+		{
+			std::string result;
+			auto pairs = GetList(node.a, node.b * 2);
+			for (uint32_t i = 0; i < pairs.size(); i += 2)
+				result += Stringify(pairs[i]) + ":" + Stringify(pairs[i + 1]) + ",";
+			if (!result.empty())
+				result.pop_back();
+			return "{" + result + "}";
+		}
+		case PREFIX_EXPR:
+			return std::string(GetOperatorLiteral(GetOp(index))) + Stringify(node.a);
+		case INFIX_EXPR:
+			return Stringify(node.a) + std::string(GetOperatorLiteral(GetOp(index))) + Stringify(node.b);
+		case POSTFIX_EXPR:
+			return Stringify(node.a) + std::string(GetOperatorLiteral(GetOp(index)));
+		case TERNARY_EXPR:
+			return Stringify(node.a) + "?" + Stringify(node.b) + ":" + Stringify(node.c);
+		case INDEX_EXPR:
+			return Stringify(node.a) + "[" + Stringify(node.b) + "]";
+		case FUNCTION_CALL_EXPR:
+			return Stringify(node.a) + "(" + StringifyList(node.b, node.c) + ")";
+		case CLASS_CALL_EXPR:
+			return Stringify(node.a) + "." + Stringify(node.b);
+		case NEW_EXPR:
+			return "new " + Stringify(node.a);
+		case VAR_STMT:
+		{
+			std::string result;
+			auto pairs = GetList(node.a, node.b * 2);
+			for (uint32_t i = 0; i < pairs.size(); i += 2)
+				result += Stringify(pairs[i]) + "=" + Stringify(pairs[i + 1]) + ",";
+			if (!result.empty())
+				result.pop_back();
+			return "var " + result + ";";
+		}
+		case EXPR_STMT:
+			return Stringify(node.a) + ";";
+		case RETURN_STMT:
+			return "return " + (node.a != INVALID_INDEX ? Stringify(node.a) : "") + ";";
+		case IF_STMT:
+		{
+			std::string result = "if(" + Stringify(node.a) + ")" + Stringify(node.b);
+			if (node.c != INVALID_INDEX)
+				result += Stringify(node.c);
+			return result;
+		}
+		case SCOPE_STMT:
+		{
+			std::string result = "{";
+			for (auto stmt : GetList(node.a, node.b))
+				result += Stringify(stmt);
+			return result + "}";
+		}
+		case WHILE_STMT:
+			return "while(" + Stringify(node.a) + ")" + Stringify(node.b);
+		case BREAK_STMT:
+			return "break;";
+		case CONTINUE_STMT:
+			return "continue;";
+		case FUNCTION_STMT:
+			return "function " + Stringify(node.a) + "(" + StringifyList(node.b + 1, node.c) + ")" +
+				   (m_Extra[node.b] != INVALID_INDEX ? Stringify(m_Extra[node.b]) : "{...}");
+		case CLASS_STMT:
+		{
+			const uint32_t *counts = m_Extra.data() + node.b;
+			std::span<const uint32_t> lists[9];
+			uint32_t offset = node.b + 9;
+			for (uint32_t i = 0; i < 9; ++i)
+			{
+				lists[i] = GetList(offset, counts[i]);
+				offset += counts[i];
+			}
+
+			std::string result = "class " + Stringify(node.a);
+			if (!lists[6].empty() || !lists[7].empty() || !lists[8].empty())
+			{
+				result += ":";
+				for (auto e : lists[6])
+					result += "public " + Stringify(e) + ",\n";
+				for (auto e : lists[7])
+					result += "protected " + Stringify(e) + ",\n";
+				for (auto e : lists[8])
+					result += "private " + Stringify(e) + ",\n";
+				result = result.substr(0, result.size() - 2);
+			}
+			result += "\n{\n";
+			for (auto e : lists[3])
+				result += "\tpublic " + Stringify(e) + "\n";
+			for (auto e : lists[4])
+				result += "\tprotected " + Stringify(e) + "\n";
+			for (auto e : lists[5])
+				result += "\tprivate " + Stringify(e) + "\n";
+			for (auto e : lists[0])
+				result += "\tpublic " + Stringify(e) + "\n";
+			for (auto e : lists[1])
+				result += "\tprotected " + Stringify(e) + "\n";
+			for (auto e : lists[2])
+				result += "private " + Stringify(e) + "\n";
+			result += "}\n";
+			return result;
+		}
+		case AST_STMTS:
+		{
+			std::string result;
+			for (auto stmt : GetList(node.a, node.b))
+				result += Stringify(stmt);
+			return result;
+		}
+		default:
+			return "";
+		}
+	}
+
+	bool FlatAst::IsValidChild(uint32_t parent, uint32_t child, int32_t expected, std::vector<bool> &referenced) const
+	{
+		//children strictly behind their parent and referenced once keep the image a tree
+		if (child <= parent || child >= m_Nodes.size() || referenced[child])
+			return false;
+		referenced[child] = true;
+
+		uint8_t tag = m_Nodes[child].tag;
+		if (expected == EXPECT_EXPR)
+			return tag <= NEW_EXPR;
+		if (expected == EXPECT_STMT)
+			return tag >= VAR_STMT && tag < AST_STMTS;
+		return tag == expected;
+	}
+
+	bool FlatAst::IsValidList(uint32_t parent, uint64_t offset, uint64_t count, int32_t expected, std::vector<bool> &referenced) const
+	{
+		if (offset + count > m_Extra.size())
+			return false;
+		for (uint64_t i = offset; i < offset + count; ++i)
+			if (!IsValidChild(parent, m_Extra[i], expected, referenced))
+				return false;
+		return true;
+	}
+
+	bool FlatAst::IsValidNode(uint32_t index, uint32_t symbolCount, std::vector<bool> &referenced) const
+	{
+		const FlatNode &node = m_Nodes[index];
+		if (node.op > OPERATOR_UNDEFINED)
+			return false;
+
+		auto child = [&](uint32_t c, int32_t expected)
+		{ return IsValidChild(index, c, expected, referenced); };
+		auto optionalChild = [&](uint32_t c, int32_t expected)
+		{ return c == INVALID_INDEX || IsValidChild(index, c, expected, referenced); };
+		auto list = [&](uint64_t offset, uint64_t count, int32_t expected)
+		{ return IsValidList(index, offset, count, expected, referenced); };
+
+		switch (node.tag)
+		{
+		case FLOAT_NUM_EXPR:
+		case INT_NUM_EXPR:
+		case NULL_EXPR:
+		case TRUE_EXPR:
+		case FALSE_EXPR:
+		case THIS_EXPR:
+		case BASE_EXPR:
+		case BREAK_STMT:
+		case CONTINUE_STMT:
+			return true;
+		case STR_EXPR:
+			return (uint64_t)node.a + node.b <= m_Strings.size();
+		case IDENTIFIER_EXPR:
+			return node.a < symbolCount;
+		case GROUP_EXPR:
+		case NEW_EXPR:
+		case PREFIX_EXPR:
+		case POSTFIX_EXPR:
+		case EXPR_STMT:
+			return child(node.a, EXPECT_EXPR);
+		case FUNCTION_EXPR:
+			return list(node.b, node.c, IDENTIFIER_EXPR) && optionalChild(node.a, SCOPE_STMT);
+		case ARRAY_EXPR:
+			return list(node.a, node.b, EXPECT_EXPR);
+		case TABLE_EXPR:
+			return list(node.a, (uint64_t)node.b * 2, EXPECT_EXPR);
+		case VAR_STMT:
+		{
+			if (!list(node.a, (uint64_t)node.b * 2, EXPECT_EXPR))
+				return false;
+			auto pairs = GetList(node.a, node.b * 2);
+			for (uint32_t i = 0; i < pairs.size(); i += 2)
+				if (m_Nodes[pairs[i]].tag != IDENTIFIER_EXPR)
+					return false;
+			return true;
+		}
+		case INFIX_EXPR:
+		case INDEX_EXPR:
+		case CLASS_CALL_EXPR:
+			return child(node.a, EXPECT_EXPR) && child(node.b, EXPECT_EXPR);
+		case TERNARY_EXPR:
+			return child(node.a, EXPECT_EXPR) && child(node.b, EXPECT_EXPR) && child(node.c, EXPECT_EXPR);
+		case FUNCTION_CALL_EXPR:
+			return child(node.a, EXPECT_EXPR) && list(node.b, node.c, EXPECT_EXPR);
+		case RETURN_STMT:
+			return optionalChild(node.a, EXPECT_EXPR);
+		case IF_STMT:
+			return child(node.a, EXPECT_EXPR) && child(node.b, EXPECT_STMT) && optionalChild(node.c, EXPECT_STMT);
+		case WHILE_STMT:
+			return child(node.a, EXPECT_EXPR) && child(node.b, EXPECT_STMT);
+		case SCOPE_STMT:
+		case AST_STMTS:
+			return list(node.a, node.b, EXPECT_STMT);
+		case FUNCTION_STMT:
+			return child(node.a, IDENTIFIER_EXPR) && (uint64_t)node.b + 1 + node.c <= m_Extra.size() &&
+				   optionalChild(m_Extra[node.b], SCOPE_STMT) && list((uint64_t)node.b + 1, node.c, IDENTIFIER_EXPR);
+		case CLASS_STMT:
+		{
+			if (!child(node.a, IDENTIFIER_EXPR) || (uint64_t)node.b + 9 > m_Extra.size())
+				return false;
+			constexpr int32_t kinds[9] = {VAR_STMT, VAR_STMT, VAR_STMT,
+										  FUNCTION_STMT, FUNCTION_STMT, FUNCTION_STMT,
+										  IDENTIFIER_EXPR, IDENTIFIER_EXPR, IDENTIFIER_EXPR};
+			uint64_t offset = (uint64_t)node.b + 9;
+			for (uint32_t i = 0; i < 9; ++i)
+			{
+				if (!list(offset, m_Extra[node.b + i], kinds[i]))
+					return false;
+				offset += m_Extra[node.b + i];
+			}
+			return true;
+		}
+		default:
+			return false;
+		}
+	}
+
+	template <typename T, typename Fn>
+	void FlatAst::BuildList(uint32_t offset, uint32_t count, std::pmr::vector<T> &out, Fn build) const
+	{
+		out.reserve(count);
+		for (auto e : GetList(offset, count))
+			out.push_back(build(e));
+	}
+
+	IdentifierExpr *FlatAst::BuildIdentifier(uint32_t index, AstArena &arena) const
+	{
+		uint32_t symbol = m_Nodes[index].a;
+		return arena.New<IdentifierExpr>(GetSymbolTable().GetName(symbol), symbol);
+	}
+
+	//mirrors the Parser:literals without a value are the shared nodes of Constant.h,strings are copied into the arena
+	Expr *FlatAst::BuildExpr(uint32_t index, AstArena &arena) const
+	{
+		const FlatNode &node = m_Nodes[index];
+		auto buildExpr = [&](uint32_t e)
+		{ return BuildExpr(e, arena); };
+		auto buildIdentifier = [&](uint32_t e)
+		{ return BuildIdentifier(e, arena); };
+
+		switch (node.tag)
+		{
+		case FLOAT_NUM_EXPR:
+			return arena.New<FloatNumExpr>(GetFloat(index));
+		case INT_NUM_EXPR:
+			return arena.New<IntNumExpr>(GetInt(index));
+		case STR_EXPR:
+			return arena.New<StrExpr>(arena.CopyString(GetStr(index)));
+		case NULL_EXPR:
+			return nullExpr;
+		case TRUE_EXPR:
+			return trueExpr;
+		case FALSE_EXPR:
+			return falseExpr;
+		case IDENTIFIER_EXPR:
+			return BuildIdentifier(index, arena);
+		case THIS_EXPR:
+			return thisExpr;
+		case BASE_EXPR:
+			return baseExpr;
+		case GROUP_EXPR:
+			return arena.New<GroupExpr>(BuildExpr(node.a, arena));
+		case FUNCTION_EXPR:
+		{
+			auto funcExpr = arena.New<FunctionExpr>();
+			BuildList(node.b, node.c, funcExpr->parameters, buildIdentifier);
+			if (node.a != INVALID_INDEX)
+				funcExpr->body = (ScopeStmt *)BuildStmt(node.a, arena);
+			return funcExpr;
+		}
+		case ARRAY_EXPR:
+		{
+			auto arrayExpr = arena.New<ArrayExpr>();
+			BuildList(node.a, node.b, arrayExpr->elements, buildExpr);
+			return arrayExpr;
+		}
+		case TABLE_EXPR:
+		{
+			auto tableExpr = arena.New<TableExpr>();
+			auto pairs = GetList(node.a, node.b * 2);
+			for (uint32_t i = 0; i < pairs.size(); i += 2)
+				tableExpr->elements.emplace(BuildExpr(pairs[i], arena), BuildExpr(pairs[i + 1], arena));
+			return tableExpr;
+		}
+		case PREFIX_EXPR:
+			return arena.New<PrefixExpr>(GetOp(index), BuildExpr(node.a, arena));
+		case INFIX_EXPR:
+		{
+			Expr *left = BuildExpr(node.a, arena);
+			return arena.New<InfixExpr>(GetOp(index), left, BuildExpr(node.b, arena));
+		}
+		case POSTFIX_EXPR:
+			return arena.New<PostfixExpr>(BuildExpr(node.a, arena), GetOp(index));
+		case TERNARY_EXPR:
+		{
+			Expr *condition = BuildExpr(node.a, arena);
+			Expr *trueBranch = BuildExpr(node.b, arena);
+			return arena.New<TernaryExpr>(condition, trueBranch, BuildExpr(node.c, arena));
+		}
+		case INDEX_EXPR:
+		{
+			Expr *array = BuildExpr(node.a, arena);
+			return arena.New<IndexExpr>(array, BuildExpr(node.b, arena));
+		}
+		case FUNCTION_CALL_EXPR:
+		{
+			auto callExpr = arena.New<FunctionCallExpr>();
+			callExpr->function = BuildExpr(node.a, arena);
+			BuildList(node.b, node.c, callExpr->arguments, buildExpr);
+			return callExpr;
+		}
+		case CLASS_CALL_EXPR:
+		{
+			Expr *instance = BuildExpr(node.a, arena);
+			return arena.New<ClassCallExpr>(instance, BuildExpr(node.b, arena));
+		}
+		case NEW_EXPR:
+			return arena.New<NewExpr>(BuildExpr(node.a, arena));
+		default:
+			return nullptr;
+		}
+	}
+
+	Stmt *FlatAst::BuildStmt(uint32_t index, AstArena &arena) const
+	{
+		const FlatNode &node = m_Nodes[index];
+		auto buildStmt = [&](uint32_t e)
+		{ return BuildStmt(e, arena); };
+		auto buildIdentifier = [&](uint32_t e)
+		{ return BuildIdentifier(e, arena); };
+
+		switch (node.tag)
+		{
+		case EXPR_STMT:
+			return arena.New<ExprStmt>(BuildExpr(node.a, arena));
+		case RETURN_STMT:
+			return arena.New<ReturnStmt>(node.a != INVALID_INDEX ? BuildExpr(node.a, arena) : nullptr);
+		case VAR_STMT:
+		{
+			auto varStmt = arena.New<VarStmt>();
+			auto pairs = GetList(node.a, node.b * 2);
+			varStmt->variables.reserve(node.b);
+			for (uint32_t i = 0; i < pairs.size(); i += 2)
+			{
+				IdentifierExpr *name = BuildIdentifier(pairs[i], arena);
+				varStmt->variables.emplace_back(name, BuildExpr(pairs[i + 1], arena));
+			}
+			return varStmt;
+		}
+		case IF_STMT:
+		{
+			Expr *condition = BuildExpr(node.a, arena);
+			Stmt *thenBranch = BuildStmt(node.b, arena);
+			Stmt *elseBranch = node.c != INVALID_INDEX ? BuildStmt(node.c, arena) : nullptr;
+			return arena.New<IfStmt>(condition, thenBranch, elseBranch);
+		}
+		case SCOPE_STMT:
+		{
+			auto scopeStmt = arena.New<ScopeStmt>();
+			BuildList(node.a, node.b, scopeStmt->stmts, buildStmt);
+			return scopeStmt;
+		}
+		case WHILE_STMT:
+		{
+			Expr *condition = BuildExpr(node.a, arena);
+			return arena.New<WhileStmt>(condition, BuildStmt(node.b, arena));
+		}
+		case BREAK_STMT:
+			return arena.New<BreakStmt>();
+		case CONTINUE_STMT:
+			return arena.New<ContinueStmt>();
+		case FUNCTION_STMT:
+		{
+			auto funcStmt = arena.New<FunctionStmt>();
+			funcStmt->name = BuildIdentifier(node.a, arena);
+			BuildList(node.b + 1, node.c, funcStmt->parameters, buildIdentifier);
+			if (m_Extra[node.b] != INVALID_INDEX)
+				funcStmt->body = (ScopeStmt *)BuildStmt(m_Extra[node.b], arena);
+			return funcStmt;
+		}
+		case CLASS_STMT:
+		{
+			auto classStmt = arena.New<ClassStmt>();
+			classStmt->name = BuildIdentifier(node.a, arena);
+			const uint32_t *counts = m_Extra.data() + node.b;
+			uint32_t offset = node.b + 9;
+			auto buildVar = [&](uint32_t e)
+			{ return (VarStmt *)BuildStmt(e, arena); };
+			auto buildFunction = [&](uint32_t e)
+			{ return (FunctionStmt *)BuildStmt(e, arena); };
+
+			BuildList(offset, counts[0], classStmt->publicVars, buildVar);
+			BuildList(offset += counts[0], counts[1], classStmt->protectedVars, buildVar);
+			BuildList(offset += counts[1], counts[2], classStmt->privateVars, buildVar);
+			BuildList(offset += counts[2], counts[3], classStmt->publicFunctions, buildFunction);
+			BuildList(offset += counts[3], counts[4], classStmt->protectedFunctions, buildFunction);
+			BuildList(offset += counts[4], counts[5], classStmt->privateFunctions, buildFunction);
+			BuildList(offset += counts[5], counts[6], classStmt->publicInherits, buildIdentifier);
+			BuildList(offset += counts[6], counts[7], classStmt->protectedInherits, buildIdentifier);
+			BuildList(offset += counts[7], counts[8], classStmt->privateInherits, buildIdentifier);
+			return classStmt;
+		}
+		case AST_STMTS:
+		{
+			auto astStmts = arena.New<AstStmts>();
+			BuildList(node.a, node.b, astStmts->stmts, buildStmt);
+			return astStmts;
+		}
+		default:
+			return nullptr;
+		}
+	}
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Ast.h"
+#include "AstArena.h"
+namespace NajaLang
+{
+    // one node of a FlatAst.What a,b and c hold depends on the tag:
+    //  FLOAT_NUM_EXPR,INT_NUM_EXPR   a,b:low and high 32 bits of the value
+    //  STR_EXPR                      a:offset,b:length in the string pool
+    //  IDENTIFIER_EXPR               a:symbol
+    //  GROUP_EXPR,NEW_EXPR           a:expr
+    //  FUNCTION_EXPR                 a:body or INVALID_INDEX if it was skipped,b/c:parameter list
+    //  ARRAY_EXPR                    a/b:element list
+    //  TABLE_EXPR,VAR_STMT           a/b:list of b key,value pairs
+    //  PREFIX_EXPR                   a:right
+    //  INFIX_EXPR                    a:left,b:right
+    //  POSTFIX_EXPR                  a:left
+    //  TERNARY_EXPR                  a:condition,b:true branch,c:false branch
+    //  INDEX_EXPR                    a:array,b:index
+    //  FUNCTION_CALL_EXPR            a:function,b/c:argument list
+    //  CLASS_CALL_EXPR               a:class instance,b:callee
+    //  EXPR_STMT,RETURN_STMT         a:expr or INVALID_INDEX
+    //  IF_STMT                       a:condition,b:then branch,c:else branch or INVALID_INDEX
+    //  WHILE_STMT                    a:condition,b:body
+    //  SCOPE_STMT,AST_STMTS          a/b:statement list
+    //  FUNCTION_STMT                 a:name,b:extra offset of [body,parameters...],c:parameter count
+    //  CLASS_STMT                    a:name,b:extra offset of 9 counts followed by the 9 lists in ClassStmt's order
+    // a list is an offset into the extra array and a count,the operator of a prefix,infix or postfix node is in op
+    struct FlatNode
+    {
+        uint8_t tag; // AstType
+        uint8_t op; // Operator
+        uint32_t a;
+        uint32_t b;
+        uint32_t c;
+    };
+
+    // the whole tree in one contiguous node array addressed by uint32_t indices,children follow their parent so a
+    // top down walk reads memory mostly forward.Nothing points into the parser's arena,so a FlatAst outlives it
+    class FlatAst
+    {
+    public:
+        FlatAst();
+        ~FlatAst();
+
+        static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+        void Clear();
+        // flattens a tree built by the Parser,replacing the current content
+        void Build(Stmt *root);
+
+        // the AST_STMTS node
+        uint32_t GetRoot() const;
+        uint32_t GetNodeCount() const;
+        // nodes,extra array and string pool
+        uint64_t GetUsedBytes() const;
+        const FlatNode &GetNode(uint32_t index) const { return m_Nodes[index]; }
+        AstType GetTag(uint32_t index) const { return (AstType)m_Nodes[index].tag; }
+
+        std::span<const uint32_t> GetList(uint32_t offset, uint32_t count) const { return {m_Extra.data() + offset, count}; }
+        int64_t GetInt(uint32_t index) const;
+        double GetFloat(uint32_t index) const;
+        std::string_view GetStr(uint32_t index) const;
+        Operator GetOp(uint32_t index) const { return (Operator)m_Nodes[index].op; }
+        std::string_view GetIdentifier(uint32_t index) const;
+
+        // same text as Stringify on the tree the FlatAst was built from
+        std::string Stringify() const;
+
+        // bumped whenever the image layout or the trees the Parser builds change
+        static constexpr uint32_t IMAGE_VERSION = 1;
+        // appends a little endian image that does not depend on the process:identifiers are written by name
+        void Serialize(std::string &out) const;
+        // checks every index,range and child type before taking the image,so a damaged or foreign one is rejected
+        // and leaves the FlatAst empty.Identifiers are interned again
+        bool Deserialize(std::string_view image);
+        // the tree Parser::Parse would have returned,built in arena.Skipped function bodies come back empty
+        Stmt *BuildTree(AstArena &arena) const;
+
+    private:
+        uint32_t AddNode(AstType tag);
+        uint32_t AddString(std::string_view str);
+        uint32_t AddList(const std::vector<uint32_t> &list);
+        void SetValue(uint32_t index, uint64_t bits);
+        uint64_t GetValue(uint32_t index) const;
+
+        uint32_t FlattenExpr(Expr *expr);
+        uint32_t FlattenStmt(Stmt *stmt);
+        template <typename T>
+        void FlattenList(const T &list, std::vector<uint32_t> &out);
+
+        std::string Stringify(uint32_t index) const;
+        std::string StringifyList(uint32_t offset, uint32_t count) const;
+
+        bool IsValidNode(uint32_t index, uint32_t symbolCount, std::vector<bool> &referenced) const;
+        bool IsValidChild(uint32_t parent, uint32_t child, int32_t expected, std::vector<bool> &referenced) const;
+        bool IsValidList(uint32_t parent, uint64_t offset, uint64_t count, int32_t expected, std::vector<bool> &referenced) const;
+
+        Expr *BuildExpr(uint32_t index, AstArena &arena) const;
+        Stmt *BuildStmt(uint32_t index, AstArena &arena) const;
+        IdentifierExpr *BuildIdentifier(uint32_t index, AstArena &arena) const;
+        template <typename T, typename Fn>
+        void BuildList(uint32_t offset, uint32_t count, std::pmr::vector<T> &out, Fn build) const;
+
+        std::vector<FlatNode> m_Nodes;
+        std::vector<uint32_t> m_Extra;
+        std::string m_Strings;
+        uint32_t m_Root;
+    };
+}
@@ -0,0 +1,463 @@
+#include "IncrementalLexer.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include "SimdScan.h"
+namespace NajaLang
+{
+	IncrementalLexer::IncrementalLexer()
+		: m_GapBegin(0), m_GapEnd(0), m_EntryCount(0), m_EndLine(1)
+	{
+	}
+	IncrementalLexer::~IncrementalLexer()
+	{
+	}
+
+	void IncrementalLexer::SetSource(std::string_view src)
+	{
+		m_Buffer.assign(src);
+		m_Buffer.resize(src.size() + MIN_GAP_SIZE);
+		m_GapBegin = src.size();
+		m_GapEnd = m_Buffer.size();
+
+		std::string_view text(m_Buffer.data(), src.size());
+		const auto &tokens = m_Lexer.ScanTokens(text);
+		m_Chunks.clear();
+		for (const auto &token : tokens)
+		{
+			if (token.type == TOKEN_EOF)
+				break;
+			if (m_Chunks.empty() || m_Chunks.back().entries.size() == CHUNK_SIZE)
+				m_Chunks.push_back({{}, 0, 0});
+			m_Chunks.back().entries.push_back(MakeEntry(token, token.literal.data() - text.data(), token.line));
+		}
+		m_EntryCount = tokens.size() - 1;
+		m_EndLine = tokens.back().line;
+		RebuildChunkTree();
+	}
+
+	TokenChange IncrementalLexer::ApplyEdit(const TextEdit &edit)
+	{
+		uint64_t size = GetTextSize();
+		uint64_t offset = std::min<uint64_t>(edit.offset, size);
+		uint64_t removedLength = std::min<uint64_t>(edit.removedLength, size - offset);
+		uint64_t removedEnd = offset + removedLength;
+
+		//the first token the edit can change,everything before it is untouched
+		uint64_t first = FindFirstEntry(0, [&](const TokenEntry &entry)
+										{ return GetTokenEnd(entry) + LOOKAHEAD_REACH > offset; });
+
+		uint64_t restartPos = 0;
+		uint64_t restartLine = 1;
+		if (first > 0)
+		{
+			TokenEntry prev = GetEntry(first - 1);
+			restartPos = GetTokenEnd(prev);
+			restartLine = prev.line;
+		}
+
+		//old tokens starting behind the removed text are the candidates to resynchronise with
+		uint64_t candidate = FindFirstEntry(first, [&](const TokenEntry &entry)
+											{ return GetTokenBegin(entry) >= removedEnd; });
+
+		//with the gap at the edit the removed text lies right behind it
+		MoveGap(offset);
+		int64_t posDelta = (int64_t)edit.insertedText.size() - (int64_t)removedLength;
+		int64_t lineDelta = (int64_t)CountNewlines(edit.insertedText.data(), edit.insertedText.data() + edit.insertedText.size()) -
+							(int64_t)CountNewlines(m_Buffer.data() + m_GapEnd, m_Buffer.data() + m_GapEnd + removedLength);
+		m_GapEnd += removedLength;
+		ReserveGap(edit.insertedText.size());
+		std::memcpy(m_Buffer.data() + m_GapBegin, edit.insertedText.data(), edit.insertedText.size());
+		m_GapBegin += edit.insertedText.size();
+		size = GetTextSize();
+
+		//the lexer reads the text in front of the gap,which is moved just far enough to scan the first candidate.
+		//When the new tokens do not line up there(an opened string or comment) the window grows geometrically,so the
+		//text moved stays proportional to the text rescanned
+		uint64_t scanEnd = size;
+		if (candidate < m_EntryCount)
+			scanEnd = std::min<uint64_t>(size, GetTokenEnd(GetEntry(candidate)) + posDelta + LOOKAHEAD_REACH);
+
+		std::vector<TokenEntry> newEntries;
+		uint64_t resync = m_EntryCount;
+		uint64_t resyncPos = size;
+		uint64_t scanPos = restartPos;
+		uint64_t scanLine = restartLine;
+		while (true)
+		{
+			MoveGap(scanEnd);
+			m_Lexer.SetSource(std::string_view(m_Buffer.data(), scanEnd), scanPos, scanLine);
+			m_Lexer.DeferErrors();
+
+			bool isCutOff = false;
+			while (true)
+			{
+				const Token &token = m_Lexer.NextToken();
+				if (token.type == TOKEN_EOF)
+				{
+					isCutOff = scanEnd < size;
+					break;
+				}
+
+				TokenEntry entry = MakeEntry(token, token.literal.data() - m_Buffer.data(), token.line);
+				if (scanEnd < size && GetTokenEnd(entry) + LOOKAHEAD_REACH > scanEnd)
+				{
+					isCutOff = true;
+					break;
+				}
+
+				uint64_t tokenPos = GetTokenBegin(entry);
+				while (candidate < m_EntryCount && GetTokenBegin(GetEntry(candidate)) + posDelta < tokenPos)
+					candidate++;
+				if (candidate < m_EntryCount && GetTokenBegin(GetEntry(candidate)) + posDelta == tokenPos)
+				{
+					resync = candidate;
+					resyncPos = tokenPos;
+					break;
+				}
+
+				newEntries.push_back(entry);
+			}
+
+			if (!isCutOff)
+				break;
+
+			//the tokens scanned completely are kept,the rest is scanned again with a larger window
+			if (!newEntries.empty())
+			{
+				scanPos = GetTokenEnd(newEntries.back());
+				scanLine = newEntries.back().line;
+			}
+			m_Lexer.ReportDeferredErrors(scanPos);
+			scanEnd = std::min<uint64_t>(size, scanEnd + std::max<uint64_t>(scanEnd - restartPos, MIN_SCAN_WINDOW));
+		}
+		m_Lexer.ReportDeferredErrors(resyncPos);
+
+		//parked between two tokens,so no literal straddles the gap
+		MoveGap(resyncPos);
+
+		uint64_t removedCount = resync - first;
+		uint64_t insertedCount = newEntries.size();
+
+		//the chunks from the one holding the first changed token to the one holding the resynchronised token are
+		//rewritten,with the old entries around the change in their final place
+		std::vector<TokenEntry> entries;
+		uint64_t firstChunk = 0;
+		uint64_t endChunk = 0;
+		if (m_EntryCount > 0)
+		{
+			uint64_t chunkBegin, lastChunkBegin;
+			firstChunk = FindChunk(std::min(first, m_EntryCount - 1), chunkBegin);
+			endChunk = FindChunk(std::min(resync, m_EntryCount - 1), lastChunkBegin) + 1;
+
+			ChunkSums shift = SumChunks(firstChunk + 1);
+			uint64_t index = chunkBegin;
+			for (uint64_t c = firstChunk; c < endChunk; ++c)
+			{
+				if (c > firstChunk)
+				{
+					shift.posDelta += m_Chunks[c].posDelta;
+					shift.lineDelta += m_Chunks[c].lineDelta;
+				}
+				for (auto entry : m_Chunks[c].entries)
+				{
+					if (index == first)
+						entries.insert(entries.end(), newEntries.begin(), newEntries.end());
+					if (index < first || index >= resync)
+					{
+						bool isBehind = index >= resync;
+						entry.pos += shift.posDelta + (isBehind ? posDelta : 0);
+						entry.line += shift.lineDelta + (isBehind ? lineDelta : 0);
+						entries.push_back(entry);
+					}
+					index++;
+				}
+			}
+			if (first == m_EntryCount)
+				entries.insert(entries.end(), newEntries.begin(), newEntries.end());
+		}
+		else
+			entries = std::move(newEntries);
+
+		ReplaceChunks(firstChunk, endChunk, entries, posDelta, lineDelta);
+
+		m_EntryCount = m_EntryCount - removedCount + insertedCount;
+		m_EndLine += lineDelta;
+
+		return {first, removedCount, insertedCount};
+	}
+
+	std::string_view IncrementalLexer::GetSource() const
+	{
+		uint64_t size = GetTextSize();
+		MoveGap(size);
+		return std::string_view(m_Buffer.data(), size);
+	}
+
+	uint64_t IncrementalLexer::GetTokenCount() const
+	{
+		return m_EntryCount + 1;
+	}
+
+	Token IncrementalLexer::GetToken(uint64_t index) const
+	{
+		if (index >= m_EntryCount)
+			return Token(TOKEN_EOF, std::string_view(GetTextPointer(GetTextSize()), 0), m_EndLine);
+		TokenEntry entry = GetEntry(index);
+		Token token(entry.type, std::string_view(GetTextPointer(entry.pos), entry.length), entry.line);
+		token.numberType = entry.numberType;
+		token.value = entry.value;
+		return token;
+	}
+
+	std::vector<Token> IncrementalLexer::GetTokens() const
+	{
+		std::vector<Token> tokens;
+		tokens.reserve(GetTokenCount());
+		for (uint64_t i = 0; i < GetTokenCount(); ++i)
+			tokens.emplace_back(GetToken(i));
+		return tokens;
+	}
+
+	IncrementalLexer::TokenEntry IncrementalLexer::MakeEntry(const Token &token, uint64_t pos, uint64_t line)
+	{
+		TokenEntry entry;
+		entry.type = token.type;
+		entry.pos = pos;
+		entry.length = token.literal.size();
+		entry.line = line;
+		entry.numberType = token.numberType;
+		entry.value = token.value;
+		return entry;
+	}
+
+	IncrementalLexer::TokenEntry IncrementalLexer::GetEntry(uint64_t index) const
+	{
+		uint64_t chunkBegin;
+		uint64_t chunk = FindChunk(index, chunkBegin);
+		ChunkSums shift = SumChunks(chunk + 1);
+		TokenEntry entry = m_Chunks[chunk].entries[index - chunkBegin];
+		entry.pos += shift.posDelta;
+		entry.line += shift.lineDelta;
+		return entry;
+	}
+
+	//chunks are searched by their last entry first,then the one found entry by entry
+	template <typename Pred>
+	uint64_t IncrementalLexer::FindFirstEntry(uint64_t from, Pred &&pred) const
+	{
+		if (from >= m_EntryCount)
+			return m_EntryCount;
+
+		uint64_t chunkBegin;
+		uint64_t low = FindChunk(from, chunkBegin), high = m_Chunks.size();
+		while (low < high)
+		{
+			uint64_t mid = low + (high - low) / 2;
+			ChunkSums shift = SumChunks(mid + 1);
+			TokenEntry last = m_Chunks[mid].entries.back();
+			last.pos += shift.posDelta;
+			last.line += shift.lineDelta;
+			if (pred(last))
+				high = mid;
+			else
+				low = mid + 1;
+		}
+		if (low == m_Chunks.size())
+			return m_EntryCount;
+
+		ChunkSums shift = SumChunks(low + 1);
+		const auto &entries = m_Chunks[low].entries;
+		chunkBegin = shift.count - entries.size();
+		uint64_t lowEntry = from > chunkBegin ? from - chunkBegin : 0, highEntry = entries.size();
+		while (lowEntry < highEntry)
+		{
+			uint64_t mid = lowEntry + (highEntry - lowEntry) / 2;
+			TokenEntry entry = entries[mid];
+			entry.pos += shift.posDelta;
+			entry.line += shift.lineDelta;
+			if (pred(entry))
+				highEntry = mid;
+			else
+				lowEntry = mid + 1;
+		}
+		return chunkBegin + lowEntry;
+	}
+
+	uint64_t IncrementalLexer::GetTokenBegin(const TokenEntry &entry)
+	{
+		return entry.pos - (entry.type == TOKEN_STRING ? 1 : 0);
+	}
+
+	uint64_t IncrementalLexer::GetTokenEnd(const TokenEntry &entry)
+	{
+		return entry.pos + entry.length + (entry.type == TOKEN_STRING ? 1 : 0);
+	}
+
+	//the replacement keeps the number of chunks when the entries fit them,then the tree is updated in place.Otherwise
+	//the chunks are cut again and the tree is rebuilt,which takes a few hundred inserted or removed tokens
+	void IncrementalLexer::ReplaceChunks(uint64_t firstChunk, uint64_t endChunk, std::vector<TokenEntry> &entries, int64_t posDelta, int64_t lineDelta)
+	{
+		uint64_t oldCount = endChunk - firstChunk;
+		uint64_t newCount = oldCount;
+		if (entries.size() < oldCount || entries.size() > oldCount * MAX_CHUNK_SIZE || (oldCount > 1 && entries.size() < oldCount * CHUNK_SIZE / 4))
+			newCount = (entries.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+		//the new chunks share the shift of the first old one,the chunk behind them takes up the rest and the edit
+		ChunkSums before = SumChunks(firstChunk);
+		ChunkSums shift = before;
+		if (oldCount > 0)
+		{
+			shift.posDelta += m_Chunks[firstChunk].posDelta;
+			shift.lineDelta += m_Chunks[firstChunk].lineDelta;
+		}
+		ChunkSums lastShift = newCount > 0 ? shift : before;
+
+		std::vector<TokenChunk> chunks(newCount);
+		for (uint64_t c = 0; c < newCount; ++c)
+		{
+			uint64_t begin = entries.size() * c / newCount;
+			uint64_t end = entries.size() * (c + 1) / newCount;
+			chunks[c].entries.reserve(end - begin);
+			for (uint64_t i = begin; i < end; ++i)
+			{
+				TokenEntry entry = entries[i];
+				entry.pos -= shift.posDelta;
+				entry.line -= shift.lineDelta;
+				chunks[c].entries.push_back(entry);
+			}
+			chunks[c].posDelta = c == 0 ? shift.posDelta - before.posDelta : 0;
+			chunks[c].lineDelta = c == 0 ? shift.lineDelta - before.lineDelta : 0;
+		}
+
+		bool hasNext = endChunk < m_Chunks.size();
+		ChunkSums next{0, 0, 0};
+		if (hasNext)
+		{
+			next = SumChunks(endChunk + 1);
+			next.posDelta += posDelta - lastShift.posDelta;
+			next.lineDelta += lineDelta - lastShift.lineDelta;
+		}
+
+		if (newCount == oldCount)
+		{
+			for (uint64_t c = 0; c < newCount; ++c)
+			{
+				TokenChunk &chunk = m_Chunks[firstChunk + c];
+				AddToChunkTree(firstChunk + c, {(int64_t)chunks[c].entries.size() - (int64_t)chunk.entries.size(),
+												chunks[c].posDelta - chunk.posDelta, chunks[c].lineDelta - chunk.lineDelta});
+				chunk = std::move(chunks[c]);
+			}
+			if (hasNext)
+			{
+				TokenChunk &chunk = m_Chunks[endChunk];
+				AddToChunkTree(endChunk, {0, next.posDelta - chunk.posDelta, next.lineDelta - chunk.lineDelta});
+				chunk.posDelta = next.posDelta;
+				chunk.lineDelta = next.lineDelta;
+			}
+			return;
+		}
+
+		if (hasNext)
+		{
+			m_Chunks[endChunk].posDelta = next.posDelta;
+			m_Chunks[endChunk].lineDelta = next.lineDelta;
+		}
+		m_Chunks.erase(m_Chunks.begin() + firstChunk, m_Chunks.begin() + endChunk);
+		m_Chunks.insert(m_Chunks.begin() + firstChunk, std::make_move_iterator(chunks.begin()), std::make_move_iterator(chunks.end()));
+		RebuildChunkTree();
+	}
+
+	void IncrementalLexer::RebuildChunkTree()
+	{
+		m_ChunkTree.assign(m_Chunks.size() + 1, {0, 0, 0});
+		for (uint64_t i = 1; i <= m_Chunks.size(); ++i)
+		{
+			ChunkSums &node = m_ChunkTree[i];
+			node.count += m_Chunks[i - 1].entries.size();
+			node.posDelta += m_Chunks[i - 1].posDelta;
+			node.lineDelta += m_Chunks[i - 1].lineDelta;
+			uint64_t parent = i + (i & (~i + 1));
+			if (parent <= m_Chunks.size())
+			{
+				m_ChunkTree[parent].count += node.count;
+				m_ChunkTree[parent].posDelta += node.posDelta;
+				m_ChunkTree[parent].lineDelta += node.lineDelta;
+			}
+		}
+	}
+
+	void IncrementalLexer::AddToChunkTree(uint64_t chunk, const ChunkSums &sums)
+	{
+		for (uint64_t i = chunk + 1; i < m_ChunkTree.size(); i += i & (~i + 1))
+		{
+			m_ChunkTree[i].count += sums.count;
+			m_ChunkTree[i].posDelta += sums.posDelta;
+			m_ChunkTree[i].lineDelta += sums.lineDelta;
+		}
+	}
+
+	IncrementalLexer::ChunkSums IncrementalLexer::SumChunks(uint64_t chunkCount) const
+	{
+		ChunkSums sums{0, 0, 0};
+		for (uint64_t i = chunkCount; i > 0; i -= i & (~i + 1))
+		{
+			sums.count += m_ChunkTree[i].count;
+			sums.posDelta += m_ChunkTree[i].posDelta;
+			sums.lineDelta += m_ChunkTree[i].lineDelta;
+		}
+		return sums;
+	}
+
+	//descends the tree to the last chunk with at most index entries in front of it
+	uint64_t IncrementalLexer::FindChunk(uint64_t index, uint64_t &chunkBegin) const
+	{
+		uint64_t chunk = 0;
+		uint64_t before = 0;
+		for (uint64_t step = std::bit_floor(m_ChunkTree.size() - 1); step > 0; step >>= 1)
+			if (chunk + step < m_ChunkTree.size() && before + (uint64_t)m_ChunkTree[chunk + step].count <= index)
+			{
+				chunk += step;
+				before += m_ChunkTree[chunk].count;
+			}
+		chunkBegin = before;
+		return chunk;
+	}
+
+	uint64_t IncrementalLexer::GetTextSize() const
+	{
+		return m_Buffer.size() - (m_GapEnd - m_GapBegin);
+	}
+
+	void IncrementalLexer::MoveGap(uint64_t pos) const
+	{
+		if (pos < m_GapBegin)
+			std::memmove(m_Buffer.data() + m_GapEnd - (m_GapBegin - pos), m_Buffer.data() + pos, m_GapBegin - pos);
+		else if (pos > m_GapBegin)
+			std::memmove(m_Buffer.data() + m_GapBegin, m_Buffer.data() + m_GapEnd, pos - m_GapBegin);
+		m_GapEnd = m_GapEnd + pos - m_GapBegin;
+		m_GapBegin = pos;
+	}
+
+	//the gap grows with the text,so inserting stays amortised O(1) per char
+	void IncrementalLexer::ReserveGap(uint64_t size)
+	{
+		if (m_GapEnd - m_GapBegin >= size)
+			return;
+		uint64_t textSize = GetTextSize();
+		uint64_t gapSize = std::max(size, textSize) + MIN_GAP_SIZE;
+		uint64_t tailSize = m_Buffer.size() - m_GapEnd;
+		std::string buffer(textSize + gapSize, '\0');
+		std::memcpy(buffer.data(), m_Buffer.data(), m_GapBegin);
+		std::memcpy(buffer.data() + m_GapBegin + gapSize, m_Buffer.data() + m_GapEnd, tailSize);
+		m_Buffer.swap(buffer);
+		m_GapEnd = m_GapBegin + gapSize;
+	}
+
+	//a token starting at the gap lies behind it,the end of the text only when the gap is not parked there
+	const char *IncrementalLexer::GetTextPointer(uint64_t pos) const
+	{
+		bool isBeforeGap = pos < m_GapBegin || m_GapEnd == m_Buffer.size();
+		return m_Buffer.data() + (isBeforeGap ? pos : pos + (m_GapEnd - m_GapBegin));
+	}
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <string_view>
+#include "Token.h"
+#include "Lexer.h"
+namespace NajaLang
+{
+    struct TextEdit
+    {
+        uint64_t offset;
+        uint64_t removedLength;
+        std::string_view insertedText;
+    };
+
+    // the tokens an edit replaced:[firstToken,firstToken+removedCount) of the old stream became
+    // [firstToken,firstToken+insertedCount) of the new one
+    struct TokenChange
+    {
+        uint64_t firstToken;
+        uint64_t removedCount;
+        uint64_t insertedCount;
+    };
+
+    // keeps an editable source with its token stream.An edit rescans from the last token it can affect until the new
+    // tokens line up with the old stream again.
+    // The source is a gap buffer:an edit moves the gap to its offset,so typing in one place moves nothing but the
+    // edit itself,and jumping elsewhere moves the text in between once.The tokens are kept in chunks of about
+    // CHUNK_SIZE entries whose positions and lines are relative to a per chunk shift,summed in a Fenwick tree.An edit
+    // rewrites the chunks it overlaps and updates the shifts of the ones behind it in O(log chunks)
+    class IncrementalLexer
+    {
+    public:
+        IncrementalLexer();
+        ~IncrementalLexer();
+
+        void SetSource(std::string_view src);
+        TokenChange ApplyEdit(const TextEdit &edit);
+
+        // closes the gap by moving it behind the text,O(file) the first time after an edit
+        std::string_view GetSource() const;
+
+        // the last token is always TOKEN_EOF,as with Lexer::ScanTokens.Literals stay valid until the next edit or
+        // GetSource
+        uint64_t GetTokenCount() const;
+        Token GetToken(uint64_t index) const;
+        std::vector<Token> GetTokens() const;
+
+    private:
+        struct TokenEntry
+        {
+            TokenType type;
+            uint64_t pos; // offset of the literal
+            uint64_t length;
+            uint64_t line;
+            NumberType numberType;
+            TokenValue value;
+        };
+
+        // entries are off by the shift of their chunk,the sum of posDelta/lineDelta of this chunk and all before it
+        struct TokenChunk
+        {
+            std::vector<TokenEntry> entries;
+            int64_t posDelta;
+            int64_t lineDelta;
+        };
+
+        // a node of the Fenwick tree over m_Chunks,summing the entry counts and deltas of its range
+        struct ChunkSums
+        {
+            int64_t count;
+            int64_t posDelta;
+            int64_t lineDelta;
+        };
+
+        static constexpr uint64_t CHUNK_SIZE = 256;
+        static constexpr uint64_t MAX_CHUNK_SIZE = 2 * CHUNK_SIZE;
+        // text scanned past the first resynchronisation candidate before the window is grown
+        static constexpr uint64_t MIN_SCAN_WINDOW = 256;
+        static constexpr uint64_t MIN_GAP_SIZE = 1024;
+        // a token's extent can depend on this many chars behind it('1' in '1.5' needs the digit after the '.')
+        static constexpr uint64_t LOOKAHEAD_REACH = 2;
+
+        static TokenEntry MakeEntry(const Token &token, uint64_t pos, uint64_t line);
+        TokenEntry GetEntry(uint64_t index) const;
+        // first index from 'from' on whose entry satisfies pred,pred must be monotonic over the stream
+        template <typename Pred>
+        uint64_t FindFirstEntry(uint64_t from, Pred &&pred) const;
+        static uint64_t GetTokenBegin(const TokenEntry &entry);
+        static uint64_t GetTokenEnd(const TokenEntry &entry);
+
+        // the entries of chunks [firstChunk,endChunk) are replaced by entries,given with their final positions
+        void ReplaceChunks(uint64_t firstChunk, uint64_t endChunk, std::vector<TokenEntry> &entries, int64_t posDelta, int64_t lineDelta);
+        void RebuildChunkTree();
+        void AddToChunkTree(uint64_t chunk, const ChunkSums &sums);
+        // sums of chunks [0,chunkCount)
+        ChunkSums SumChunks(uint64_t chunkCount) const;
+        // chunk holding the entry index,chunkBegin receives the index of its first entry
+        uint64_t FindChunk(uint64_t index, uint64_t &chunkBegin) const;
+
+        uint64_t GetTextSize() const;
+        // moves the gap to pos,so the text before it is contiguous
+        void MoveGap(uint64_t pos) const;
+        void ReserveGap(uint64_t size);
+        const char *GetTextPointer(uint64_t pos) const;
+
+        // the gap moves on reads too,the text it holds does not change
+        mutable std::string m_Buffer;
+        mutable uint64_t m_GapBegin;
+        mutable uint64_t m_GapEnd;
+
+        std::vector<TokenChunk> m_Chunks;
+        std::vector<ChunkSums> m_ChunkTree; // 1-based
+        uint64_t m_EntryCount; // without the trailing EOF
+        uint64_t m_EndLine;
+        Lexer m_Lexer;
+    };
+}
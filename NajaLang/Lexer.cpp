@@ -1,33 +1,14 @@
 #include "Lexer.h"
-#include <unordered_map>
 #include <iostream>
+#include <algorithm>
+#include <charconv>
+#include "SimdScan.h"
+#include "SymbolTable.h"
 namespace NajaLang
 {
 
-	static std::unordered_map<std::string, TokenType> keywords =
-		{
-			{"var", TOKEN_VAR},
-			{"if", TOKEN_IF},
-			{"else", TOKEN_ELSE},
-			{"true", TOKEN_TRUE},
-			{"false", TOKEN_FALSE},
-			{"null", TOKEN_NULL},
-			{"while", TOKEN_WHILE},
-			{"for", TOKEN_FOR},
-			{"break", TOKEN_BREAK},
-			{"continue", TOKEN_CONTINUE},
-			{"function", TOKEN_FUNCTION},
-			{"class", TOKEN_CLASS},
-			{"public", TOKEN_PUBLIC},
-			{"protected", TOKEN_PROTECTED},
-			{"private", TOKEN_PRIVATE},
-			{"this", TOKEN_THIS},
-			{"base", TOKEN_BASE},
-			{"new", TOKEN_NEW},
-			{"return", TOKEN_RETURN},
-	};
-
 	Lexer::Lexer()
+		: m_SymbolCacheCount(0)
 	{
 		ResetStatus();
 	}
@@ -45,10 +26,224 @@ namespace NajaLang
 			ScanToken();
 		}
 
-		AddToken(TOKEN_EOF, "");
+		AddToken(TOKEN_EOF, m_Source.substr(m_Source.size()));
+
+		return m_Tokens;
+	}
+
+	void Lexer::ScanTokens(std::string_view src, TokenBuffer &buffer)
+	{
+		ResetStatus();
+		buffer.Reset(src);
+		if (src.size() > TokenBuffer::MAX_SOURCE_SIZE)
+		{
+			ReportError("Source is too large for a token buffer.");
+			buffer.Reset(std::string_view());
+			buffer.Add(TOKEN_EOF, 0, 0);
+			return;
+		}
+
+		m_Source = src;
+		m_TokenBuffer = &buffer;
+		while (!IsAtEnd())
+		{
+			m_StartPos = m_CurPos;
+			ScanToken();
+		}
+
+		AddToken(TOKEN_EOF, m_Source.substr(m_Source.size()));
+		m_TokenBuffer = nullptr;
+	}
+
+	void Lexer::SetSource(std::string_view src, uint64_t pos, uint64_t line)
+	{
+		ResetStatus();
+		m_Source = src;
+		m_CurPos = pos;
+		m_Line = line;
+		m_IsStreaming = true;
+	}
+
+	const Token &Lexer::NextToken()
+	{
+		FillLookahead(1);
+		const Token &token = m_Lookahead[m_LookaheadHead];
+		m_LookaheadHead = (m_LookaheadHead + 1) & (LOOKAHEAD_SIZE - 1);
+		m_LookaheadCount--;
+		return token;
+	}
+
+	const Token &Lexer::PeekToken(uint64_t distance)
+	{
+		FillLookahead(distance + 1);
+		return m_Lookahead[(m_LookaheadHead + distance) & (LOOKAHEAD_SIZE - 1)];
+	}
+
+	const Token &Lexer::GetPreToken()
+	{
+		return m_Lookahead[(m_LookaheadHead - 1) & (LOOKAHEAD_SIZE - 1)];
+	}
+
+	const std::vector<Token> &Lexer::ScanTokensParallel(std::string_view src, ThreadPool &pool)
+	{
+		static constexpr uint64_t MIN_CHUNK_SIZE = 64 * 1024;
+		if (pool.GetThreadCount() == 1 || src.size() < 2 * MIN_CHUNK_SIZE)
+			return ScanTokens(src);
+
+		//every chunk starts right after a '\n'
+		uint64_t chunkSize = std::max(MIN_CHUNK_SIZE, src.size() / (pool.GetThreadCount() * 4));
+		std::vector<uint64_t> bounds{0};
+		while (bounds.back() < src.size())
+		{
+			uint64_t pos = bounds.back() + chunkSize;
+			uint64_t newlines = 0;
+			if (pos < src.size())
+				pos = FindChar(src.data() + pos, src.data() + src.size(), '\n', newlines) - src.data() + 1;
+			bounds.emplace_back(std::min<uint64_t>(pos, src.size()));
+		}
+		uint64_t chunkCount = bounds.size() - 1;
+
+		//speculative pass:each chunk is lexed as if it began outside of any string or comment
+		//chunk lexers are kept between calls so their token buffers are reused
+		m_ChunkLexers.resize(chunkCount);
+		auto &chunks = m_ChunkLexers;
+		std::vector<uint64_t> chunkNewlines(chunkCount);
+		pool.ParallelFor(chunkCount, [&](uint64_t i)
+						 {
+			chunks[i].ResetStatus();
+			chunks[i].m_Source = src;
+			chunks[i].m_IsDeferErrors = true;
+			chunks[i].ScanRange(bounds[i], bounds[i + 1]);
+			chunkNewlines[i] = CountNewlines(src.data() + bounds[i], src.data() + bounds[i + 1]); });
+
+		//prefix pass:walk the chunks in order carrying the real scan position.A chunk whose start lies inside a
+		//token of the previous one(a string or a comment) is rescanned from the real position until it meets
+		//one of its speculative token starts again,from there on the speculative tokens are valid
+		ResetStatus();
+		m_Source = src;
+		std::vector<std::vector<Token>> fixedTokens(chunkCount);
+		std::vector<uint64_t> keepFrom(chunkCount);
+		std::vector<uint64_t> chunkFirstLine(chunkCount);
+		uint64_t pos = 0;
+		uint64_t line = 1;
+		uint64_t chunkLine = 1;
+		for (uint64_t i = 0; i < chunkCount; ++i)
+		{
+			Lexer &chunk = chunks[i];
+			chunkFirstLine[i] = chunkLine;
+			keepFrom[i] = chunk.m_Tokens.size();
+
+			if (pos == bounds[i])
+				keepFrom[i] = 0;
+			else if (pos < bounds[i + 1])
+			{
+				Lexer fixer;
+				fixer.m_Source = src;
+				fixer.m_CurPos = pos;
+				fixer.m_Line = line;
+				uint64_t resync = 0;
+				while (fixer.m_CurPos < bounds[i + 1])
+				{
+					while (resync < chunk.m_Tokens.size() && chunk.GetTokenPos(chunk.m_Tokens[resync]) < fixer.m_CurPos)
+						resync++;
+					if (resync < chunk.m_Tokens.size() && chunk.GetTokenPos(chunk.m_Tokens[resync]) == fixer.m_CurPos)
+					{
+						keepFrom[i] = resync;
+						break;
+					}
+					fixer.m_StartPos = fixer.m_CurPos;
+					fixer.ScanToken();
+				}
+				pos = fixer.m_CurPos;
+				line = fixer.m_Line;
+				fixedTokens[i] = std::move(fixer.m_Tokens);
+			}
+
+			if (keepFrom[i] < chunk.m_Tokens.size() || pos == bounds[i])
+			{
+				pos = chunk.m_CurPos;
+				line = chunk.m_Line + chunkLine - 1;
+			}
+
+			for (const auto &err : chunk.m_DeferredErrors)
+				if (err.tokenIndex >= keepFrom[i])
+					std::cout << "[line " << err.line + chunkLine - 1 << "]:" << err.message << std::endl;
+
+			chunkLine += chunkNewlines[i];
+		}
+
+		std::vector<uint64_t> outOffsets(chunkCount + 1, 0);
+		for (uint64_t i = 0; i < chunkCount; ++i)
+			outOffsets[i + 1] = outOffsets[i] + fixedTokens[i].size() + chunks[i].m_Tokens.size() - keepFrom[i];
+
+		m_Tokens.resize(outOffsets.back());
+		pool.ParallelFor(chunkCount, [&](uint64_t i)
+						 {
+			Token *out = m_Tokens.data() + outOffsets[i];
+			out = std::copy(fixedTokens[i].begin(), fixedTokens[i].end(), out);
+			for (uint64_t j = keepFrom[i]; j < chunks[i].m_Tokens.size(); ++j, ++out)
+			{
+				*out = chunks[i].m_Tokens[j];
+				out->line += chunkFirstLine[i] - 1;
+			} });
 
+		m_CurPos = src.size();
+		m_Line = line;
+		AddToken(TOKEN_EOF, m_Source.substr(m_Source.size()));
 		return m_Tokens;
 	}
+
+	void Lexer::ScanRange(uint64_t begin, uint64_t end)
+	{
+		m_CurPos = begin;
+		while (m_CurPos < end)
+		{
+			m_StartPos = m_CurPos;
+			ScanToken();
+		}
+	}
+
+	uint64_t Lexer::GetTokenPos(const Token &token)
+	{
+		//string literals exclude the opening quote
+		return token.literal.data() - m_Source.data() - (token.type == TOKEN_STRING ? 1 : 0);
+	}
+
+	void Lexer::DeferErrors()
+	{
+		m_IsDeferErrors = true;
+	}
+
+	void Lexer::ReportDeferredErrors(uint64_t end)
+	{
+		for (const auto &err : m_DeferredErrors)
+			if (err.pos < end)
+				std::cout << "[line " << err.line << "]:" << err.message << std::endl;
+		m_DeferredErrors.clear();
+	}
+
+	void Lexer::ReportError(std::string_view message)
+	{
+		if (m_IsDeferErrors)
+			m_DeferredErrors.push_back({m_Tokens.size(), m_StartPos, m_Line, message});
+		else
+			std::cout << "[line " << m_Line << "]:" << message << std::endl;
+	}
+
+	void Lexer::FillLookahead(uint64_t count)
+	{
+		//a ScanToken adds at most one token,comments and whitespace add none
+		while (m_LookaheadCount < count)
+		{
+			if (IsAtEnd())
+			{
+				AddToken(TOKEN_EOF, m_Source.substr(m_Source.size()));
+				continue;
+			}
+			m_StartPos = m_CurPos;
+			ScanToken();
+		}
+	}
 	void Lexer::ScanToken()
 	{
 		char c = GetCurCharAndStepOnce();
@@ -94,9 +289,10 @@ namespace NajaLang
 		case ' ':
 		case '\t':
 		case '\r':
-			break;
 		case '\n':
-			m_Line++;
+			if (c == '\n')
+				m_Line++;
+			m_CurPos = SkipWhitespace(m_Source.data() + m_CurPos, m_Source.data() + m_Source.size(), m_Line) - m_Source.data();
 			break;
 		case '+':
 			if (IsMatchCurCharAndStepOnce('+'))
@@ -125,24 +321,18 @@ namespace NajaLang
 				AddToken(TOKEN_SLASH_EQUAL);
 			else if (IsMatchCurCharAndStepOnce('/'))
 			{
-				while (!IsMatchCurChar('\n') && !IsAtEnd())
-					GetCurCharAndStepOnce();
-				m_Line++;
+				//the '\n' is left for the whitespace case to count
+				uint64_t newlines = 0;
+				m_CurPos = FindChar(m_Source.data() + m_CurPos, m_Source.data() + m_Source.size(), '\n', newlines) - m_Source.data();
 			}
 			else if (IsMatchCurCharAndStepOnce('*'))
 			{
 				while (!IsAtEnd())
 				{
-					if (IsMatchCurChar('\n'))
-						m_Line++;
-					else if (IsMatchCurChar('*') && IsMatchNextChar('/'))
-					{
-						GetCurCharAndStepOnce();
-						GetCurCharAndStepOnce();
+					m_CurPos = FindChar(m_Source.data() + m_CurPos, m_Source.data() + m_Source.size(), '*', m_Line) - m_Source.data();
+					GetCurCharAndStepOnce();
+					if (IsMatchCurCharAndStepOnce('/'))
 						break;
-					}
-					else
-						GetCurCharAndStepOnce();
 				}
 			}
 			else
@@ -232,7 +422,12 @@ namespace NajaLang
 	{
 		m_StartPos = m_CurPos = 0;
 		m_Line = 1;
-		std::vector<Token>().swap(m_Tokens);
+		m_Tokens.clear();
+		m_TokenBuffer = nullptr;
+		m_IsStreaming = false;
+		m_IsDeferErrors = false;
+		m_DeferredErrors.clear();
+		m_LookaheadHead = m_LookaheadCount = 0;
 	}
 
 	bool Lexer::IsMatchCurChar(char c)
@@ -287,12 +482,26 @@ namespace NajaLang
 
 	void Lexer::AddToken(TokenType type)
 	{
-		auto literal = m_Source.substr(m_StartPos, m_CurPos - m_StartPos);
-		m_Tokens.emplace_back(Token(type, literal, m_Line));
+		AddToken(type, m_Source.substr(m_StartPos, m_CurPos - m_StartPos));
 	}
 	void Lexer::AddToken(TokenType type, std::string_view literal)
 	{
-		m_Tokens.emplace_back(Token(type, literal, m_Line));
+		AddToken(Token(type, literal, m_Line));
+	}
+	void Lexer::AddToken(const Token &token)
+	{
+		if (m_TokenBuffer)
+		{
+			uint32_t start = (uint32_t)(token.literal.data() - m_Source.data());
+			if (token.type == TOKEN_NUMBER || token.type == TOKEN_IDENTIFIER)
+				m_TokenBuffer->AddWithValue(start, (uint32_t)token.literal.size(), token);
+			else
+				m_TokenBuffer->Add(token.type, start, (uint32_t)token.literal.size());
+		}
+		else if (m_IsStreaming)
+			m_Lookahead[(m_LookaheadHead + m_LookaheadCount++) & (LOOKAHEAD_SIZE - 1)] = token;
+		else
+			m_Tokens.push_back(token);
 	}
 
 	bool Lexer::IsAtEnd()
@@ -304,67 +513,179 @@ namespace NajaLang
 	{
 		return c >= '0' && c <= '9';
 	}
-	bool Lexer::IsLetter(char c)
+	bool Lexer::IsHexNumber(char c)
 	{
-		return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_';
+		return IsNumber(c) || ((c | 0x20) >= 'a' && (c | 0x20) <= 'f');
 	}
-	bool Lexer::IsLetterOrNumber(char c)
+	bool Lexer::IsLetter(char c)
 	{
-		return IsLetter(c) || IsNumber(c);
+		return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_';
 	}
 
 	void Lexer::Number()
 	{
+		if (m_Source[m_StartPos] == '0' && (IsMatchCurChar('x') || IsMatchCurChar('X') || IsMatchCurChar('b') || IsMatchCurChar('B')))
+		{
+			bool isHex = (GetCurCharAndStepOnce() | 0x20) == 'x';
+			uint64_t digitsPos = m_CurPos;
+			while (isHex ? IsHexNumber(GetCurChar()) : (GetCurChar() == '0' || GetCurChar() == '1'))
+				GetCurCharAndStepOnce();
+
+			Token token(TOKEN_NUMBER, m_Source.substr(m_StartPos, m_CurPos - m_StartPos), m_Line);
+			DecodeInteger(m_Source.substr(digitsPos, m_CurPos - digitsPos), isHex ? 16 : 2, token);
+			AddToken(token);
+			return;
+		}
+
 		while (IsNumber(GetCurChar()))
 			GetCurCharAndStepOnce();
 
-		if (IsMatchCurCharAndStepOnce('.'))
+		//'1.' is a number followed by a dot,the dot is left for the next token
+		bool isFloat = IsMatchCurChar('.') && IsNumber(GetNextChar());
+		if (isFloat)
 		{
-			if (IsNumber(GetCurChar()))
-				while (IsNumber(GetCurChar()))
-					GetCurCharAndStepOnce();
-			else
-			{
-				AddToken(TOKEN_NUMBER, m_Source.substr(m_StartPos, m_CurPos - m_StartPos - 1));
-				AddToken(TOKEN_DOT, m_Source.substr(m_CurPos - 1, 1));
-				return;
-			}
+			GetCurCharAndStepOnce();
+			while (IsNumber(GetCurChar()))
+				GetCurCharAndStepOnce();
 		}
 
-		AddToken(TOKEN_NUMBER);
+		Token token(TOKEN_NUMBER, m_Source.substr(m_StartPos, m_CurPos - m_StartPos), m_Line);
+		if (isFloat)
+			DecodeFloat(token.literal, token);
+		else
+			DecodeInteger(token.literal, 10, token);
+		AddToken(token);
 	}
 
-	void Lexer::Identifier()
+	void Lexer::DecodeInteger(std::string_view digits, int base, Token &token)
 	{
-		while (IsLetterOrNumber(GetCurChar()))
-			GetCurCharAndStepOnce();
+		token.numberType = NUMBER_INT;
+		token.value.intValue = 0;
+		if (digits.empty())
+		{
+			ReportError(base == 16 ? "Expect hex digits after '0x'." : "Expect binary digits after '0b'.");
+			return;
+		}
+
+		//hex and binary literals may use all 64 bits,decimal ones must fit in int64_t
+		uint64_t value = 0;
+		auto result = std::from_chars(digits.data(), digits.data() + digits.size(), value, base);
+		if (result.ec == std::errc::result_out_of_range || (base == 10 && value > (uint64_t)INT64_MAX))
+		{
+			ReportError("Integer literal is out of range.");
+			return;
+		}
+		token.value.intValue = (int64_t)value;
+	}
 
-		std::string literal = m_Source.substr(m_StartPos, m_CurPos - m_StartPos);
+	void Lexer::DecodeFloat(std::string_view literal, Token &token)
+	{
+		//powers of ten which are exact in a double
+		static constexpr double exactPowersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+													  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
 
-		bool isKeyWord = false;
-		for (const auto &[key,value] : keywords)
-			if (key.compare(literal) == 0)
+		token.numberType = NUMBER_FLOAT;
+
+		//Clinger's fast path:a mantissa below 2^53 divided by an exact power of ten is correctly rounded
+		uint64_t mantissa = 0;
+		uint64_t significantDigits = 0;
+		uint64_t fractionDigits = 0;
+		bool isInFraction = false;
+		for (char c : literal)
+		{
+			if (c == '.')
 			{
-				AddToken(value, literal);
-				isKeyWord = true;
-				break;
+				isInFraction = true;
+				continue;
 			}
+			if (isInFraction)
+				fractionDigits++;
+			if (mantissa == 0 && c == '0')
+				continue;
+			if (++significantDigits > 19)
+				break;
+			mantissa = mantissa * 10 + (c - '0');
+		}
 
-		if (!isKeyWord)
-			AddToken(TOKEN_IDENTIFIER, literal);
+		if (significantDigits <= 19 && mantissa <= (1ull << 53) && fractionDigits <= 22)
+		{
+			token.value.floatValue = (double)mantissa / exactPowersOfTen[fractionDigits];
+			return;
+		}
+
+		double value = 0.0;
+		std::from_chars(literal.data(), literal.data() + literal.size(), value);
+		token.value.floatValue = value;
 	}
 
-	void Lexer::String()
+	void Lexer::Identifier()
+	{
+		m_CurPos = SkipIdentifier(m_Source.data() + m_CurPos, m_Source.data() + m_Source.size()) - m_Source.data();
+
+		std::string_view literal = m_Source.substr(m_StartPos, m_CurPos - m_StartPos);
+		Token token(GetKeywordType(literal), literal, m_Line);
+		if (token.type == TOKEN_IDENTIFIER)
+			token.value.symbol = InternSymbol(token.literal);
+		AddToken(token);
+	}
+
+	uint32_t Lexer::InternSymbol(std::string_view name)
 	{
-		while (!IsMatchCurChar('\"') && !IsAtEnd())
+		//names seen before are resolved without touching the shared table's lock
+		uint64_t hash = HashName(name);
+		uint64_t mask = m_SymbolCache.size() - 1;
+		if (!m_SymbolCache.empty())
+			for (uint64_t i = hash & mask; m_SymbolCache[i].name; i = (i + 1) & mask)
+				if (m_SymbolCache[i].length == name.size() && std::string_view(m_SymbolCache[i].name, name.size()) == name)
+					return m_SymbolCache[i].symbol;
+
+		SymbolTable &symbolTable = GetSymbolTable();
+		uint32_t symbol = symbolTable.Intern(name);
+
+		//kept at most half full
+		if ((m_SymbolCacheCount + 1) * 2 > m_SymbolCache.size())
 		{
-			if (IsMatchCurChar('\n'))
-				m_Line++;
-			GetCurCharAndStepOnce();
+			std::vector<SymbolCacheSlot> oldSlots(std::max<uint64_t>(m_SymbolCache.size() * 2, 256), {nullptr, 0, 0});
+			oldSlots.swap(m_SymbolCache);
+			mask = m_SymbolCache.size() - 1;
+			for (const auto &slot : oldSlots)
+				if (slot.name)
+				{
+					uint64_t i = HashName(std::string_view(slot.name, slot.length)) & mask;
+					while (m_SymbolCache[i].name)
+						i = (i + 1) & mask;
+					m_SymbolCache[i] = slot;
+				}
 		}
 
+		uint64_t i = hash & mask;
+		while (m_SymbolCache[i].name)
+			i = (i + 1) & mask;
+		m_SymbolCache[i] = {symbolTable.GetName(symbol).data(), (uint32_t)name.size(), symbol};
+		m_SymbolCacheCount++;
+		return symbol;
+	}
+
+	uint64_t Lexer::HashName(std::string_view name)
+	{
+		//FNV-1a,identifiers are short enough that a byte loop is cheaper than a block hash's setup
+		uint64_t hash = 14695981039346656037ull;
+		for (char c : name)
+			hash = (hash ^ (uint8_t)c) * 1099511628211ull;
+		return hash ^ (hash >> 32);
+	}
+
+	void Lexer::String()
+	{
+		m_CurPos = FindChar(m_Source.data() + m_CurPos, m_Source.data() + m_Source.size(), '\"', m_Line) - m_Source.data();
+
 		if (IsAtEnd())
-			std::cout << "[line " << m_Line << "]:Uniterminated string." << std::endl;
+		{
+			//the literal runs to the end of the source,there is no closing quote to leave out
+			ReportError("Uniterminated string.");
+			AddToken(TOKEN_STRING, m_Source.substr(m_StartPos + 1));
+			return;
+		}
 
 		GetCurCharAndStepOnce(); //eat the second '\"'
 
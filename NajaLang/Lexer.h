@@ -1,9 +1,12 @@
 #pragma once
 #include <cstdint>
 #include <vector>
-#include <string>
+#include <array>
+#include <string_view>
 
 #include "Token.h"
+#include "ThreadPool.h"
+#include "TokenBuffer.h"
 namespace NajaLang
 {
     class Lexer
@@ -12,8 +15,47 @@ namespace NajaLang
         Lexer();
         ~Lexer();
 
-       const std::vector<Token>& ScanTokens(std::string_view src);
+        // tokens refer to src in place,the caller must keep it alive while the tokens are in use
+        const std::vector<Token> &ScanTokens(std::string_view src);
+        // same tokens written straight into a compact buffer,sources above TokenBuffer::MAX_SOURCE_SIZE are rejected
+        void ScanTokens(std::string_view src, TokenBuffer &buffer);
+
+        // pull based scanning:tokens are produced on demand into a small lookahead ring instead of a vector,
+        // so only a few tokens are alive at any time.EOF is returned forever once the source is exhausted
+        void SetSource(std::string_view src, uint64_t pos = 0, uint64_t line = 1);
+        const Token &NextToken();
+        // distance must be below LOOKAHEAD_SIZE-2,the previous token stays readable until the ring wraps
+        const Token &PeekToken(uint64_t distance = 0);
+        const Token &GetPreToken();
+
+        // offset of the first char of a token scanned from the current source,including a string's opening quote
+        uint64_t GetTokenPos(const Token &token);
+
+        // for pull based scanning of a prefix of a longer text,where a token cut off at the end of src is no error:
+        // errors are held back until ReportDeferredErrors prints the ones of tokens starting before end and drops the
+        // rest.SetSource turns deferring off again
+        void DeferErrors();
+        void ReportDeferredErrors(uint64_t end);
+
+        static constexpr uint64_t LOOKAHEAD_SIZE = 8;
+
+        // splits src at newline boundaries and lexes the chunks on pool,the result is identical to ScanTokens(src).
+        // Small sources are scanned serially
+        const std::vector<Token> &ScanTokensParallel(std::string_view src, ThreadPool &pool);
+
     private:
+        struct DeferredError
+        {
+            uint64_t tokenIndex;
+            uint64_t pos; // start of the token
+            uint64_t line;
+            std::string_view message;
+        };
+
+        void ScanRange(uint64_t begin, uint64_t end);
+        void ReportError(std::string_view message);
+
+        void FillLookahead(uint64_t count);
 
         void ScanToken();
 
@@ -31,21 +73,50 @@ namespace NajaLang
 
         void AddToken(TokenType type);
         void AddToken(TokenType type,std::string_view literal);
+        void AddToken(const Token &token);
 
         bool IsAtEnd();
 
         bool IsNumber(char c);
         bool IsLetter(char c);
-        bool IsLetterOrNumber(char c);
+        bool IsHexNumber(char c);
 
         void Number();
+        void DecodeInteger(std::string_view digits, int base, Token &token);
+        void DecodeFloat(std::string_view literal, Token &token);
         void Identifier();
+        uint32_t InternSymbol(std::string_view name);
+        static uint64_t HashName(std::string_view name);
         void String();
 
         uint64_t m_StartPos;
         uint64_t m_CurPos;
         uint64_t m_Line;
-        std::string m_Source;
+        std::string_view m_Source;
         std::vector<Token> m_Tokens;
+
+        //speculative chunk lexers keep their errors until they are known to be real
+        bool m_IsDeferErrors;
+        std::vector<DeferredError> m_DeferredErrors;
+
+        std::vector<Lexer> m_ChunkLexers;
+
+        //symbols this lexer has already interned,kept across scans since symbols never change.Open addressing
+        //with linear probing,names refer to the symbol table's storage
+        struct SymbolCacheSlot
+        {
+            const char *name;
+            uint32_t length;
+            uint32_t symbol;
+        };
+        std::vector<SymbolCacheSlot> m_SymbolCache;
+        uint64_t m_SymbolCacheCount;
+
+        TokenBuffer *m_TokenBuffer;
+
+        bool m_IsStreaming;
+        std::array<Token, LOOKAHEAD_SIZE> m_Lookahead;
+        uint64_t m_LookaheadHead;
+        uint64_t m_LookaheadCount;
     };
 }
\ No newline at end of file
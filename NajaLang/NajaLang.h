@@ -1,9 +1,19 @@
 #pragma once
 
 #include "Token.h"
+#include "TokenBuffer.h"
 #include "Chunk.h"
 #include "Object.h"
+#include "Value.h"
+#include "SourceFile.h"
+#include "SymbolTable.h"
+#include "IncrementalLexer.h"
 #include "Lexer.h"
+#include "AstVisitor.h"
+#include "AstPrinter.h"
+#include "FlatAst.h"
 #include "Parser.h"
+#include "AstCache.h"
+#include "ConstantFolder.h"
 #include "Compiler.h"
 #include "VM.h"
\ No newline at end of file
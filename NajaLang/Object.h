@@ -5,12 +5,8 @@ namespace NajaLang
 {
     enum ObjectType
     {
-        INT_NUM_OBJECT,
-        FLOAT_NUM_OBJECT,
+        INT_NUM_OBJECT, // only ints too wide for a small int Value
         STR_OBJECT,
-        TRUE_OBJECT,
-        FALSE_OBJECT,
-        NULL_OBJECT,
     };
 
     struct Object
@@ -40,24 +36,6 @@ namespace NajaLang
         int64_t value;
     };
 
-    struct FloatNumObject : public Object
-    {
-        FloatNumObject() {}
-        FloatNumObject(double value) : value(value) {}
-        ~FloatNumObject() {}
-
-        std::string Stringify()
-        {
-            return std::to_string(value);
-        }
-        ObjectType Type()
-        {
-            return FLOAT_NUM_OBJECT;
-        }
-
-        double value;
-    };
-
     struct StrObject : public Object
     {
         StrObject() {}
@@ -75,49 +53,4 @@ namespace NajaLang
 
         std::string value;
     };
-
-    struct TrueObject : public Object
-    {
-        TrueObject() {}
-        ~TrueObject() {}
-
-        std::string Stringify()
-        {
-            return "true";
-        }
-        ObjectType Type()
-        {
-            return TRUE_OBJECT;
-        }
-    };
-
-    struct FalseObject : public Object
-    {
-        FalseObject() {}
-        ~FalseObject() {}
-
-        std::string Stringify()
-        {
-            return "false";
-        }
-        ObjectType Type()
-        {
-            return FALSE_OBJECT;
-        }
-    };
-
-    struct NullObject : public Object
-    {
-        NullObject() {}
-        ~NullObject() {}
-
-        std::string Stringify()
-        {
-            return "null";
-        }
-        ObjectType Type()
-        {
-            return NULL_OBJECT;
-        }
-    };
 }
@@ -1,152 +1,297 @@
 #include "Parser.h"
 #include <iostream>
 #include "Constant.h"
+#include "SymbolTable.h"
 namespace NajaLang
 {
-	std::unordered_map<TokenType, PrefixFn> Parser::m_PrefixFunctions =
-		{
-			{TOKEN_IDENTIFIER, &Parser::ParseIdentifierExpr},
-			{TOKEN_NUMBER, &Parser::ParseNumExpr},
-			{TOKEN_STRING, &Parser::ParseStrExpr},
-			{TOKEN_NULL, &Parser::ParseNullExpr},
-			{TOKEN_TRUE, &Parser::ParseTrueExpr},
-			{TOKEN_FALSE, &Parser::ParseFalseExpr},
-			{TOKEN_MINUS, &Parser::ParsePrefixExpr},
-			{TOKEN_BANG, &Parser::ParsePrefixExpr},
-			{TOKEN_TILDE, &Parser::ParsePrefixExpr},
-			{TOKEN_AMPERSAND, &Parser::ParsePrefixExpr},
-			{TOKEN_PLUS_PLUS, &Parser::ParsePrefixExpr},
-			{TOKEN_MINUS_MINUS, &Parser::ParsePrefixExpr},
-			{TOKEN_LEFT_PAREN, &Parser::ParseGroupExpr},
-			{TOKEN_FUNCTION, &Parser::ParseFunctionExpr},
-			{TOKEN_LEFT_BRACKET, &Parser::ParseArrayExpr},
-			{TOKEN_LEFT_BRACE, &Parser::ParseTableExpr},
-			{TOKEN_THIS, &Parser::ParseThisExpr},
-			{TOKEN_BASE, &Parser::ParseBaseExpr},
-			{TOKEN_NEW, &Parser::ParseNewExpr},
-
-	};
-
-	std::unordered_map<TokenType, InfixFn> Parser::m_InfixFunctions =
-		{
-			{TOKEN_EQUAL, &Parser::ParseInfixExpr},
-			{TOKEN_PLUS_EQUAL, &Parser::ParseInfixExpr},
-			{TOKEN_MINUS_EQUAL, &Parser::ParseInfixExpr},
-			{TOKEN_ASTERISK_EQUAL, &Parser::ParseInfixExpr},
-			{TOKEN_SLASH_EQUAL, &Parser::ParseInfixExpr},
-			{TOKEN_PERCENT_EQUAL, &Parser::ParseInfixExpr},
-			{TOKEN_AMPERSAND_EQUAL, &Parser::ParseInfixExpr},
-			{TOKEN_CARET_EQUAL, &Parser::ParseInfixExpr},
-			{TOKEN_VBAR_EQUAL, &Parser::ParseInfixExpr},
-			{TOKEN_LESS_LESS_EQUAL, &Parser::ParseInfixExpr},
-			{TOKEN_GREATER_GREATER_EQUAL, &Parser::ParseInfixExpr},
+	//dense tables indexed by TokenType,built at compile time
+	constexpr std::array<PrefixFn, TOKEN_TYPE_COUNT> Parser::m_PrefixFunctions = []
+	{
+		std::array<PrefixFn, TOKEN_TYPE_COUNT> table{}; // nullptr:no prefix rule
+		table[TOKEN_IDENTIFIER] = &Parser::ParseIdentifierExpr;
+		table[TOKEN_NUMBER] = &Parser::ParseNumExpr;
+		table[TOKEN_STRING] = &Parser::ParseStrExpr;
+		table[TOKEN_NULL] = &Parser::ParseNullExpr;
+		table[TOKEN_TRUE] = &Parser::ParseTrueExpr;
+		table[TOKEN_FALSE] = &Parser::ParseFalseExpr;
+		table[TOKEN_MINUS] = &Parser::ParsePrefixExpr;
+		table[TOKEN_BANG] = &Parser::ParsePrefixExpr;
+		table[TOKEN_TILDE] = &Parser::ParsePrefixExpr;
+		table[TOKEN_AMPERSAND] = &Parser::ParsePrefixExpr;
+		table[TOKEN_PLUS_PLUS] = &Parser::ParsePrefixExpr;
+		table[TOKEN_MINUS_MINUS] = &Parser::ParsePrefixExpr;
+		table[TOKEN_LEFT_PAREN] = &Parser::ParseGroupExpr;
+		table[TOKEN_FUNCTION] = &Parser::ParseFunctionExpr;
+		table[TOKEN_LEFT_BRACKET] = &Parser::ParseArrayExpr;
+		table[TOKEN_LEFT_BRACE] = &Parser::ParseTableExpr;
+		table[TOKEN_THIS] = &Parser::ParseThisExpr;
+		table[TOKEN_BASE] = &Parser::ParseBaseExpr;
+		table[TOKEN_NEW] = &Parser::ParseNewExpr;
+		return table;
+	}();
+
+	constexpr std::array<InfixFn, TOKEN_TYPE_COUNT> Parser::m_InfixFunctions = []
+	{
+		std::array<InfixFn, TOKEN_TYPE_COUNT> table{}; // nullptr:no infix rule
+		table[TOKEN_EQUAL] = &Parser::ParseInfixExpr;
+		table[TOKEN_PLUS_EQUAL] = &Parser::ParseInfixExpr;
+		table[TOKEN_MINUS_EQUAL] = &Parser::ParseInfixExpr;
+		table[TOKEN_ASTERISK_EQUAL] = &Parser::ParseInfixExpr;
+		table[TOKEN_SLASH_EQUAL] = &Parser::ParseInfixExpr;
+		table[TOKEN_PERCENT_EQUAL] = &Parser::ParseInfixExpr;
+		table[TOKEN_AMPERSAND_EQUAL] = &Parser::ParseInfixExpr;
+		table[TOKEN_CARET_EQUAL] = &Parser::ParseInfixExpr;
+		table[TOKEN_VBAR_EQUAL] = &Parser::ParseInfixExpr;
+		table[TOKEN_LESS_LESS_EQUAL] = &Parser::ParseInfixExpr;
+		table[TOKEN_GREATER_GREATER_EQUAL] = &Parser::ParseInfixExpr;
+
+		table[TOKEN_QUESTION] = &Parser::ParseTernaryExpr;
+
+		table[TOKEN_VBAR_VBAR] = &Parser::ParseInfixExpr;
+		table[TOKEN_AMPERSAND_AMPERSAND] = &Parser::ParseInfixExpr;
+
+		table[TOKEN_VBAR] = &Parser::ParseInfixExpr;
+		table[TOKEN_CARET] = &Parser::ParseInfixExpr;
+		table[TOKEN_AMPERSAND] = &Parser::ParseInfixExpr;
+
+		table[TOKEN_EQUAL_EQUAL] = &Parser::ParseInfixExpr;
+		table[TOKEN_BANG_EQUAL] = &Parser::ParseInfixExpr;
+
+		table[TOKEN_LESS] = &Parser::ParseInfixExpr;
+		table[TOKEN_LESS_EQUAL] = &Parser::ParseInfixExpr;
+		table[TOKEN_GREATER] = &Parser::ParseInfixExpr;
+		table[TOKEN_GREATER_EQUAL] = &Parser::ParseInfixExpr;
+
+		table[TOKEN_LESS_LESS] = &Parser::ParseInfixExpr;
+		table[TOKEN_GREATER_GREATER] = &Parser::ParseInfixExpr;
+
+		table[TOKEN_PLUS] = &Parser::ParseInfixExpr;
+		table[TOKEN_MINUS] = &Parser::ParseInfixExpr;
+		table[TOKEN_ASTERISK] = &Parser::ParseInfixExpr;
+		table[TOKEN_SLASH] = &Parser::ParseInfixExpr;
+		table[TOKEN_PERCENT] = &Parser::ParseInfixExpr;
+
+		table[TOKEN_LEFT_PAREN] = &Parser::ParseFunctionCallExpr;
+		table[TOKEN_DOT] = &Parser::ParseClassCallExpr;
+		return table;
+	}();
+
+	constexpr std::array<PostfixFn, TOKEN_TYPE_COUNT> Parser::m_PostfixFunctions = []
+	{
+		std::array<PostfixFn, TOKEN_TYPE_COUNT> table{}; // nullptr:no postfix rule
+		table[TOKEN_PLUS_PLUS] = &Parser::ParsePostfixExpr;
+		table[TOKEN_MINUS_MINUS] = &Parser::ParsePostfixExpr;
+		table[TOKEN_LEFT_BRACKET] = &Parser::ParseIndexExpr;
+		return table;
+	}();
+
+	constexpr std::array<Precedence, TOKEN_TYPE_COUNT> Parser::m_Precedence = []
+	{
+		std::array<Precedence, TOKEN_TYPE_COUNT> table{}; // LOWEST:not an operator
+		table[TOKEN_EQUAL] = ASSIGN;
+		table[TOKEN_PLUS_EQUAL] = ASSIGN;
+		table[TOKEN_MINUS_EQUAL] = ASSIGN;
+		table[TOKEN_ASTERISK_EQUAL] = ASSIGN;
+		table[TOKEN_SLASH_EQUAL] = ASSIGN;
+		table[TOKEN_PERCENT_EQUAL] = ASSIGN;
+		table[TOKEN_AMPERSAND_EQUAL] = ASSIGN;
+		table[TOKEN_CARET_EQUAL] = ASSIGN;
+		table[TOKEN_VBAR_EQUAL] = ASSIGN;
+		table[TOKEN_LESS_LESS_EQUAL] = ASSIGN;
+		table[TOKEN_GREATER_GREATER_EQUAL] = ASSIGN;
 
-			{TOKEN_QUESTION, &Parser::ParseTernaryExpr},
+		table[TOKEN_QUESTION] = TERNARY;
+		table[TOKEN_COLON] = TERNARY;
 
-			{TOKEN_VBAR_VBAR, &Parser::ParseInfixExpr},
-			{TOKEN_AMPERSAND_AMPERSAND, &Parser::ParseInfixExpr},
+		table[TOKEN_VBAR_VBAR] = LOGIC_OR;
 
-			{TOKEN_VBAR, &Parser::ParseInfixExpr},
-			{TOKEN_CARET, &Parser::ParseInfixExpr},
-			{TOKEN_AMPERSAND, &Parser::ParseInfixExpr},
+		table[TOKEN_AMPERSAND_AMPERSAND] = LOGIC_AND;
 
-			{TOKEN_EQUAL_EQUAL, &Parser::ParseInfixExpr},
-			{TOKEN_BANG_EQUAL, &Parser::ParseInfixExpr},
+		table[TOKEN_VBAR] = BIT_OR;
 
-			{TOKEN_LESS, &Parser::ParseInfixExpr},
-			{TOKEN_LESS_EQUAL, &Parser::ParseInfixExpr},
-			{TOKEN_GREATER, &Parser::ParseInfixExpr},
-			{TOKEN_GREATER_EQUAL, &Parser::ParseInfixExpr},
+		table[TOKEN_CARET] = BIT_XOR;
 
-			{TOKEN_LESS_LESS, &Parser::ParseInfixExpr},
-			{TOKEN_GREATER_GREATER, &Parser::ParseInfixExpr},
+		table[TOKEN_AMPERSAND] = BIT_AND;
 
-			{TOKEN_PLUS, &Parser::ParseInfixExpr},
-			{TOKEN_MINUS, &Parser::ParseInfixExpr},
-			{TOKEN_ASTERISK, &Parser::ParseInfixExpr},
-			{TOKEN_SLASH, &Parser::ParseInfixExpr},
-			{TOKEN_PERCENT, &Parser::ParseInfixExpr},
+		table[TOKEN_EQUAL_EQUAL] = EQUAL;
+		table[TOKEN_BANG_EQUAL] = EQUAL;
 
-			{TOKEN_LEFT_PAREN, &Parser::ParseFunctionCallExpr},
-			{TOKEN_DOT, &Parser::ParseClassCallExpr},
+		table[TOKEN_LESS] = COMPARE;
+		table[TOKEN_LESS_EQUAL] = COMPARE;
+		table[TOKEN_GREATER] = COMPARE;
+		table[TOKEN_GREATER_EQUAL] = COMPARE;
 
-	};
+		table[TOKEN_LESS_LESS] = BIT_SHIFT;
+		table[TOKEN_GREATER_GREATER] = BIT_SHIFT;
 
-	std::unordered_map<TokenType, PostfixFn> Parser::m_PostfixFunctions = {
+		table[TOKEN_PLUS] = ADD_PLUS;
+		table[TOKEN_MINUS] = ADD_PLUS;
 
-		{TOKEN_PLUS_PLUS, &Parser::ParsePostfixExpr},
-		{TOKEN_MINUS_MINUS, &Parser::ParsePostfixExpr},
-		{TOKEN_LEFT_BRACKET, &Parser::ParseIndexExpr},
-	};
+		table[TOKEN_ASTERISK] = MUL_DIV_MOD;
+		table[TOKEN_SLASH] = MUL_DIV_MOD;
+		table[TOKEN_PERCENT] = MUL_DIV_MOD;
 
-	std::unordered_map<TokenType, Precedence> Parser::m_Precedence = {
+		table[TOKEN_LEFT_BRACKET] = INFIX;
+		table[TOKEN_LEFT_PAREN] = INFIX;
 
-		{TOKEN_EQUAL, ASSIGN},
-		{TOKEN_PLUS_EQUAL, ASSIGN},
-		{TOKEN_MINUS_EQUAL, ASSIGN},
-		{TOKEN_ASTERISK_EQUAL, ASSIGN},
-		{TOKEN_SLASH_EQUAL, ASSIGN},
-		{TOKEN_PERCENT_EQUAL, ASSIGN},
-		{TOKEN_AMPERSAND_EQUAL, ASSIGN},
-		{TOKEN_CARET_EQUAL, ASSIGN},
-		{TOKEN_VBAR_EQUAL, ASSIGN},
-		{TOKEN_LESS_LESS_EQUAL, ASSIGN},
-		{TOKEN_GREATER_GREATER_EQUAL, ASSIGN},
+		table[TOKEN_PLUS_PLUS] = POSTFIX;
+		table[TOKEN_MINUS_MINUS] = POSTFIX;
 
-		{TOKEN_QUESTION, TERNARY},
-		{TOKEN_COLON, TERNARY},
+		table[TOKEN_DOT] = CLASS_CALL;
+		return table;
+	}();
 
-		{TOKEN_VBAR_VBAR, LOGIC_OR},
+	constexpr std::array<Operator, TOKEN_TYPE_COUNT> Parser::m_PrefixOperators = []
+	{
+		std::array<Operator, TOKEN_TYPE_COUNT> table{};
+		table.fill(OPERATOR_UNDEFINED);
+		table[TOKEN_MINUS] = OPERATOR_NEGATE;
+		table[TOKEN_BANG] = OPERATOR_NOT;
+		table[TOKEN_TILDE] = OPERATOR_BIT_NOT;
+		table[TOKEN_AMPERSAND] = OPERATOR_ADDRESS;
+		table[TOKEN_PLUS_PLUS] = OPERATOR_INCREMENT;
+		table[TOKEN_MINUS_MINUS] = OPERATOR_DECREMENT;
+		return table;
+	}();
+
+	constexpr std::array<Operator, TOKEN_TYPE_COUNT> Parser::m_InfixOperators = []
+	{
+		std::array<Operator, TOKEN_TYPE_COUNT> table{};
+		table.fill(OPERATOR_UNDEFINED);
+		table[TOKEN_EQUAL] = OPERATOR_ASSIGN;
+		table[TOKEN_PLUS_EQUAL] = OPERATOR_ADD_ASSIGN;
+		table[TOKEN_MINUS_EQUAL] = OPERATOR_SUB_ASSIGN;
+		table[TOKEN_ASTERISK_EQUAL] = OPERATOR_MUL_ASSIGN;
+		table[TOKEN_SLASH_EQUAL] = OPERATOR_DIV_ASSIGN;
+		table[TOKEN_PERCENT_EQUAL] = OPERATOR_MOD_ASSIGN;
+		table[TOKEN_AMPERSAND_EQUAL] = OPERATOR_BIT_AND_ASSIGN;
+		table[TOKEN_VBAR_EQUAL] = OPERATOR_BIT_OR_ASSIGN;
+		table[TOKEN_CARET_EQUAL] = OPERATOR_BIT_XOR_ASSIGN;
+		table[TOKEN_LESS_LESS_EQUAL] = OPERATOR_SHL_ASSIGN;
+		table[TOKEN_GREATER_GREATER_EQUAL] = OPERATOR_SHR_ASSIGN;
+
+		table[TOKEN_VBAR_VBAR] = OPERATOR_LOGIC_OR;
+		table[TOKEN_AMPERSAND_AMPERSAND] = OPERATOR_LOGIC_AND;
+		table[TOKEN_VBAR] = OPERATOR_BIT_OR;
+		table[TOKEN_CARET] = OPERATOR_BIT_XOR;
+		table[TOKEN_AMPERSAND] = OPERATOR_BIT_AND;
+		table[TOKEN_EQUAL_EQUAL] = OPERATOR_EQUAL;
+		table[TOKEN_BANG_EQUAL] = OPERATOR_NOT_EQUAL;
+		table[TOKEN_LESS] = OPERATOR_LESS;
+		table[TOKEN_LESS_EQUAL] = OPERATOR_LESS_EQUAL;
+		table[TOKEN_GREATER] = OPERATOR_GREATER;
+		table[TOKEN_GREATER_EQUAL] = OPERATOR_GREATER_EQUAL;
+		table[TOKEN_LESS_LESS] = OPERATOR_SHL;
+		table[TOKEN_GREATER_GREATER] = OPERATOR_SHR;
+		table[TOKEN_PLUS] = OPERATOR_ADD;
+		table[TOKEN_MINUS] = OPERATOR_SUB;
+		table[TOKEN_ASTERISK] = OPERATOR_MUL;
+		table[TOKEN_SLASH] = OPERATOR_DIV;
+		table[TOKEN_PERCENT] = OPERATOR_MOD;
+		return table;
+	}();
 
-		{TOKEN_AMPERSAND_AMPERSAND, LOGIC_AND},
+	Parser::Parser()
+		: m_Stmts(nullptr), m_Tokens(nullptr), m_TokenStream(nullptr), m_TokenBuffer(nullptr), m_EndToken(TOKEN_EOF, "", 0), m_LazyBodies(false), m_IsSpeculative(false), m_ScratchHead(0)
+	{
+	}
+	Parser::~Parser()
+	{
+	}
 
-		{TOKEN_VBAR, BIT_OR},
+	Stmt *Parser::Parse(const std::vector<Token> &tokens)
+	{
+		ResetStatus();
+		m_Tokens = &tokens;
 
-		{TOKEN_CARET, BIT_XOR},
+		return ParseAstStmts();
+	}
 
-		{TOKEN_AMPERSAND, BIT_AND},
+	Stmt *Parser::Parse(Lexer &lexer)
+	{
+		ResetStatus();
+		m_TokenStream = &lexer;
 
-		{TOKEN_EQUAL_EQUAL, EQUAL},
-		{TOKEN_BANG_EQUAL, EQUAL},
+		return ParseAstStmts();
+	}
 
-		{TOKEN_LESS, COMPARE},
-		{TOKEN_LESS_EQUAL, COMPARE},
-		{TOKEN_GREATER, COMPARE},
-		{TOKEN_GREATER_EQUAL, COMPARE},
+	Stmt *Parser::Parse(const TokenBuffer &tokens)
+	{
+		ResetStatus();
+		m_TokenBuffer = &tokens;
 
-		{TOKEN_LESS_LESS, BIT_SHIFT},
-		{TOKEN_GREATER_GREATER, BIT_SHIFT},
+		return ParseAstStmts();
+	}
 
-		{TOKEN_PLUS, ADD_PLUS},
-		{TOKEN_MINUS, ADD_PLUS},
+	void Parser::ParseFlat(const std::vector<Token> &tokens, FlatAst &ast)
+	{
+		//the tree is gone once flattened,so there is nothing a skipped body could be parsed into later
+		bool lazyBodies = m_LazyBodies;
+		m_LazyBodies = false;
+		ast.Build(Parse(tokens));
+		m_LazyBodies = lazyBodies;
+		m_Arena.Reset();
+	}
 
-		{TOKEN_ASTERISK, MUL_DIV_MOD},
-		{TOKEN_SLASH, MUL_DIV_MOD},
-		{TOKEN_PERCENT, MUL_DIV_MOD},
+	void Parser::ParseFlat(const TokenBuffer &tokens, FlatAst &ast)
+	{
+		//the tree is gone once flattened,so there is nothing a skipped body could be parsed into later
+		bool lazyBodies = m_LazyBodies;
+		m_LazyBodies = false;
+		ast.Build(Parse(tokens));
+		m_LazyBodies = lazyBodies;
+		m_Arena.Reset();
+	}
 
-		{TOKEN_LEFT_BRACKET, INFIX},
-		{TOKEN_LEFT_PAREN, INFIX},
+	Stmt *Parser::Parse(const FlatAst &ast)
+	{
+		ResetStatus();
+		m_Stmts = (AstStmts *)ast.BuildTree(m_Arena);
+		return m_Stmts;
+	}
 
-		{TOKEN_PLUS_PLUS, POSTFIX},
-		{TOKEN_MINUS_MINUS, POSTFIX},
+	Stmt *Parser::ParseParallel(const std::vector<Token> &tokens, ThreadPool &pool)
+	{
+		ResetStatus();
+		m_Tokens = &tokens;
+		if (ParsePieces(pool))
+			return m_Stmts;
+		return Parse(tokens);
+	}
 
-		{TOKEN_DOT, CLASS_CALL},
-	};
+	Stmt *Parser::ParseParallel(const TokenBuffer &tokens, ThreadPool &pool)
+	{
+		ResetStatus();
+		m_TokenBuffer = &tokens;
+		//the newline table is built on first use,do it here before the pieces race on it
+		tokens.GetLineOfOffset(0);
+		if (ParsePieces(pool))
+			return m_Stmts;
+		return Parse(tokens);
+	}
 
-	Parser::Parser()
-		: m_Stmts(nullptr)
+	void Parser::SetLazyBodies(bool lazy)
 	{
+		m_LazyBodies = lazy;
 	}
-	Parser::~Parser()
+
+	bool Parser::IsLazyBodies() const
 	{
+		return m_LazyBodies;
 	}
 
-	Stmt *Parser::Parse(const std::vector<Token> &tokens)
+	ScopeStmt *Parser::ParseLazyBody(FunctionStmt *stmt)
 	{
-		ResetStatus();
-		m_Tokens = tokens;
+		if (!stmt->body)
+			stmt->body = ParseBodyAt(stmt->lazyBody);
+		return stmt->body;
+	}
 
-		return ParseAstStmts();
+	ScopeStmt *Parser::ParseLazyBody(FunctionExpr *expr)
+	{
+		if (!expr->body)
+			expr->body = ParseBodyAt(expr->lazyBody);
+		return expr->body;
 	}
 
 	bool Parser::HasError()
@@ -166,19 +311,113 @@ namespace NajaLang
 			std::cout << err << std::endl;
 	}
 
+	const AstArena &Parser::GetArena() const
+	{
+		return m_Arena;
+	}
+
 	void Parser::ResetStatus()
 	{
 		m_CurPos = 0;
 
-		std::vector<Token>().swap(m_Tokens);
+		m_Tokens = nullptr;
+		m_TokenStream = nullptr;
+		m_TokenBuffer = nullptr;
 		std::vector<std::string>().swap(m_ErrorMsgs);
 
-		if (m_Stmts != nullptr)
+		//the previous tree goes away with its arena blocks
+		m_Arena.Reset();
+		for (auto &piece : m_PieceParsers)
+			piece->m_Arena.Reset();
+		m_Stmts = m_Arena.New<AstStmts>();
+	}
+
+	bool Parser::ParsePieces(ThreadPool &pool)
+	{
+		static constexpr uint64_t MIN_PIECE_SIZE = 16 * 1024; //tokens
+		uint64_t tokenCount = GetTokenCount();
+		if (pool.GetThreadCount() == 1 || tokenCount < 2 * MIN_PIECE_SIZE)
+			return false;
+
+		std::vector<uint64_t> bounds = FindPieceBounds(std::max(MIN_PIECE_SIZE, tokenCount / (pool.GetThreadCount() * 4)));
+		uint64_t pieceCount = bounds.size() - 1;
+		if (pieceCount < 2)
+			return false;
+
+		//piece parsers are kept between calls so their arenas are reused
+		if (m_PieceParsers.size() < pieceCount)
+			m_PieceParsers.resize(pieceCount);
+		for (auto &piece : m_PieceParsers)
+			if (!piece)
+				piece = std::make_unique<Parser>();
+
+		std::vector<uint8_t> succeeded(pieceCount);
+		pool.ParallelFor(pieceCount, [&](uint64_t i)
+						 {
+			Parser &piece = *m_PieceParsers[i];
+			piece.ResetStatus();
+			piece.m_Tokens = m_Tokens;
+			piece.m_TokenBuffer = m_TokenBuffer;
+			piece.m_LazyBodies = m_LazyBodies;
+			piece.m_IsSpeculative = true;
+			piece.m_DeferredOutput.clear();
+			piece.m_CurPos = bounds[i];
+			while (piece.m_CurPos < (int64_t)bounds[i + 1] && !piece.IsMatchCurToken(TOKEN_EOF))
+				piece.m_Stmts->stmts.emplace_back(piece.ParseStmt());
+			succeeded[i] = piece.m_CurPos == (int64_t)bounds[i + 1]; });
+
+		for (auto ok : succeeded)
+			if (!ok)
+				return false;
+
+		//a serial parse passes every bound in the same state,so it would have produced exactly this in this order
+		for (uint64_t i = 0; i < pieceCount; ++i)
 		{
-			delete m_Stmts;
-			m_Stmts = nullptr;
+			Parser &piece = *m_PieceParsers[i];
+			m_Stmts->stmts.insert(m_Stmts->stmts.end(), piece.m_Stmts->stmts.begin(), piece.m_Stmts->stmts.end());
+			m_ErrorMsgs.insert(m_ErrorMsgs.end(), piece.m_ErrorMsgs.begin(), piece.m_ErrorMsgs.end());
+			for (const auto &output : piece.m_DeferredOutput)
+				std::cout << output << std::endl;
+		}
+		m_CurPos = bounds.back();
+		return true;
+	}
+
+	//a piece may only start where a statement must start:a 'function name' or 'class' outside of any bracket,
+	//right after a '}' or ';'.The last bound is the TOKEN_EOF
+	std::vector<uint64_t> Parser::FindPieceBounds(uint64_t pieceSize)
+	{
+		uint64_t tokenCount = GetTokenCount();
+		std::vector<uint64_t> bounds{0};
+		uint64_t depth = 0;
+		TokenType prevType = TOKEN_SEMICOLON;
+		for (uint64_t i = 0; i + 1 < tokenCount; ++i)
+		{
+			TokenType type = GetTokenType(i);
+			if (depth == 0 && i >= bounds.back() + pieceSize && (prevType == TOKEN_RIGHT_BRACE || prevType == TOKEN_SEMICOLON))
+			{
+				if (type == TOKEN_CLASS || (type == TOKEN_FUNCTION && GetTokenType(i + 1) == TOKEN_IDENTIFIER))
+					bounds.emplace_back(i);
+			}
+
+			if (type == TOKEN_LEFT_BRACE || type == TOKEN_LEFT_PAREN || type == TOKEN_LEFT_BRACKET)
+				depth++;
+			else if ((type == TOKEN_RIGHT_BRACE || type == TOKEN_RIGHT_PAREN || type == TOKEN_RIGHT_BRACKET) && depth > 0)
+				depth--; //a stray closer must not hide every later declaration
+			prevType = type;
 		}
-		m_Stmts = new AstStmts();
+		bounds.emplace_back(tokenCount - 1);
+		return bounds;
+	}
+
+	uint64_t Parser::GetTokenCount()
+	{
+		return m_TokenBuffer ? m_TokenBuffer->GetSize() : m_Tokens->size();
+	}
+
+	TokenType Parser::GetTokenType(uint64_t index)
+	{
+		return m_TokenBuffer ? m_TokenBuffer->GetType(index) : (*m_Tokens)[index].type;
 	}
 
 	Stmt *Parser::ParseAstStmts()
@@ -216,7 +455,7 @@ namespace NajaLang
 
 	Stmt *Parser::ParseExprStmt()
 	{
-		auto exprStmt = new ExprStmt(ParseExpr());
+		auto exprStmt = m_Arena.New<ExprStmt>(ParseExpr());
 		Consume(TOKEN_SEMICOLON, "Expect ';' after expr stmt.");
 		return exprStmt;
 	}
@@ -224,23 +463,23 @@ namespace NajaLang
 	Stmt *Parser::ParseVarStmt()
 	{
 		Consume(TOKEN_VAR, "Expect 'var' key word");
-		auto varStmt = new VarStmt();
+		auto varStmt = m_Arena.New<VarStmt>();
 
 		//the first variable
-		auto identifier = new IdentifierExpr(Consume(TOKEN_IDENTIFIER, "Expect valid identifier").literal);
+		auto identifier = MakeIdentifierExpr(Consume(TOKEN_IDENTIFIER, "Expect valid identifier"));
 		Expr *value = nullExpr;
 		if (IsMatchCurTokenAndStepOnce(TOKEN_EQUAL))
 			value = ParseExpr();
-		varStmt->variables[identifier] = value;
+		varStmt->variables.emplace_back(identifier, value);
 
 		//other variable
 		while (IsMatchCurTokenAndStepOnce(TOKEN_COMMA))
 		{
-			identifier = new IdentifierExpr(Consume(TOKEN_IDENTIFIER, "Expect valid identifier").literal);
+			identifier = MakeIdentifierExpr(Consume(TOKEN_IDENTIFIER, "Expect valid identifier"));
 			Expr *value = nullExpr;
 			if (IsMatchCurTokenAndStepOnce(TOKEN_EQUAL))
 				value = ParseExpr();
-			varStmt->variables[identifier] = value;
+			varStmt->variables.emplace_back(identifier, value);
 		}
 
 		Consume(TOKEN_SEMICOLON, "Expect ';' after var stmt.");
@@ -252,7 +491,7 @@ namespace NajaLang
 	{
 		Consume(TOKEN_RETURN, "Expect 'return' key word.");
 
-		auto returnStmt = new ReturnStmt();
+		auto returnStmt = m_Arena.New<ReturnStmt>();
 
 		if(!IsMatchCurToken(TOKEN_SEMICOLON))
 			returnStmt->expr=ParseExpr();
@@ -266,7 +505,7 @@ namespace NajaLang
 		Consume(TOKEN_IF, "Expect 'if' key word.");
 		Consume(TOKEN_LEFT_PAREN, "Expect '(' after 'if'.");
 
-		auto ifStmt = new IfStmt();
+		auto ifStmt = m_Arena.New<IfStmt>();
 
 		ifStmt->condition = ParseExpr();
 
@@ -283,7 +522,7 @@ namespace NajaLang
 	Stmt *Parser::ParseScopeStmt()
 	{
 		Consume(TOKEN_LEFT_BRACE, "Expect '{'.");
-		auto scopeStmt = new ScopeStmt();
+		auto scopeStmt = m_Arena.New<ScopeStmt>();
 		while (!IsMatchCurToken(TOKEN_RIGHT_BRACE))
 			scopeStmt->stmts.emplace_back(ParseStmt());
 		Consume(TOKEN_RIGHT_BRACE, "Expect '}'.");
@@ -295,7 +534,7 @@ namespace NajaLang
 		Consume(TOKEN_WHILE, "Expect 'while' keyword.");
 		Consume(TOKEN_LEFT_PAREN, "Expect '(' after 'while'.");
 
-		auto whileStmt = new WhileStmt();
+		auto whileStmt = m_Arena.New<WhileStmt>();
 
 		whileStmt->condition = ParseExpr(LOWEST);
 
@@ -327,7 +566,7 @@ namespace NajaLang
 		Consume(TOKEN_FOR, "Expect 'for' keyword.");
 		Consume(TOKEN_LEFT_PAREN, "Expect '(' after 'for'.");
 
-		auto forStmt = new ScopeStmt();
+		auto forStmt = m_Arena.New<ScopeStmt>();
 
 		if (!IsMatchCurToken(TOKEN_SEMICOLON)) //has initializer
 		{
@@ -337,9 +576,9 @@ namespace NajaLang
 			{
 				//the first exprStmt
 
-				forStmt->stmts.emplace_back(new ExprStmt(ParseExpr()));
+				forStmt->stmts.emplace_back(m_Arena.New<ExprStmt>(ParseExpr()));
 				while (IsMatchCurTokenAndStepOnce(TOKEN_COMMA))
-					forStmt->stmts.emplace_back(new ExprStmt(ParseExpr()));
+					forStmt->stmts.emplace_back(m_Arena.New<ExprStmt>(ParseExpr()));
 				Consume(TOKEN_SEMICOLON, "Expect ';' after initialize part of 'for' stmt");
 			}
 		}
@@ -351,14 +590,14 @@ namespace NajaLang
 		std::vector<ExprStmt *> independentVariables;
 		if (!IsMatchCurToken(TOKEN_RIGHT_PAREN))
 		{
-			independentVariables.emplace_back(new ExprStmt(ParseExpr()));
+			independentVariables.emplace_back(m_Arena.New<ExprStmt>(ParseExpr()));
 			while (IsMatchCurTokenAndStepOnce(TOKEN_COMMA))
-				independentVariables.emplace_back(new ExprStmt(ParseExpr()));
+				independentVariables.emplace_back(m_Arena.New<ExprStmt>(ParseExpr()));
 		}
 
 		Consume(TOKEN_RIGHT_PAREN, "Expect ')' after 'for' stmt.");
 
-		auto loopBody = new ScopeStmt();
+		auto loopBody = m_Arena.New<ScopeStmt>();
 
 		//for loop body is a scope stmt
 		if (IsMatchCurToken(TOKEN_LEFT_BRACE))
@@ -369,7 +608,7 @@ namespace NajaLang
 		for (auto &independentVariable : independentVariables)
 			loopBody->stmts.emplace_back(independentVariable);
 
-		auto whileStmt = new WhileStmt(forCondition, loopBody);
+		auto whileStmt = m_Arena.New<WhileStmt>(forCondition, loopBody);
 
 		forStmt->stmts.emplace_back(whileStmt);
 
@@ -379,7 +618,7 @@ namespace NajaLang
 	Stmt *Parser::ParseBreakStmt()
 	{
 		Consume(TOKEN_BREAK, "Expect 'break' keyword.");
-		auto breakStmt = new BreakStmt();
+		auto breakStmt = m_Arena.New<BreakStmt>();
 		Consume(TOKEN_SEMICOLON, "Expect ';' after break stmt.");
 		return breakStmt;
 	}
@@ -387,16 +626,67 @@ namespace NajaLang
 	Stmt *Parser::ParseContinueStmt()
 	{
 		Consume(TOKEN_CONTINUE, "Expect 'continue' keyword.");
-		auto continueStmt = new ContinueStmt();
+		auto continueStmt = m_Arena.New<ContinueStmt>();
 		Consume(TOKEN_SEMICOLON, "Expect ';' after continue stmt.");
 		return continueStmt;
 	}
 
+	ScopeStmt *Parser::ParseFunctionBody(LazyBody &lazyBody)
+	{
+		if (!m_LazyBodies || m_TokenStream)
+			return (ScopeStmt *)ParseScopeStmt();
+
+		lazyBody.beginToken = m_CurPos;
+		//an unterminated body keeps an empty range,the error is reported now
+		if (SkipFunctionBody())
+			lazyBody.endToken = m_CurPos;
+		else
+			lazyBody.endToken = lazyBody.beginToken;
+		return nullptr;
+	}
+
+	//only the type of each token is looked at,so with a TokenBuffer this is a scan over one byte per token
+	bool Parser::SkipFunctionBody()
+	{
+		if (!IsMatchCurToken(TOKEN_LEFT_BRACE))
+		{
+			Consume(TOKEN_LEFT_BRACE, "Expect '{'.");
+			return false;
+		}
+		StepOnce();
+		uint64_t depth = 1;
+		while (!IsAtEnd())
+		{
+			TokenType type = GetCurTokenType();
+			if (type == TOKEN_EOF)
+				break;
+			StepOnce();
+			if (type == TOKEN_LEFT_BRACE)
+				depth++;
+			else if (type == TOKEN_RIGHT_BRACE && --depth == 0)
+				return true;
+		}
+		Consume(TOKEN_RIGHT_BRACE, "Expect '}'.");
+		return false;
+	}
+
+	ScopeStmt *Parser::ParseBodyAt(const LazyBody &lazyBody)
+	{
+		if (lazyBody.endToken == lazyBody.beginToken)
+			return m_Arena.New<ScopeStmt>();
+
+		int64_t curPos = m_CurPos;
+		m_CurPos = lazyBody.beginToken;
+		auto body = (ScopeStmt *)ParseScopeStmt(); //functions nested in the body stay lazy
+		m_CurPos = curPos;
+		return body;
+	}
+
 	Stmt *Parser::ParseFunctionStmt()
 	{
 		Consume(TOKEN_FUNCTION, "Expect 'function' keyword");
 
-		auto funcStmt = new FunctionStmt();
+		auto funcStmt = m_Arena.New<FunctionStmt>();
 
 		funcStmt->name = (IdentifierExpr *)ParseIdentifierExpr();
 
@@ -414,7 +704,7 @@ namespace NajaLang
 		}
 		Consume(TOKEN_RIGHT_PAREN, "Expect ')' after function expr's '('");
 
-		funcStmt->body = (ScopeStmt *)ParseScopeStmt();
+		funcStmt->body = ParseFunctionBody(funcStmt->lazyBody);
 
 		return funcStmt;
 	}
@@ -422,7 +712,7 @@ namespace NajaLang
 	Stmt *Parser::ParseClassStmt()
 	{
 		Consume(TOKEN_CLASS, "Expect 'class' keyword");
-		auto classStmt = new ClassStmt();
+		auto classStmt = m_Arena.New<ClassStmt>();
 		classStmt->name = (IdentifierExpr *)ParseIdentifierExpr();
 
 		if (IsMatchCurTokenAndStepOnce(TOKEN_COLON))
@@ -435,7 +725,7 @@ namespace NajaLang
 			else
 			{
 				if (IsMatchCurToken(TOKEN_PRIVATE))
-					GetCurTokenAndStepOnce();
+					StepOnce();
 				classStmt->privateInherits.emplace_back((IdentifierExpr *)ParseIdentifierExpr());
 			}
 
@@ -448,7 +738,7 @@ namespace NajaLang
 				else
 				{
 					if (IsMatchCurToken(TOKEN_PRIVATE))
-						GetCurTokenAndStepOnce();
+						StepOnce();
 					classStmt->privateInherits.emplace_back((IdentifierExpr *)ParseIdentifierExpr());
 				}
 			}
@@ -480,7 +770,7 @@ namespace NajaLang
 			else //private function or variable,'private' keyword is not the necessary
 			{
 				if (IsMatchCurToken(TOKEN_PRIVATE))
-					GetCurTokenAndStepOnce();
+					StepOnce();
 				if (IsMatchCurTokenAndStepOnce(TOKEN_FUNCTION))
 					classStmt->privateFunctions.emplace_back((FunctionStmt *)ParseFunctionStmt());
 				else if (IsMatchCurTokenAndStepOnce(TOKEN_VAR))
@@ -488,7 +778,7 @@ namespace NajaLang
 				else
 				{
 					Consume({TOKEN_FUNCTION, TOKEN_VAR}, "only function or variable declaration is available in class scope.");
-					GetCurTokenAndStepOnce();
+					StepOnce();
 				}
 			}
 		}
@@ -500,33 +790,35 @@ namespace NajaLang
 
 	Expr *Parser::ParseExpr(Precedence precedence)
 	{
-		if (m_PrefixFunctions.find(GetCurToken().type) == m_PrefixFunctions.end())
+		PrefixFn prefixFn = m_PrefixFunctions[GetCurTokenType()];
+		if (prefixFn == nullptr)
 		{
-			std::cout << "no prefix definition for:" << GetCurTokenAndStepOnce().literal << std::endl;
+			if (m_IsSpeculative)
+				m_DeferredOutput.emplace_back("no prefix definition for:" + std::string(GetCurTokenAndStepOnce().literal));
+			else
+				std::cout << "no prefix definition for:" << GetCurTokenAndStepOnce().literal << std::endl;
 			return nullExpr;
 		}
-		auto prefixFn = m_PrefixFunctions[GetCurToken().type];
 
 		auto leftExpr = (this->*prefixFn)();
 
 		while (!IsMatchCurToken(TOKEN_SEMICOLON) && precedence < GetCurTokenPrecedence())
 		{
-			if (GetCurTokenPrecedence() != POSTFIX)
+			TokenType type = GetCurTokenType();
+			if (m_Precedence[type] != POSTFIX)
 			{
-				if (m_InfixFunctions.find(GetCurToken().type) == m_InfixFunctions.end())
+				InfixFn infixFn = m_InfixFunctions[type];
+				if (infixFn == nullptr)
 					return leftExpr;
 
-				auto infixFn = m_InfixFunctions[GetCurToken().type];
-
 				leftExpr = (this->*infixFn)(leftExpr);
 			}
 			else
 			{
-				if (m_PostfixFunctions.find(GetCurToken().type) == m_PostfixFunctions.end())
+				PostfixFn postFixFn = m_PostfixFunctions[type];
+				if (postFixFn == nullptr)
 					return leftExpr;
 
-				auto postFixFn = m_PostfixFunctions[GetCurToken().type];
-
 				leftExpr = (this->*postFixFn)(leftExpr);
 			}
 		}
@@ -536,22 +828,29 @@ namespace NajaLang
 
 	Expr *Parser::ParseIdentifierExpr()
 	{
-		return new IdentifierExpr(Consume(TOKEN_IDENTIFIER, "Expect a identifier.").literal);
+		return MakeIdentifierExpr(Consume(TOKEN_IDENTIFIER, "Expect a identifier."));
+	}
+
+	IdentifierExpr *Parser::MakeIdentifierExpr(const Token &token)
+	{
+		//a failed Consume hands back the end token,which was never interned
+		uint32_t symbol = token.type == TOKEN_IDENTIFIER ? token.value.symbol : GetSymbolTable().Intern(token.literal);
+		return m_Arena.New<IdentifierExpr>(GetSymbolTable().GetName(symbol), symbol);
 	}
 
 	Expr *Parser::ParseNumExpr()
 	{
-		std::string numLiteral = Consume(TOKEN_NUMBER, "Expexct a number literal.").literal;
+		const Token &token = Consume(TOKEN_NUMBER, "Expexct a number literal.");
 
-		if (numLiteral.find('.') != std::string::npos)
-			return new FloatNumExpr(std::stod(numLiteral));
+		if (token.numberType == NUMBER_FLOAT)
+			return m_Arena.New<FloatNumExpr>(token.value.floatValue);
 		else
-			return new IntNumExpr(std::stoll(numLiteral));
+			return m_Arena.New<IntNumExpr>(token.value.intValue);
 	}
 
 	Expr *Parser::ParseStrExpr()
 	{
-		return new StrExpr(Consume(TOKEN_STRING, "Expect a string literal.").literal);
+		return m_Arena.New<StrExpr>(m_Arena.CopyString(Consume(TOKEN_STRING, "Expect a string literal.").literal));
 	}
 
 	Expr *Parser::ParseNullExpr()
@@ -584,7 +883,7 @@ namespace NajaLang
 	Expr *Parser::ParseGroupExpr()
 	{
 		Consume(TOKEN_LEFT_PAREN, "Expect '('.");
-		auto groupExpr = new GroupExpr();
+		auto groupExpr = m_Arena.New<GroupExpr>();
 		groupExpr->expr = ParseExpr();
 		Consume(TOKEN_RIGHT_PAREN, "Expect ')'.");
 		return groupExpr;
@@ -594,7 +893,7 @@ namespace NajaLang
 	{
 		Consume(TOKEN_FUNCTION, "Expect 'function' keyword");
 		Consume(TOKEN_LEFT_PAREN, "Expect '(' after 'function' keyword");
-		auto funcExpr = new FunctionExpr();
+		auto funcExpr = m_Arena.New<FunctionExpr>();
 
 		if (!IsMatchCurToken(TOKEN_RIGHT_PAREN)) //has parameter
 		{
@@ -608,7 +907,7 @@ namespace NajaLang
 		}
 		Consume(TOKEN_RIGHT_PAREN, "Expect ')' after function expr's '('");
 
-		funcExpr->body = (ScopeStmt *)ParseScopeStmt();
+		funcExpr->body = ParseFunctionBody(funcExpr->lazyBody);
 
 		return funcExpr;
 	}
@@ -617,7 +916,7 @@ namespace NajaLang
 	{
 		Consume(TOKEN_LEFT_BRACKET, "Expect '['.");
 
-		auto arrayExpr = new ArrayExpr();
+		auto arrayExpr = m_Arena.New<ArrayExpr>();
 		if (!IsMatchCurToken(TOKEN_RIGHT_BRACKET))
 		{
 			//first element
@@ -635,7 +934,7 @@ namespace NajaLang
 	{
 		Consume(TOKEN_LEFT_BRACE, "Expect '{'.");
 
-		auto tableExpr = new TableExpr();
+		auto tableExpr = m_Arena.New<TableExpr>();
 		if (!IsMatchCurToken(TOKEN_RIGHT_BRACE))
 		{
 			//first element
@@ -661,7 +960,7 @@ namespace NajaLang
 	Expr *Parser::ParseNewExpr()
 	{
 		Consume(TOKEN_NEW, "Expect 'new'.");
-		auto newExpr = new NewExpr();
+		auto newExpr = m_Arena.New<NewExpr>();
 
 		newExpr->object = ParseExpr();
 
@@ -670,39 +969,42 @@ namespace NajaLang
 
 	Expr *Parser::ParsePrefixExpr()
 	{
-		auto prefixExpr = new PrefixExpr();
-		prefixExpr->op = GetCurTokenAndStepOnce().literal;
+		auto prefixExpr = m_Arena.New<PrefixExpr>();
+		prefixExpr->op = m_PrefixOperators[GetCurTokenType()];
+		StepOnce();
 		prefixExpr->right = ParseExpr();
 		return prefixExpr;
 	}
 
 	Expr *Parser::ParseInfixExpr(Expr *prefixExpr)
 	{
-		auto infixExpr = new InfixExpr();
+		auto infixExpr = m_Arena.New<InfixExpr>();
 		infixExpr->left = prefixExpr;
-		infixExpr->op = GetCurTokenAndStepOnce().literal;
+		infixExpr->op = m_InfixOperators[GetCurTokenType()];
+		StepOnce();
 		infixExpr->right = ParseExpr(GetCurTokenPrecedence());
 		return infixExpr;
 	}
 
 	Expr *Parser::ParsePostfixExpr(Expr *prefixExpr)
 	{
-		auto postfixExpr = new PostfixExpr();
+		auto postfixExpr = m_Arena.New<PostfixExpr>();
 		postfixExpr->left = prefixExpr;
-		postfixExpr->op = GetCurTokenAndStepOnce().literal;
+		postfixExpr->op = m_PrefixOperators[GetCurTokenType()];
+		StepOnce();
 		return postfixExpr;
 	}
 
 	Expr *Parser::ParseTernaryExpr(Expr *prefixExpr)
 	{
-		auto ternaryExpr = new TernaryExpr();
+		auto ternaryExpr = m_Arena.New<TernaryExpr>();
 
 		ternaryExpr->condition = prefixExpr;
 
-		ternaryExpr->firstOp = Consume(TOKEN_QUESTION, "Expect '?'.").literal;
+		Consume(TOKEN_QUESTION, "Expect '?'.");
 
 		ternaryExpr->trueBranch = ParseExpr();
-		ternaryExpr->secondOp = Consume(TOKEN_COLON, "Expect ':'").literal;
+		Consume(TOKEN_COLON, "Expect ':'");
 		ternaryExpr->falseBranch = ParseExpr();
 		return ternaryExpr;
 	}
@@ -710,7 +1012,7 @@ namespace NajaLang
 	Expr *Parser::ParseIndexExpr(Expr *prefixExpr)
 	{
 		Consume(TOKEN_LEFT_BRACKET, "Expect '['.");
-		auto indexExpr = new IndexExpr();
+		auto indexExpr = m_Arena.New<IndexExpr>();
 		indexExpr->array = prefixExpr;
 		indexExpr->index = ParseExpr();
 		Consume(TOKEN_RIGHT_BRACKET, "Expect ']'.");
@@ -719,7 +1021,7 @@ namespace NajaLang
 
 	Expr *Parser::ParseFunctionCallExpr(Expr *prefixExpr)
 	{
-		auto funcCallExpr = new FunctionCallExpr();
+		auto funcCallExpr = m_Arena.New<FunctionCallExpr>();
 		funcCallExpr->function = prefixExpr;
 		Consume(TOKEN_LEFT_PAREN, "Expect '('.");
 		if (!IsMatchCurToken(TOKEN_RIGHT_PAREN)) //has arguments
@@ -737,7 +1039,7 @@ namespace NajaLang
 	{
 		Consume(TOKEN_DOT, "Expect '.'.");
 
-		auto classCallExpr = new ClassCallExpr();
+		auto classCallExpr = m_Arena.New<ClassCallExpr>();
 
 		classCallExpr->classInstance = prefixExpr;
 
@@ -746,61 +1048,142 @@ namespace NajaLang
 		return classCallExpr;
 	}
 
-	Token Parser::GetCurToken()
+	TokenType Parser::GetCurTokenType()
 	{
+		if (m_TokenBuffer)
+			return m_TokenBuffer->GetType(std::min<uint64_t>(m_CurPos, m_TokenBuffer->GetSize() - 1));
+		return GetCurToken().type;
+	}
+
+	TokenType Parser::GetNextTokenType()
+	{
+		if (m_TokenBuffer)
+			return m_TokenBuffer->GetType(std::min<uint64_t>(m_CurPos + 1, m_TokenBuffer->GetSize() - 1));
+		return GetNextToken().type;
+	}
+
+	uint64_t Parser::GetCurTokenLine()
+	{
+		if (m_TokenBuffer)
+			return m_TokenBuffer->GetLine(std::min<uint64_t>(m_CurPos, m_TokenBuffer->GetSize() - 1));
+		return GetCurToken().line;
+	}
+
+	const Token &Parser::MaterializeToken(uint64_t index)
+	{
+		index = std::min<uint64_t>(index, m_TokenBuffer->GetSize() - 1);
+		Token &token = m_ScratchTokens[m_ScratchHead];
+		m_ScratchHead = (m_ScratchHead + 1) % SCRATCH_TOKEN_COUNT;
+		token.type = m_TokenBuffer->GetType(index);
+		token.literal = m_TokenBuffer->GetLiteral(index);
+		token.line = 0;
+		token.numberType = NUMBER_NONE;
+		if (token.type == TOKEN_NUMBER || token.type == TOKEN_IDENTIFIER)
+			m_TokenBuffer->GetValue(index, token);
+		return token;
+	}
+
+	void Parser::StepOnce()
+	{
+		if (m_TokenBuffer)
+		{
+			if (!IsAtEnd())
+				m_CurPos++;
+		}
+		else
+			GetCurTokenAndStepOnce();
+	}
+
+	const Token &Parser::GetCurToken()
+	{
+		if (m_TokenStream)
+			return m_TokenStream->PeekToken();
+		if (m_TokenBuffer)
+			return MaterializeToken(m_CurPos);
 		if (!IsAtEnd())
-			return m_Tokens[m_CurPos];
-		return m_Tokens.back();
+			return (*m_Tokens)[m_CurPos];
+		return m_Tokens->back();
 	}
-	Token Parser::GetCurTokenAndStepOnce()
+	const Token &Parser::GetCurTokenAndStepOnce()
 	{
+		if (m_TokenStream)
+		{
+			m_CurPos++;
+			return m_TokenStream->NextToken();
+		}
+		if (m_TokenBuffer)
+			return MaterializeToken(IsAtEnd() ? m_CurPos : m_CurPos++);
 		if (!IsAtEnd())
-			return m_Tokens[m_CurPos++];
-		return m_Tokens.back();
+			return (*m_Tokens)[m_CurPos++];
+		return m_Tokens->back();
 	}
 
 	Precedence Parser::GetCurTokenPrecedence()
 	{
-		if (m_Precedence.find(GetCurToken().type) != m_Precedence.end())
-			return m_Precedence[GetCurToken().type];
-		return LOWEST;
+		return m_Precedence[GetCurTokenType()];
 	}
 
-	Token Parser::GetNextToken()
+	const Token &Parser::GetNextToken()
 	{
-		if (m_CurPos + 1 < (int32_t)m_Tokens.size())
-			return m_Tokens[m_CurPos + 1];
-		return m_Tokens.back();
+		if (m_TokenStream)
+			return m_TokenStream->PeekToken(1);
+		if (m_TokenBuffer)
+			return MaterializeToken(m_CurPos + 1);
+		if (m_CurPos + 1 < (int64_t)m_Tokens->size())
+			return (*m_Tokens)[m_CurPos + 1];
+		return m_Tokens->back();
 	}
-	Token Parser::GetNextTokenAndStepOnce()
+	const Token &Parser::GetNextTokenAndStepOnce()
 	{
-		if (m_CurPos + 1 < (int32_t)m_Tokens.size())
-			return m_Tokens[++m_CurPos];
-		return m_Tokens.back();
+		if (m_TokenStream)
+		{
+			GetCurTokenAndStepOnce();
+			return GetCurToken();
+		}
+		if (m_TokenBuffer)
+		{
+			if (m_CurPos + 1 < (int64_t)m_TokenBuffer->GetSize())
+				++m_CurPos;
+			return MaterializeToken(m_CurPos);
+		}
+		if (m_CurPos + 1 < (int64_t)m_Tokens->size())
+			return (*m_Tokens)[++m_CurPos];
+		return m_Tokens->back();
 	}
 
 	Precedence Parser::GetNextTokenPrecedence()
 	{
-		if (m_Precedence.find(GetNextToken().type) != m_Precedence.end())
-			return m_Precedence[GetNextToken().type];
-		return LOWEST;
+		return m_Precedence[GetNextTokenType()];
 	}
 
-	Token Parser::GetPreToken()
+	const Token &Parser::GetPreToken()
 	{
-		return m_Tokens[m_CurPos - 1];
+		if (m_TokenStream)
+			return m_TokenStream->GetPreToken();
+		if (m_TokenBuffer)
+			return MaterializeToken(m_CurPos - 1);
+		return (*m_Tokens)[m_CurPos - 1];
+	}
+
+	const Token &Parser::GetEndToken()
+	{
+		if (m_TokenStream)
+			return m_EndToken;
+		if (m_TokenBuffer)
+			return MaterializeToken(m_TokenBuffer->GetSize() - 1);
+		return m_Tokens->back();
 	}
 
 	bool Parser::IsMatchCurToken(TokenType type)
 	{
-		return GetCurToken().type == type;
+		return GetCurTokenType() == type;
 	}
 
 	bool Parser::IsMatchCurTokenAndStepOnce(TokenType type)
 	{
 		if (IsMatchCurToken(type))
 		{
-			m_CurPos++;
+			StepOnce();
 			return true;
 		}
 		return false;
@@ -808,14 +1191,14 @@ namespace NajaLang
 
 	bool Parser::IsMatchNextToken(TokenType type)
 	{
-		return GetNextToken().type == type;
+		return GetNextTokenType() == type;
 	}
 
 	bool Parser::IsMatchNextTokenAndStepOnce(TokenType type)
 	{
 		if (IsMatchNextToken(type))
 		{
-			m_CurPos++;
+			StepOnce();
 			return true;
 		}
 		return false;
@@ -823,28 +1206,34 @@ namespace NajaLang
 
 	bool Parser::IsMatchPreToken(TokenType type)
 	{
+		if (m_TokenBuffer)
+			return m_TokenBuffer->GetType(m_CurPos - 1) == type;
 		return GetPreToken().type == type;
 	}
 
-	Token Parser::Consume(TokenType type, std::string_view errMsg)
+	const Token &Parser::Consume(TokenType type, std::string_view errMsg)
 	{
 		if (IsMatchCurToken(type))
 			return GetCurTokenAndStepOnce();
-		m_ErrorMsgs.emplace_back("[line "+ std::to_string(GetCurToken().line) +"]:"+ std::string(errMsg));
-		return m_Tokens.back();
+		m_ErrorMsgs.emplace_back("[line "+ std::to_string(GetCurTokenLine()) +"]:"+ std::string(errMsg));
+		return GetEndToken();
 	}
 
-	Token Parser::Consume(std::vector<TokenType> type, std::string_view errMsg)
+	const Token &Parser::Consume(std::vector<TokenType> type, std::string_view errMsg)
 	{
 		for (const auto &t : type)
 			if (IsMatchCurToken(t))
 				return GetCurTokenAndStepOnce();
-		m_ErrorMsgs.emplace_back("[line "+ std::to_string(GetCurToken().line) +"]:"+ std::string(errMsg));
-		return m_Tokens.back();
+		m_ErrorMsgs.emplace_back("[line "+ std::to_string(GetCurTokenLine()) +"]:"+ std::string(errMsg));
+		return GetEndToken();
 	}
 
 	bool Parser::IsAtEnd()
 	{
-		return m_CurPos >= (int32_t)m_Tokens.size();
+		if (m_TokenStream)
+			return false;
+		if (m_TokenBuffer)
+			return m_CurPos >= (int64_t)m_TokenBuffer->GetSize();
+		return m_CurPos >= (int64_t)m_Tokens->size();
 	}
 }
\ No newline at end of file
@@ -1,9 +1,15 @@
 #pragma once
 #include <vector>
+#include <array>
+#include <memory>
 #include <cassert>
-#include <unordered_map>
 #include "Token.h"
+#include "Lexer.h"
+#include "TokenBuffer.h"
 #include "Ast.h"
+#include "AstArena.h"
+#include "FlatAst.h"
+#include "ThreadPool.h"
 namespace NajaLang
 {
 
@@ -42,13 +48,46 @@ namespace NajaLang
 		Parser();
 		~Parser();
 
+		// tokens are read in place,the caller must keep them alive until Parse returns.
+		// The returned tree lives in the parser's arena until the next Parse or the parser's destruction
 		Stmt *Parse(const std::vector<Token> &tokens);
+		// pulls tokens from a lexer prepared with Lexer::SetSource,so the token stream is never materialized
+		Stmt *Parse(Lexer &lexer);
+		// reads the type bytes of a compact buffer directly,full tokens are only built when a literal or line is needed
+		Stmt *Parse(const TokenBuffer &tokens);
+		// parses into ast instead of a tree,the arena is released again once the tree has been flattened
+		void ParseFlat(const std::vector<Token> &tokens, FlatAst &ast);
+		void ParseFlat(const TokenBuffer &tokens, FlatAst &ast);
+		// rebuilds the tree of a FlatAst in the arena without any tokens,e.g. one loaded from an AstCache
+		Stmt *Parse(const FlatAst &ast);
+		// splits the tokens in front of top level function and class declarations and parses the pieces on the pool,
+		// each piece with its own arena and error list.Statements and diagnostics are merged in source order.If a
+		// piece stops elsewhere than at its end the split was wrong and the tokens are parsed again serially,so the
+		// result and the diagnostics are always those of Parse
+		Stmt *ParseParallel(const std::vector<Token> &tokens, ThreadPool &pool);
+		Stmt *ParseParallel(const TokenBuffer &tokens, ThreadPool &pool);
+
+		// in lazy mode function bodies are skipped by matching braces and only their token range is kept,
+		// ParseLazyBody parses one when it is first needed.Lazy mode needs random access to the tokens,so
+		// Parse(Lexer&) and ParseFlat always parse bodies
+		void SetLazyBodies(bool lazy);
+		bool IsLazyBodies() const;
+		// the tokens and the tree of the last Parse must still be alive,the body is kept in the node
+		ScopeStmt *ParseLazyBody(FunctionStmt *stmt);
+		ScopeStmt *ParseLazyBody(FunctionExpr *expr);
 		
 		bool HasError();
 		const std::vector<std::string>& GetErrors() const;
 		void PrintErrors();
+
+		const AstArena &GetArena() const;
 	private:
 		void ResetStatus();
+		bool ParsePieces(ThreadPool &pool);
+		std::vector<uint64_t> FindPieceBounds(uint64_t pieceSize);
+		// random access to the token types of m_Tokens or m_TokenBuffer
+		uint64_t GetTokenCount();
+		TokenType GetTokenType(uint64_t index);
 
 		Stmt *ParseAstStmts();
 		Stmt *ParseStmt();
@@ -63,9 +102,13 @@ namespace NajaLang
 		Stmt *ParseContinueStmt();
 		Stmt *ParseFunctionStmt();
 		Stmt *ParseClassStmt();
+		ScopeStmt *ParseFunctionBody(LazyBody &lazyBody);
+		bool SkipFunctionBody();
+		ScopeStmt *ParseBodyAt(const LazyBody &lazyBody);
 
 		Expr *ParseExpr(Precedence precedence = LOWEST);
 		Expr *ParseIdentifierExpr();
+		IdentifierExpr *MakeIdentifierExpr(const Token &token);
 		Expr *ParseNumExpr();
 		Expr *ParseStrExpr();
 		Expr *ParseNullExpr();
@@ -86,15 +129,23 @@ namespace NajaLang
 		Expr *ParseFunctionCallExpr(Expr *prefixExpr);
 		Expr *ParseClassCallExpr(Expr *prefixExpr);
 
-		Token GetCurToken();
-		Token GetCurTokenAndStepOnce();
+		TokenType GetCurTokenType();
+		TokenType GetNextTokenType();
+		uint64_t GetCurTokenLine();
+		// builds type and literal only,lines are looked up separately through GetCurTokenLine
+		const Token &MaterializeToken(uint64_t index);
+		void StepOnce();
+
+		const Token &GetCurToken();
+		const Token &GetCurTokenAndStepOnce();
 		Precedence GetCurTokenPrecedence();
 
-		Token GetNextToken();
-		Token GetNextTokenAndStepOnce();
+		const Token &GetNextToken();
+		const Token &GetNextTokenAndStepOnce();
 		Precedence GetNextTokenPrecedence();
 
-		Token GetPreToken();
+		const Token &GetPreToken();
+		const Token &GetEndToken();
 
 		bool IsMatchCurToken(TokenType type);
 		bool IsMatchCurTokenAndStepOnce(TokenType type);
@@ -105,20 +156,36 @@ namespace NajaLang
 		template <typename... T>
 		bool IsMatchPreToken(T... type);
 
-		Token Consume(TokenType type, std::string_view errMsg);
+		const Token &Consume(TokenType type, std::string_view errMsg);
 
-		Token Consume(std::vector<TokenType> type, std::string_view errMsg);
+		const Token &Consume(std::vector<TokenType> type, std::string_view errMsg);
 
 		bool IsAtEnd();
 
 		int64_t m_CurPos;
+		AstArena m_Arena;
 		AstStmts *m_Stmts;
-		std::vector<Token> m_Tokens;
-
-		static std::unordered_map<TokenType, PrefixFn> m_PrefixFunctions;
-		static std::unordered_map<TokenType, InfixFn> m_InfixFunctions;
-		static std::unordered_map<TokenType, PostfixFn> m_PostfixFunctions;
-		static std::unordered_map<TokenType, Precedence> m_Precedence;
+		const std::vector<Token> *m_Tokens;
+		Lexer *m_TokenStream;
+		const TokenBuffer *m_TokenBuffer;
+		Token m_EndToken;
+		bool m_LazyBodies;
+		bool m_IsSpeculative; // a piece of ParseParallel,output is kept in m_DeferredOutput until the pieces are merged
+		std::vector<std::string> m_DeferredOutput;
+		std::vector<std::unique_ptr<Parser>> m_PieceParsers;
+
+		//tokens built from m_TokenBuffer,a few are kept so a returned reference survives the next lookups
+		static constexpr uint64_t SCRATCH_TOKEN_COUNT = 4;
+		std::array<Token, SCRATCH_TOKEN_COUNT> m_ScratchTokens;
+		uint64_t m_ScratchHead;
+
+		static const std::array<PrefixFn, TOKEN_TYPE_COUNT> m_PrefixFunctions;
+		static const std::array<InfixFn, TOKEN_TYPE_COUNT> m_InfixFunctions;
+		static const std::array<PostfixFn, TOKEN_TYPE_COUNT> m_PostfixFunctions;
+		static const std::array<Precedence, TOKEN_TYPE_COUNT> m_Precedence;
+		// prefix and postfix operators share a table,'++' and '--' mean the same in both positions
+		static const std::array<Operator, TOKEN_TYPE_COUNT> m_PrefixOperators;
+		static const std::array<Operator, TOKEN_TYPE_COUNT> m_InfixOperators;
 
 		std::vector<std::string> m_ErrorMsgs;
 	};
@@ -0,0 +1,332 @@
+#include "SimdScan.h"
+#include <atomic>
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define NAJA_SIMD_X64
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define NAJA_TARGET_AVX2
+#else
+#define NAJA_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace NajaLang
+{
+	static bool IsWhitespace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+	}
+
+	static bool IsIdentifierChar(char c)
+	{
+		return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_';
+	}
+
+	static const char *FindCharScalar(const char *begin, const char *end, char c, uint64_t &newlines)
+	{
+		for (; begin < end && *begin != c; ++begin)
+			newlines += (*begin == '\n');
+		return begin;
+	}
+
+	static const char *SkipWhitespaceScalar(const char *begin, const char *end, uint64_t &newlines)
+	{
+		for (; begin < end && IsWhitespace(*begin); ++begin)
+			newlines += (*begin == '\n');
+		return begin;
+	}
+
+	static const char *SkipIdentifierScalar(const char *begin, const char *end)
+	{
+		while (begin < end && IsIdentifierChar(*begin))
+			++begin;
+		return begin;
+	}
+
+	static uint64_t CountNewlinesScalar(const char *begin, const char *end)
+	{
+		uint64_t newlines = 0;
+		for (; begin < end; ++begin)
+			newlines += (*begin == '\n');
+		return newlines;
+	}
+
+	// counts the newlines in the low 'count' lanes of a movemask
+	static uint64_t CountLanes(uint32_t mask, uint32_t count)
+	{
+		return std::popcount(count >= 32 ? mask : mask & ((1u << count) - 1));
+	}
+
+#ifdef NAJA_SIMD_X64
+	static const char *FindCharSse2(const char *begin, const char *end, char c, uint64_t &newlines)
+	{
+		const __m128i target = _mm_set1_epi8(c);
+		const __m128i newline = _mm_set1_epi8('\n');
+		for (; end - begin >= 16; begin += 16)
+		{
+			__m128i block = _mm_loadu_si128((const __m128i *)begin);
+			uint32_t found = _mm_movemask_epi8(_mm_cmpeq_epi8(block, target));
+			uint32_t lines = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+			if (found)
+			{
+				uint32_t idx = std::countr_zero(found);
+				newlines += CountLanes(lines, idx);
+				return begin + idx;
+			}
+			newlines += std::popcount(lines);
+		}
+		return FindCharScalar(begin, end, c, newlines);
+	}
+
+	static uint64_t CountNewlinesSse2(const char *begin, const char *end)
+	{
+		const __m128i newline = _mm_set1_epi8('\n');
+		uint64_t newlines = 0;
+		for (; end - begin >= 16; begin += 16)
+			newlines += std::popcount((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)begin), newline)));
+		return newlines + CountNewlinesScalar(begin, end);
+	}
+
+	static __m128i WhitespaceMaskSse2(__m128i block)
+	{
+		__m128i ws = _mm_cmpeq_epi8(block, _mm_set1_epi8(' '));
+		ws = _mm_or_si128(ws, _mm_cmpeq_epi8(block, _mm_set1_epi8('\t')));
+		ws = _mm_or_si128(ws, _mm_cmpeq_epi8(block, _mm_set1_epi8('\r')));
+		return _mm_or_si128(ws, _mm_cmpeq_epi8(block, _mm_set1_epi8('\n')));
+	}
+
+	static const char *SkipWhitespaceSse2(const char *begin, const char *end, uint64_t &newlines)
+	{
+		const __m128i newline = _mm_set1_epi8('\n');
+		for (; end - begin >= 16; begin += 16)
+		{
+			__m128i block = _mm_loadu_si128((const __m128i *)begin);
+			uint32_t other = ~_mm_movemask_epi8(WhitespaceMaskSse2(block)) & 0xFFFF;
+			uint32_t lines = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+			if (other)
+			{
+				uint32_t idx = std::countr_zero(other);
+				newlines += CountLanes(lines, idx);
+				return begin + idx;
+			}
+			newlines += std::popcount(lines);
+		}
+		return SkipWhitespaceScalar(begin, end, newlines);
+	}
+
+	// bytes >= 0x80 are negative for the signed compares below,so they never classify as identifier chars
+	static __m128i IdentifierMaskSse2(__m128i block)
+	{
+		__m128i lower = _mm_or_si128(block, _mm_set1_epi8(0x20));
+		__m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+		__m128i digit = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(block, _mm_set1_epi8('9' + 1)));
+		__m128i underscore = _mm_cmpeq_epi8(block, _mm_set1_epi8('_'));
+		return _mm_or_si128(_mm_or_si128(alpha, digit), underscore);
+	}
+
+	static const char *SkipIdentifierSse2(const char *begin, const char *end)
+	{
+		for (; end - begin >= 16; begin += 16)
+		{
+			__m128i block = _mm_loadu_si128((const __m128i *)begin);
+			uint32_t other = ~_mm_movemask_epi8(IdentifierMaskSse2(block)) & 0xFFFF;
+			if (other)
+				return begin + std::countr_zero(other);
+		}
+		return SkipIdentifierScalar(begin, end);
+	}
+
+	NAJA_TARGET_AVX2 static const char *FindCharAvx2(const char *begin, const char *end, char c, uint64_t &newlines)
+	{
+		const __m256i target = _mm256_set1_epi8(c);
+		const __m256i newline = _mm256_set1_epi8('\n');
+		for (; end - begin >= 32; begin += 32)
+		{
+			__m256i block = _mm256_loadu_si256((const __m256i *)begin);
+			uint32_t found = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, target));
+			uint32_t lines = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline));
+			if (found)
+			{
+				uint32_t idx = std::countr_zero(found);
+				newlines += CountLanes(lines, idx);
+				return begin + idx;
+			}
+			newlines += std::popcount(lines);
+		}
+		return FindCharSse2(begin, end, c, newlines);
+	}
+
+	NAJA_TARGET_AVX2 static uint64_t CountNewlinesAvx2(const char *begin, const char *end)
+	{
+		const __m256i newline = _mm256_set1_epi8('\n');
+		uint64_t newlines = 0;
+		for (; end - begin >= 32; begin += 32)
+			newlines += std::popcount((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)begin), newline)));
+		return newlines + CountNewlinesSse2(begin, end);
+	}
+
+	NAJA_TARGET_AVX2 static const char *SkipWhitespaceAvx2(const char *begin, const char *end, uint64_t &newlines)
+	{
+		const __m256i newline = _mm256_set1_epi8('\n');
+		for (; end - begin >= 32; begin += 32)
+		{
+			__m256i block = _mm256_loadu_si256((const __m256i *)begin);
+			__m256i ws = _mm256_cmpeq_epi8(block, _mm256_set1_epi8(' '));
+			ws = _mm256_or_si256(ws, _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\t')));
+			ws = _mm256_or_si256(ws, _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\r')));
+			ws = _mm256_or_si256(ws, _mm256_cmpeq_epi8(block, newline));
+			uint32_t other = ~(uint32_t)_mm256_movemask_epi8(ws);
+			uint32_t lines = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline));
+			if (other)
+			{
+				uint32_t idx = std::countr_zero(other);
+				newlines += CountLanes(lines, idx);
+				return begin + idx;
+			}
+			newlines += std::popcount(lines);
+		}
+		return SkipWhitespaceSse2(begin, end, newlines);
+	}
+
+	NAJA_TARGET_AVX2 static const char *SkipIdentifierAvx2(const char *begin, const char *end)
+	{
+		for (; end - begin >= 32; begin += 32)
+		{
+			__m256i block = _mm256_loadu_si256((const __m256i *)begin);
+			__m256i lower = _mm256_or_si256(block, _mm256_set1_epi8(0x20));
+			__m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+			__m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), block));
+			__m256i underscore = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('_'));
+			uint32_t other = ~(uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(alpha, digit), underscore));
+			if (other)
+				return begin + std::countr_zero(other);
+		}
+		return SkipIdentifierSse2(begin, end);
+	}
+
+	static bool IsAvx2Supported()
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+
+	struct ScanKernels
+	{
+		const char *(*findChar)(const char *, const char *, char, uint64_t &);
+		const char *(*skipWhitespace)(const char *, const char *, uint64_t &);
+		const char *(*skipIdentifier)(const char *, const char *);
+		uint64_t (*countNewlines)(const char *, const char *);
+		SimdLevel level;
+	};
+
+	static constexpr ScanKernels SCALAR_KERNELS = {FindCharScalar, SkipWhitespaceScalar, SkipIdentifierScalar, CountNewlinesScalar, SIMD_SCALAR};
+#ifdef NAJA_SIMD_X64
+	static constexpr ScanKernels SSE2_KERNELS = {FindCharSse2, SkipWhitespaceSse2, SkipIdentifierSse2, CountNewlinesSse2, SIMD_SSE2};
+	static constexpr ScanKernels AVX2_KERNELS = {FindCharAvx2, SkipWhitespaceAvx2, SkipIdentifierAvx2, CountNewlinesAvx2, SIMD_AVX2};
+#endif
+
+	static const ScanKernels *GetKernels(SimdLevel level)
+	{
+#ifdef NAJA_SIMD_X64
+		if (level == SIMD_AVX2)
+			return &AVX2_KERNELS;
+		if (level == SIMD_SSE2)
+			return &SSE2_KERNELS;
+#endif
+		return &SCALAR_KERNELS;
+	}
+
+	//the tables are constant data,so switching between them is one relaxed atomic store that lexers running on other
+	//threads can observe safely.A function local static is set up on first use,also from another file's static
+	//initialiser
+	static std::atomic<const ScanKernels *> &GetActiveKernels()
+	{
+		static std::atomic<const ScanKernels *> kernels(GetKernels(GetSupportedSimdLevel()));
+		return kernels;
+	}
+
+	static const ScanKernels &LoadKernels()
+	{
+		return *GetActiveKernels().load(std::memory_order_relaxed);
+	}
+
+	SimdLevel GetSupportedSimdLevel()
+	{
+#ifdef NAJA_SIMD_X64
+		static SimdLevel supported = IsAvx2Supported() ? SIMD_AVX2 : SIMD_SSE2;
+		return supported;
+#else
+		return SIMD_SCALAR;
+#endif
+	}
+
+	SimdLevel GetSimdLevel()
+	{
+		return LoadKernels().level;
+	}
+
+	void SetSimdLevel(SimdLevel level)
+	{
+		if (level > GetSupportedSimdLevel())
+			level = GetSupportedSimdLevel();
+		GetActiveKernels().store(GetKernels(level), std::memory_order_relaxed);
+	}
+
+	// most tokens and gaps are short,so the first bytes are checked inline before paying for a vector kernel
+	static constexpr int64_t SCALAR_PREFIX = 8;
+
+	const char *FindChar(const char *begin, const char *end, char c, uint64_t &newlines)
+	{
+		const char *stop = end - begin > SCALAR_PREFIX ? begin + SCALAR_PREFIX : end;
+		for (; begin < stop; ++begin)
+		{
+			if (*begin == c)
+				return begin;
+			newlines += (*begin == '\n');
+		}
+		return LoadKernels().findChar(begin, end, c, newlines);
+	}
+
+	const char *SkipWhitespace(const char *begin, const char *end, uint64_t &newlines)
+	{
+		const char *stop = end - begin > SCALAR_PREFIX ? begin + SCALAR_PREFIX : end;
+		for (; begin < stop; ++begin)
+		{
+			if (!IsWhitespace(*begin))
+				return begin;
+			newlines += (*begin == '\n');
+		}
+		return LoadKernels().skipWhitespace(begin, end, newlines);
+	}
+
+	const char *SkipIdentifier(const char *begin, const char *end)
+	{
+		const char *stop = end - begin > SCALAR_PREFIX ? begin + SCALAR_PREFIX : end;
+		for (; begin < stop; ++begin)
+			if (!IsIdentifierChar(*begin))
+				return begin;
+		return LoadKernels().skipIdentifier(begin, end);
+	}
+
+	uint64_t CountNewlines(const char *begin, const char *end)
+	{
+		return LoadKernels().countNewlines(begin, end);
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+namespace NajaLang
+{
+    // byte scanning kernels used by the Lexer's hot loops,the widest kernel the cpu supports is picked at startup
+    enum SimdLevel
+    {
+        SIMD_SCALAR,
+        SIMD_SSE2,
+        SIMD_AVX2,
+    };
+
+    SimdLevel GetSupportedSimdLevel();
+    SimdLevel GetSimdLevel();
+    // levels above the supported one are clamped,mostly useful for benchmarks
+    void SetSimdLevel(SimdLevel level);
+
+    // first c in [begin,end) or end,the '\n' skipped on the way are added to newlines
+    const char *FindChar(const char *begin, const char *end, char c, uint64_t &newlines);
+    // first byte in [begin,end) which is not ' ','\t','\r' or '\n',the '\n' skipped on the way are added to newlines
+    const char *SkipWhitespace(const char *begin, const char *end, uint64_t &newlines);
+    // number of '\n' in [begin,end)
+    uint64_t CountNewlines(const char *begin, const char *end);
+    // first byte in [begin,end) which is not [A-Za-z0-9_]
+    const char *SkipIdentifier(const char *begin, const char *end);
+}
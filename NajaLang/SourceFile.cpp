@@ -0,0 +1,131 @@
+#include "SourceFile.h"
+#include <fstream>
+#include <sstream>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+namespace NajaLang
+{
+	SourceFile::SourceFile()
+		: m_Data(nullptr), m_Size(0), m_IsMapped(false)
+#ifdef _WIN32
+		  ,
+		  m_FileHandle(nullptr), m_MappingHandle(nullptr)
+#endif
+	{
+	}
+
+	SourceFile::~SourceFile()
+	{
+		Close();
+	}
+
+	bool SourceFile::Open(std::string_view path)
+	{
+		Close();
+		std::string pathStr(path);
+#ifdef _WIN32
+		HANDLE file = CreateFileA(pathStr.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return ReadAll(path);
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		void *data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (!data)
+		{
+			if (mapping)
+				CloseHandle(mapping);
+			CloseHandle(file);
+			return ReadAll(path);
+		}
+
+		m_FileHandle = file;
+		m_MappingHandle = mapping;
+		m_Data = (const char *)data;
+		m_Size = size.QuadPart;
+		m_IsMapped = true;
+		return true;
+#else
+		int fd = open(pathStr.c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		struct stat info;
+		if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0)
+		{
+			close(fd);
+			return ReadAll(path);
+		}
+
+		void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd); //the mapping keeps the file alive
+		if (data == MAP_FAILED)
+			return ReadAll(path);
+
+		//the lexer walks the source front to back exactly once
+		madvise(data, info.st_size, MADV_SEQUENTIAL);
+
+		m_Data = (const char *)data;
+		m_Size = info.st_size;
+		m_IsMapped = true;
+		return true;
+#endif
+	}
+
+	void SourceFile::Close()
+	{
+		if (m_IsMapped)
+		{
+#ifdef _WIN32
+			UnmapViewOfFile(m_Data);
+			CloseHandle(m_MappingHandle);
+			CloseHandle(m_FileHandle);
+			m_FileHandle = m_MappingHandle = nullptr;
+#else
+			munmap((void *)m_Data, m_Size);
+#endif
+		}
+		std::string().swap(m_Buffer);
+		m_Data = nullptr;
+		m_Size = 0;
+		m_IsMapped = false;
+	}
+
+	std::string_view SourceFile::GetSource() const
+	{
+		return std::string_view(m_Data, m_Size);
+	}
+
+	bool SourceFile::IsMapped() const
+	{
+		return m_IsMapped;
+	}
+
+	bool SourceFile::ReadAll(std::string_view path)
+	{
+		std::ifstream file(std::string(path), std::ios::in | std::ios::binary);
+		if (!file.is_open())
+			return false;
+
+		std::stringstream sstream;
+		sstream << file.rdbuf();
+		m_Buffer = std::move(sstream).str();
+		m_Data = m_Buffer.data();
+		m_Size = m_Buffer.size();
+		return true;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+namespace NajaLang
+{
+    // read only view of a source file.Regular files are memory mapped and handed to the lexer without a copy,
+    // anything that can not be mapped(pipes,character devices) is read into an owned buffer instead
+    class SourceFile
+    {
+    public:
+        SourceFile();
+        ~SourceFile();
+
+        SourceFile(const SourceFile &) = delete;
+        SourceFile &operator=(const SourceFile &) = delete;
+
+        bool Open(std::string_view path);
+        void Close();
+
+        std::string_view GetSource() const;
+        bool IsMapped() const;
+
+    private:
+        bool ReadAll(std::string_view path);
+
+        const char *m_Data;
+        uint64_t m_Size;
+        bool m_IsMapped;
+        std::string m_Buffer;
+#ifdef _WIN32
+        void *m_FileHandle;
+        void *m_MappingHandle;
+#endif
+    };
+}
@@ -0,0 +1,50 @@
+#include "SymbolTable.h"
+#include <mutex>
+namespace NajaLang
+{
+	SymbolTable::SymbolTable()
+	{
+	}
+	SymbolTable::~SymbolTable()
+	{
+	}
+
+	uint32_t SymbolTable::Intern(std::string_view name)
+	{
+		{
+			std::shared_lock<std::shared_mutex> lock(m_Mutex);
+			auto iter = m_Symbols.find(name);
+			if (iter != m_Symbols.end())
+				return iter->second;
+		}
+
+		std::unique_lock<std::shared_mutex> lock(m_Mutex);
+		//another thread may have added it between the two locks
+		auto iter = m_Symbols.find(name);
+		if (iter != m_Symbols.end())
+			return iter->second;
+
+		uint32_t symbol = (uint32_t)m_Names.size();
+		m_Names.emplace_back(name);
+		m_Symbols.emplace(m_Names.back(), symbol);
+		return symbol;
+	}
+
+	std::string_view SymbolTable::GetName(uint32_t symbol) const
+	{
+		std::shared_lock<std::shared_mutex> lock(m_Mutex);
+		return m_Names[symbol];
+	}
+
+	uint32_t SymbolTable::GetSize() const
+	{
+		std::shared_lock<std::shared_mutex> lock(m_Mutex);
+		return (uint32_t)m_Names.size();
+	}
+
+	SymbolTable &GetSymbolTable()
+	{
+		static SymbolTable symbolTable;
+		return symbolTable;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <shared_mutex>
+#include <unordered_map>
+namespace NajaLang
+{
+    // interns identifiers into dense uint32_t symbols,so later stages compare names with one integer compare.
+    // The table only grows:symbols and the names they refer to stay valid for the lifetime of the table
+    class SymbolTable
+    {
+    public:
+        SymbolTable();
+        ~SymbolTable();
+
+        SymbolTable(const SymbolTable &) = delete;
+        SymbolTable &operator=(const SymbolTable &) = delete;
+
+        // thread safe,lookups of known names only take a shared lock
+        uint32_t Intern(std::string_view name);
+        std::string_view GetName(uint32_t symbol) const;
+        uint32_t GetSize() const;
+
+    private:
+        mutable std::shared_mutex m_Mutex;
+        std::unordered_map<std::string_view, uint32_t> m_Symbols; // keys refer to m_Names
+        std::deque<std::string> m_Names;                          // a deque never moves its elements
+    };
+
+    // the table shared by every Lexer in the process,symbols stay comparable across compilations
+    SymbolTable &GetSymbolTable();
+}
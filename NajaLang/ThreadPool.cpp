@@ -0,0 +1,92 @@
+#include "ThreadPool.h"
+#include <algorithm>
+namespace NajaLang
+{
+	ThreadPool::ThreadPool(uint32_t threadCount)
+		: m_Job(nullptr), m_JobCount(0), m_Generation(0), m_ActiveWorkers(0), m_Stop(false), m_NextIndex(0), m_FinishedCount(0)
+	{
+		if (threadCount == 0)
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+		for (uint32_t i = 1; i < threadCount; ++i)
+			m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stop = true;
+		}
+		m_WakeCondition.notify_all();
+		for (auto &worker : m_Workers)
+			worker.join();
+	}
+
+	uint32_t ThreadPool::GetThreadCount() const
+	{
+		return (uint32_t)m_Workers.size() + 1;
+	}
+
+	void ThreadPool::ParallelFor(uint64_t count, const std::function<void(uint64_t)> &fn)
+	{
+		if (count == 0)
+			return;
+
+		std::lock_guard<std::mutex> submitLock(m_SubmitMutex);
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Job = &fn;
+			m_JobCount = count;
+			m_NextIndex = 0;
+			m_FinishedCount = 0;
+			m_Generation++;
+		}
+		m_WakeCondition.notify_all();
+
+		RunJob();
+
+		//a worker that picked the job up late must leave it before the next job reuses the counters
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_DoneCondition.wait(lock, [this]()
+							 { return m_FinishedCount == m_JobCount && m_ActiveWorkers == 0; });
+		m_Job = nullptr;
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		uint64_t seenGeneration = 0;
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_WakeCondition.wait(lock, [&]()
+									 { return m_Stop || (m_Job && m_Generation != seenGeneration); });
+				if (m_Stop)
+					return;
+				seenGeneration = m_Generation;
+				m_ActiveWorkers++;
+			}
+
+			RunJob();
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_ActiveWorkers--;
+			}
+			m_DoneCondition.notify_all();
+		}
+	}
+
+	void ThreadPool::RunJob()
+	{
+		while (true)
+		{
+			uint64_t index = m_NextIndex++;
+			if (index >= m_JobCount)
+				return;
+			(*m_Job)(index);
+			m_FinishedCount++;
+		}
+	}
+}
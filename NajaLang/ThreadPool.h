@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+namespace NajaLang
+{
+    // fixed set of worker threads that run index ranges,used by the parallel lexing and parsing paths
+    class ThreadPool
+    {
+    public:
+        // 0 means one thread per hardware thread,the calling thread counts as one of them
+        ThreadPool(uint32_t threadCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        uint32_t GetThreadCount() const;
+
+        // calls fn(i) for every i in [0,count) and returns once all of them finished
+        void ParallelFor(uint64_t count, const std::function<void(uint64_t)> &fn);
+
+    private:
+        void WorkerLoop();
+        void RunJob();
+
+        std::vector<std::thread> m_Workers;
+
+        std::mutex m_SubmitMutex;
+        std::mutex m_Mutex;
+        std::condition_variable m_WakeCondition;
+        std::condition_variable m_DoneCondition;
+
+        const std::function<void(uint64_t)> *m_Job;
+        uint64_t m_JobCount;
+        uint64_t m_Generation;
+        uint32_t m_ActiveWorkers;
+        bool m_Stop;
+        std::atomic<uint64_t> m_NextIndex;
+        std::atomic<uint64_t> m_FinishedCount;
+    };
+}
@@ -83,15 +83,107 @@ namespace NajaLang
         TOKEN_EOF
     };
 
+    constexpr uint32_t TOKEN_TYPE_COUNT = TOKEN_EOF + 1;
+
+    enum NumberType
+    {
+        NUMBER_NONE,
+        NUMBER_INT,
+        NUMBER_FLOAT,
+    };
+
+    // decoded once by the lexer:the value of a TOKEN_NUMBER or the interned symbol of a TOKEN_IDENTIFIER
+    union TokenValue
+    {
+        int64_t intValue;
+        double floatValue;
+        uint32_t symbol;
+    };
+
     struct Token
     {
-        Token(TokenType type, std::string_view literal, uint64_t line) : type(type), literal(literal), line(line) {}
+        Token() : type(TOKEN_UNDEFINED), numberType(NUMBER_NONE), line(0), value{0} {}
+        Token(TokenType type, std::string_view literal, uint64_t line) : type(type), numberType(NUMBER_NONE), literal(literal), line(line), value{0} {}
 
         TokenType type;
-        std::string literal;
+        NumberType numberType;
+        std::string_view literal; // view into the source buffer passed to Lexer::ScanTokens
         uint64_t line;
+        TokenValue value;
     };
 
+    // switch on length and first char,so a name is classified without hashing or allocating
+    constexpr TokenType GetKeywordType(std::string_view literal)
+    {
+        auto match = [literal](std::string_view keyword, TokenType type)
+        {
+            return literal == keyword ? type : TOKEN_IDENTIFIER;
+        };
+
+        switch (literal.size())
+        {
+        case 2:
+            return match("if", TOKEN_IF);
+        case 3:
+            switch (literal[0])
+            {
+            case 'v':
+                return match("var", TOKEN_VAR);
+            case 'f':
+                return match("for", TOKEN_FOR);
+            case 'n':
+                return match("new", TOKEN_NEW);
+            }
+            break;
+        case 4:
+            switch (literal[0])
+            {
+            case 'e':
+                return match("else", TOKEN_ELSE);
+            case 't':
+                return literal[1] == 'r' ? match("true", TOKEN_TRUE) : match("this", TOKEN_THIS);
+            case 'n':
+                return match("null", TOKEN_NULL);
+            case 'b':
+                return match("base", TOKEN_BASE);
+            }
+            break;
+        case 5:
+            switch (literal[0])
+            {
+            case 'f':
+                return match("false", TOKEN_FALSE);
+            case 'w':
+                return match("while", TOKEN_WHILE);
+            case 'b':
+                return match("break", TOKEN_BREAK);
+            case 'c':
+                return match("class", TOKEN_CLASS);
+            }
+            break;
+        case 6:
+            switch (literal[0])
+            {
+            case 'p':
+                return match("public", TOKEN_PUBLIC);
+            case 'r':
+                return match("return", TOKEN_RETURN);
+            }
+            break;
+        case 7:
+            return match("private", TOKEN_PRIVATE);
+        case 8:
+            return literal[0] == 'c' ? match("continue", TOKEN_CONTINUE) : match("function", TOKEN_FUNCTION);
+        case 9:
+            return match("protected", TOKEN_PROTECTED);
+        }
+        return TOKEN_IDENTIFIER;
+    }
+
+    static_assert(GetKeywordType("this") == TOKEN_THIS && GetKeywordType("true") == TOKEN_TRUE);
+    static_assert(GetKeywordType("function") == TOKEN_FUNCTION && GetKeywordType("continue") == TOKEN_CONTINUE);
+    static_assert(GetKeywordType("thus") == TOKEN_IDENTIFIER && GetKeywordType("functor") == TOKEN_IDENTIFIER);
+
     inline std::ostream &operator<<(std::ostream &stream, const Token &token)
     {
         return stream << token.type << ",'" << token.literal << "'," << token.line;
@@ -0,0 +1,102 @@
+#include "TokenBuffer.h"
+#include <algorithm>
+#include "SimdScan.h"
+namespace NajaLang
+{
+	TokenBuffer::TokenBuffer()
+		: m_HasNewlineOffsets(false)
+	{
+	}
+	TokenBuffer::~TokenBuffer()
+	{
+	}
+
+	void TokenBuffer::Reset(std::string_view src)
+	{
+		m_Source = src;
+		m_Types.clear();
+		m_Starts.clear();
+		m_Lengths.clear();
+		m_Values.clear();
+		m_NewlineOffsets.clear();
+		m_HasNewlineOffsets = false;
+	}
+
+	void TokenBuffer::Add(TokenType type, uint32_t start, uint32_t length)
+	{
+		m_Types.emplace_back((uint8_t)type);
+		m_Starts.emplace_back(start);
+		m_Lengths.emplace_back(length);
+	}
+
+	void TokenBuffer::AddWithValue(uint32_t start, uint32_t length, const Token &token)
+	{
+		m_Values.push_back({(uint32_t)m_Types.size(), token.numberType, token.value});
+		Add(token.type, start, length);
+	}
+
+	std::string_view TokenBuffer::GetSource() const
+	{
+		return m_Source;
+	}
+
+	uint64_t TokenBuffer::GetSize() const
+	{
+		return m_Types.size();
+	}
+
+	std::string_view TokenBuffer::GetLiteral(uint64_t index) const
+	{
+		return m_Source.substr(m_Starts[index], m_Lengths[index]);
+	}
+
+	uint64_t TokenBuffer::GetLine(uint64_t index) const
+	{
+		//a string's closing quote is never a '\n',so the newlines before the literal's end are the ones before the token's end
+		return GetLineOfOffset((uint64_t)m_Starts[index] + m_Lengths[index]);
+	}
+
+	uint64_t TokenBuffer::GetColumn(uint64_t index) const
+	{
+		uint64_t start = m_Starts[index] - (GetType(index) == TOKEN_STRING ? 1 : 0);
+		uint64_t line = GetLineOfOffset(start);
+		uint64_t lineStart = line == 1 ? 0 : m_NewlineOffsets[line - 2] + 1;
+		return start - lineStart + 1;
+	}
+
+	Token TokenBuffer::GetToken(uint64_t index) const
+	{
+		Token token(GetType(index), GetLiteral(index), GetLine(index));
+		if (token.type == TOKEN_NUMBER || token.type == TOKEN_IDENTIFIER)
+			GetValue(index, token);
+		return token;
+	}
+
+	void TokenBuffer::GetValue(uint64_t index, Token &token) const
+	{
+		auto iter = std::lower_bound(m_Values.begin(), m_Values.end(), index, [](const ValueEntry &entry, uint64_t index)
+									 { return entry.tokenIndex < index; });
+		if (iter == m_Values.end() || iter->tokenIndex != index)
+			return;
+		token.numberType = iter->numberType;
+		token.value = iter->value;
+	}
+
+	uint64_t TokenBuffer::GetLineOfOffset(uint64_t offset) const
+	{
+		if (!m_HasNewlineOffsets)
+			BuildNewlineOffsets();
+		return std::lower_bound(m_NewlineOffsets.begin(), m_NewlineOffsets.end(), offset) - m_NewlineOffsets.begin() + 1;
+	}
+
+	void TokenBuffer::BuildNewlineOffsets() const
+	{
+		const char *begin = m_Source.data();
+		const char *end = begin + m_Source.size();
+		m_NewlineOffsets.reserve(CountNewlines(begin, end));
+		uint64_t skipped = 0;
+		for (const char *p = FindChar(begin, end, '\n', skipped); p < end; p = FindChar(p + 1, end, '\n', skipped))
+			m_NewlineOffsets.emplace_back((uint32_t)(p - begin));
+		m_HasNewlineOffsets = true;
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <string_view>
+#include "Token.h"
+namespace NajaLang
+{
+    // compact struct of arrays token stream:one type byte,a 32 bit start offset and a 32 bit length per token.
+    // Lines and columns are not stored,they are looked up in a table of newline offsets built on first use.
+    // Literals refer to the source in place,so it must stay alive while the buffer is in use
+    class TokenBuffer
+    {
+    public:
+        TokenBuffer();
+        ~TokenBuffer();
+
+        static constexpr uint64_t MAX_SOURCE_SIZE = UINT32_MAX;
+
+        void Reset(std::string_view src);
+        void Add(TokenType type, uint32_t start, uint32_t length);
+        // a TOKEN_NUMBER or TOKEN_IDENTIFIER with the value the lexer decoded,values are kept in a side table so
+        // other tokens stay 9 bytes
+        void AddWithValue(uint32_t start, uint32_t length, const Token &token);
+
+        std::string_view GetSource() const;
+        uint64_t GetSize() const;
+
+        TokenType GetType(uint64_t index) const { return (TokenType)m_Types[index]; }
+        uint32_t GetStart(uint64_t index) const { return m_Starts[index]; }
+        uint32_t GetLength(uint64_t index) const { return m_Lengths[index]; }
+        std::string_view GetLiteral(uint64_t index) const;
+
+        // line the token ends on,same as Token::line
+        uint64_t GetLine(uint64_t index) const;
+        // 1 based column of the token's first char
+        uint64_t GetColumn(uint64_t index) const;
+        Token GetToken(uint64_t index) const;
+        // copies the decoded value of a TOKEN_NUMBER or TOKEN_IDENTIFIER into token
+        void GetValue(uint64_t index, Token &token) const;
+
+        // 1 based line of a source offset
+        uint64_t GetLineOfOffset(uint64_t offset) const;
+
+    private:
+        struct ValueEntry
+        {
+            uint32_t tokenIndex;
+            NumberType numberType;
+            TokenValue value;
+        };
+
+        void BuildNewlineOffsets() const;
+
+        std::string_view m_Source;
+        std::vector<uint8_t> m_Types;
+        std::vector<uint32_t> m_Starts;
+        std::vector<uint32_t> m_Lengths;
+        std::vector<ValueEntry> m_Values; // sorted by tokenIndex
+
+        mutable bool m_HasNewlineOffsets;
+        mutable std::vector<uint32_t> m_NewlineOffsets;
+    };
+}
@@ -0,0 +1,886 @@
+#include "VM.h"
+#include <array>
+#include <cmath>
+#include "SymbolTable.h"
+namespace NajaLang
+{
+    static inline uint32_t ReadSymbol(const uint8_t *ip)
+    {
+        return (uint32_t)ip[0] | (uint32_t)ip[1] << 8 | (uint32_t)ip[2] << 16 | (uint32_t)ip[3] << 24;
+    }
+
+    static inline int16_t ReadInt16(const uint8_t *ip)
+    {
+        return (int16_t)(ip[0] | ip[1] << 8);
+    }
+
+    //numbers compare by value across int and float,strings by content,other objects by identity
+    static bool IsEqual(Value left, Value right)
+    {
+        if (left.GetBits() == right.GetBits())
+            return !left.IsFloat() || left.AsFloat() == right.AsFloat(); //NaN
+        if (left.IsNumber() && right.IsNumber())
+        {
+            if (left.IsInt() && right.IsInt())
+                return left.AsInt() == right.AsInt();
+            return left.AsNumber() == right.AsNumber();
+        }
+        if (left.IsStr() && right.IsStr())
+            return ((StrObject *)left.AsObject())->value == ((StrObject *)right.AsObject())->value;
+        return false;
+    }
+
+    VM::VM()
+        : m_Result(Value::Null())
+    {
+    }
+    VM::~VM()
+    {
+    }
+
+    InterpretResult VM::Run(const Chunk &chunk)
+    {
+        return Run(chunk, GetDefaultDispatch());
+    }
+
+    InterpretResult VM::Run(const Chunk &chunk, VMDispatch dispatch)
+    {
+        m_Error.clear();
+        m_Result = Value::Null();
+        if (!chunk.IsComplete())
+        {
+            Error("Chunk was compiled with errors.");
+            return INTERPRET_COMPILE_ERROR;
+        }
+        if (chunk.GetCodes().empty())
+            return INTERPRET_OK;
+
+        const uint8_t *ip = chunk.GetCodes().data();
+        ConstantPool constants = chunk.GetConstantPool();
+        if (!IsDispatchSupported(dispatch))
+            dispatch = GetDefaultDispatch();
+        InterpretResult result;
+        switch (dispatch)
+        {
+#ifdef NAJA_VM_HAS_COMPUTED_GOTO
+        case VM_DISPATCH_GOTO:
+            result = RunGoto(ip, constants);
+            break;
+#endif
+#ifdef NAJA_VM_HAS_TAIL_CALL
+        case VM_DISPATCH_TAIL_CALL:
+            result = RunTailCall(ip, &constants);
+            break;
+#endif
+        default:
+            result = RunSwitch(ip, constants);
+            break;
+        }
+        //whatever outlives the run was interned by Escape,the stack and with it every temporary box is dead now
+        m_Heap.clear();
+        return result;
+    }
+
+    VMDispatch VM::GetDefaultDispatch()
+    {
+#if defined(NAJA_VM_DISPATCH_SWITCH)
+        return VM_DISPATCH_SWITCH;
+#elif defined(NAJA_VM_DISPATCH_TAIL_CALL) && defined(NAJA_VM_HAS_TAIL_CALL)
+        return VM_DISPATCH_TAIL_CALL;
+#elif defined(NAJA_VM_HAS_COMPUTED_GOTO)
+        return VM_DISPATCH_GOTO;
+#else
+        return VM_DISPATCH_SWITCH;
+#endif
+    }
+
+    bool VM::IsDispatchSupported(VMDispatch dispatch)
+    {
+        switch (dispatch)
+        {
+        case VM_DISPATCH_SWITCH:
+            return true;
+        case VM_DISPATCH_GOTO:
+#ifdef NAJA_VM_HAS_COMPUTED_GOTO
+            return true;
+#else
+            return false;
+#endif
+        case VM_DISPATCH_TAIL_CALL:
+#ifdef NAJA_VM_HAS_TAIL_CALL
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return false;
+        }
+    }
+
+    Value VM::GetResult() const
+    {
+        return m_Result;
+    }
+
+    const std::string &VM::GetError() const
+    {
+        return m_Error;
+    }
+
+    Value VM::GetGlobal(uint32_t symbol) const
+    {
+        return symbol < m_Globals.size() ? m_Globals[symbol] : Value::Empty();
+    }
+
+    void VM::Reset()
+    {
+        m_Globals.clear();
+        m_Heap.clear();
+        m_Strs.clear();
+        m_Ints.clear();
+        m_Error.clear();
+        m_Result = Value::Null();
+    }
+
+    InterpretResult VM::RunSwitch(const uint8_t *ip, ConstantPool constants)
+    {
+        Value *sp = m_Stack;
+        while (true)
+        {
+            switch (*ip++)
+            {
+            case FLOAT_NUM_OP:
+                if (!ExecFloat(constants, *ip++, sp))
+                    return INTERPRET_RUNTIME_ERROR;
+                break;
+            case INT_NUM_OP:
+                if (!ExecInt(constants, *ip++, sp))
+                    return INTERPRET_RUNTIME_ERROR;
+                break;
+            case STR_OP:
+                if (!ExecStr(constants, *ip++, sp))
+                    return INTERPRET_RUNTIME_ERROR;
+                break;
+            case FLOAT_NUM_LONG_OP:
+                if (!ExecFloat(constants, ReadLeb128(ip), sp))
+                    return INTERPRET_RUNTIME_ERROR;
+                break;
+            case INT_NUM_LONG_OP:
+                if (!ExecInt(constants, ReadLeb128(ip), sp))
+                    return INTERPRET_RUNTIME_ERROR;
+                break;
+            case STR_LONG_OP:
+                if (!ExecStr(constants, ReadLeb128(ip), sp))
+                    return INTERPRET_RUNTIME_ERROR;
+                break;
+            case TRUE_OP:
+            case FALSE_OP:
+                if (!ExecPush(Value::Bool(ip[-1] == TRUE_OP), sp))
+                    return INTERPRET_RUNTIME_ERROR;
+                break;
+            case NULL_OP:
+                if (!ExecPush(Value::Null(), sp))
+                    return INTERPRET_RUNTIME_ERROR;
+                break;
+            case PUSH_ZERO_OP:
+            case PUSH_ONE_OP:
+                if (!ExecPush(Value::SmallInt(ip[-1] - PUSH_ZERO_OP), sp))
+                    return INTERPRET_RUNTIME_ERROR;
+                break;
+            case PUSH_SMALL_INT_OP:
+                if (!ExecPush(Value::SmallInt((int8_t)*ip++), sp))
+                    return INTERPRET_RUNTIME_ERROR;
+                break;
+            case PUSH_SMALL_INT_16_OP:
+                if (!ExecPush(Value::SmallInt(ReadInt16(ip)), sp))
+                    return INTERPRET_RUNTIME_ERROR;
+                ip += 2;
+                break;
+            case RETURN_OP:
+                ExecReturn(sp);
+                return INTERPRET_OK;
+            case POP_OP:
+                if (!ExecPop(sp))
+                    return INTERPRET_RUNTIME_ERROR;
+                break;
+
+#define NAJA_VM_BINARY_CASE(op)         \
+    case op:                            \
+        if (!ExecBinary<op>(sp))        \
+            return INTERPRET_RUNTIME_ERROR; \
+        break;
+                NAJA_VM_BINARY_CASE(ADD_OP)
+                NAJA_VM_BINARY_CASE(SUB_OP)
+                NAJA_VM_BINARY_CASE(MUL_OP)
+                NAJA_VM_BINARY_CASE(DIV_OP)
+                NAJA_VM_BINARY_CASE(MOD_OP)
+                NAJA_VM_BINARY_CASE(BIT_AND_OP)
+                NAJA_VM_BINARY_CASE(BIT_OR_OP)
+                NAJA_VM_BINARY_CASE(BIT_XOR_OP)
+                NAJA_VM_BINARY_CASE(SHL_OP)
+                NAJA_VM_BINARY_CASE(SHR_OP)
+                NAJA_VM_BINARY_CASE(EQUAL_OP)
+                NAJA_VM_BINARY_CASE(NOT_EQUAL_OP)
+                NAJA_VM_BINARY_CASE(LESS_OP)
+                NAJA_VM_BINARY_CASE(LESS_EQUAL_OP)
+                NAJA_VM_BINARY_CASE(GREATER_OP)
+                NAJA_VM_BINARY_CASE(GREATER_EQUAL_OP)
+#undef NAJA_VM_BINARY_CASE
+
+            case NEGATE_OP:
+                if (!ExecNegate(sp))
+                    return INTERPRET_RUNTIME_ERROR;
+                break;
+            case NOT_OP:
+                if (!ExecNot(sp))
+                    return INTERPRET_RUNTIME_ERROR;
+                break;
+            case BIT_NOT_OP:
+                if (!ExecBitNot(sp))
+                    return INTERPRET_RUNTIME_ERROR;
+                break;
+            case DEFINE_GLOBAL_OP:
+                if (!ExecDefineGlobal(ip, sp))
+                    return INTERPRET_RUNTIME_ERROR;
+                ip += 4;
+                break;
+            case GET_GLOBAL_OP:
+                if (!ExecGetGlobal(ip, sp))
+                    return INTERPRET_RUNTIME_ERROR;
+                ip += 4;
+                break;
+            case SET_GLOBAL_OP:
+                if (!ExecSetGlobal(ip, sp))
+                    return INTERPRET_RUNTIME_ERROR;
+                ip += 4;
+                break;
+            default:
+                Error("Unknown opcode " + std::to_string(ip[-1]) + ".");
+                return INTERPRET_RUNTIME_ERROR;
+            }
+        }
+    }
+
+#ifdef NAJA_VM_HAS_COMPUTED_GOTO
+    //every handler ends in its own indirect jump,so the branch predictor sees one jump site per opcode instead of the
+    //single one of the switch loop
+    InterpretResult VM::RunGoto(const uint8_t *ip, ConstantPool constants)
+    {
+        //built once,in OpCode order.Every byte past the last opcode lands on op_unknown
+        static_assert(STR_LONG_OP == 36, "keep the label table in OpCode order");
+#define NAJA_VM_UNKNOWN_1 &&op_unknown,
+#define NAJA_VM_UNKNOWN_4 NAJA_VM_UNKNOWN_1 NAJA_VM_UNKNOWN_1 NAJA_VM_UNKNOWN_1 NAJA_VM_UNKNOWN_1
+#define NAJA_VM_UNKNOWN_16 NAJA_VM_UNKNOWN_4 NAJA_VM_UNKNOWN_4 NAJA_VM_UNKNOWN_4 NAJA_VM_UNKNOWN_4
+#define NAJA_VM_UNKNOWN_64 NAJA_VM_UNKNOWN_16 NAJA_VM_UNKNOWN_16 NAJA_VM_UNKNOWN_16 NAJA_VM_UNKNOWN_16
+        static void *const labels[] = {
+            &&op_float_num, // FLOAT_NUM_OP
+            &&op_int_num, // INT_NUM_OP
+            &&op_str, // STR_OP
+            &&op_return, // RETURN_OP
+            &&op_true, // TRUE_OP
+            &&op_false, // FALSE_OP
+            &&op_null, // NULL_OP
+            &&op_push_zero, // PUSH_ZERO_OP
+            &&op_push_one, // PUSH_ONE_OP
+            &&op_push_small_int, // PUSH_SMALL_INT_OP
+            &&op_push_small_int_16, // PUSH_SMALL_INT_16_OP
+            &&op_pop, // POP_OP
+            &&op_add, // ADD_OP
+            &&op_sub, // SUB_OP
+            &&op_mul, // MUL_OP
+            &&op_div, // DIV_OP
+            &&op_mod, // MOD_OP
+            &&op_bit_and, // BIT_AND_OP
+            &&op_bit_or, // BIT_OR_OP
+            &&op_bit_xor, // BIT_XOR_OP
+            &&op_shl, // SHL_OP
+            &&op_shr, // SHR_OP
+            &&op_equal, // EQUAL_OP
+            &&op_not_equal, // NOT_EQUAL_OP
+            &&op_less, // LESS_OP
+            &&op_less_equal, // LESS_EQUAL_OP
+            &&op_greater, // GREATER_OP
+            &&op_greater_equal, // GREATER_EQUAL_OP
+            &&op_negate, // NEGATE_OP
+            &&op_not, // NOT_OP
+            &&op_bit_not, // BIT_NOT_OP
+            &&op_define_global, // DEFINE_GLOBAL_OP
+            &&op_get_global, // GET_GLOBAL_OP
+            &&op_set_global, // SET_GLOBAL_OP
+            &&op_float_num_long, // FLOAT_NUM_LONG_OP
+            &&op_int_num_long, // INT_NUM_LONG_OP
+            &&op_str_long, // STR_LONG_OP
+            NAJA_VM_UNKNOWN_64 NAJA_VM_UNKNOWN_64 NAJA_VM_UNKNOWN_64
+            NAJA_VM_UNKNOWN_16 NAJA_VM_UNKNOWN_4 NAJA_VM_UNKNOWN_4 NAJA_VM_UNKNOWN_1 NAJA_VM_UNKNOWN_1 NAJA_VM_UNKNOWN_1
+        };
+#undef NAJA_VM_UNKNOWN_64
+#undef NAJA_VM_UNKNOWN_16
+#undef NAJA_VM_UNKNOWN_4
+#undef NAJA_VM_UNKNOWN_1
+        static_assert(sizeof(labels) / sizeof(labels[0]) == 256, "one label per opcode byte");
+
+        Value *sp = m_Stack;
+
+#define NAJA_VM_DISPATCH() goto *labels[*ip++]
+#define NAJA_VM_BINARY_LABEL(label, op)    \
+    label:                                 \
+    if (!ExecBinary<op>(sp))               \
+        return INTERPRET_RUNTIME_ERROR;    \
+    NAJA_VM_DISPATCH();
+
+        NAJA_VM_DISPATCH();
+
+    op_float_num:
+        if (!ExecFloat(constants, *ip++, sp))
+            return INTERPRET_RUNTIME_ERROR;
+        NAJA_VM_DISPATCH();
+    op_int_num:
+        if (!ExecInt(constants, *ip++, sp))
+            return INTERPRET_RUNTIME_ERROR;
+        NAJA_VM_DISPATCH();
+    op_str:
+        if (!ExecStr(constants, *ip++, sp))
+            return INTERPRET_RUNTIME_ERROR;
+        NAJA_VM_DISPATCH();
+    op_float_num_long:
+        if (!ExecFloat(constants, ReadLeb128(ip), sp))
+            return INTERPRET_RUNTIME_ERROR;
+        NAJA_VM_DISPATCH();
+    op_int_num_long:
+        if (!ExecInt(constants, ReadLeb128(ip), sp))
+            return INTERPRET_RUNTIME_ERROR;
+        NAJA_VM_DISPATCH();
+    op_str_long:
+        if (!ExecStr(constants, ReadLeb128(ip), sp))
+            return INTERPRET_RUNTIME_ERROR;
+        NAJA_VM_DISPATCH();
+    op_true:
+        if (!ExecPush(Value::Bool(true), sp))
+            return INTERPRET_RUNTIME_ERROR;
+        NAJA_VM_DISPATCH();
+    op_false:
+        if (!ExecPush(Value::Bool(false), sp))
+            return INTERPRET_RUNTIME_ERROR;
+        NAJA_VM_DISPATCH();
+    op_null:
+        if (!ExecPush(Value::Null(), sp))
+            return INTERPRET_RUNTIME_ERROR;
+        NAJA_VM_DISPATCH();
+    op_push_zero:
+        if (!ExecPush(Value::SmallInt(0), sp))
+            return INTERPRET_RUNTIME_ERROR;
+        NAJA_VM_DISPATCH();
+    op_push_one:
+        if (!ExecPush(Value::SmallInt(1), sp))
+            return INTERPRET_RUNTIME_ERROR;
+        NAJA_VM_DISPATCH();
+    op_push_small_int:
+        if (!ExecPush(Value::SmallInt((int8_t)*ip++), sp))
+            return INTERPRET_RUNTIME_ERROR;
+        NAJA_VM_DISPATCH();
+    op_push_small_int_16:
+        if (!ExecPush(Value::SmallInt(ReadInt16(ip)), sp))
+            return INTERPRET_RUNTIME_ERROR;
+        ip += 2;
+        NAJA_VM_DISPATCH();
+    op_return:
+        ExecReturn(sp);
+        return INTERPRET_OK;
+    op_pop:
+        if (!ExecPop(sp))
+            return INTERPRET_RUNTIME_ERROR;
+        NAJA_VM_DISPATCH();
+
+        NAJA_VM_BINARY_LABEL(op_add, ADD_OP)
+        NAJA_VM_BINARY_LABEL(op_sub, SUB_OP)
+        NAJA_VM_BINARY_LABEL(op_mul, MUL_OP)
+        NAJA_VM_BINARY_LABEL(op_div, DIV_OP)
+        NAJA_VM_BINARY_LABEL(op_mod, MOD_OP)
+        NAJA_VM_BINARY_LABEL(op_bit_and, BIT_AND_OP)
+        NAJA_VM_BINARY_LABEL(op_bit_or, BIT_OR_OP)
+        NAJA_VM_BINARY_LABEL(op_bit_xor, BIT_XOR_OP)
+        NAJA_VM_BINARY_LABEL(op_shl, SHL_OP)
+        NAJA_VM_BINARY_LABEL(op_shr, SHR_OP)
+        NAJA_VM_BINARY_LABEL(op_equal, EQUAL_OP)
+        NAJA_VM_BINARY_LABEL(op_not_equal, NOT_EQUAL_OP)
+        NAJA_VM_BINARY_LABEL(op_less, LESS_OP)
+        NAJA_VM_BINARY_LABEL(op_less_equal, LESS_EQUAL_OP)
+        NAJA_VM_BINARY_LABEL(op_greater, GREATER_OP)
+        NAJA_VM_BINARY_LABEL(op_greater_equal, GREATER_EQUAL_OP)
+
+    op_negate:
+        if (!ExecNegate(sp))
+            return INTERPRET_RUNTIME_ERROR;
+        NAJA_VM_DISPATCH();
+    op_not:
+        if (!ExecNot(sp))
+            return INTERPRET_RUNTIME_ERROR;
+        NAJA_VM_DISPATCH();
+    op_bit_not:
+        if (!ExecBitNot(sp))
+            return INTERPRET_RUNTIME_ERROR;
+        NAJA_VM_DISPATCH();
+    op_define_global:
+        if (!ExecDefineGlobal(ip, sp))
+            return INTERPRET_RUNTIME_ERROR;
+        ip += 4;
+        NAJA_VM_DISPATCH();
+    op_get_global:
+        if (!ExecGetGlobal(ip, sp))
+            return INTERPRET_RUNTIME_ERROR;
+        ip += 4;
+        NAJA_VM_DISPATCH();
+    op_set_global:
+        if (!ExecSetGlobal(ip, sp))
+            return INTERPRET_RUNTIME_ERROR;
+        ip += 4;
+        NAJA_VM_DISPATCH();
+    op_unknown:
+        Error("Unknown opcode " + std::to_string(ip[-1]) + ".");
+        return INTERPRET_RUNTIME_ERROR;
+
+#undef NAJA_VM_BINARY_LABEL
+#undef NAJA_VM_DISPATCH
+    }
+#else
+    InterpretResult VM::RunGoto(const uint8_t *ip, ConstantPool constants)
+    {
+        return RunSwitch(ip, constants);
+    }
+#endif
+
+#ifdef NAJA_VM_HAS_TAIL_CALL
+    //one function per opcode with the interpreter state in argument registers,each handler calls the next one as its
+    //last act so the call compiles to a jump and the state never touches memory between instructions
+    struct TailCallHandlers
+    {
+        using Handler = InterpretResult (*)(VM &vm, const uint8_t *ip, Value *sp, const ConstantPool *constants);
+
+#define NAJA_VM_NEXT(length) NAJA_VM_MUSTTAIL return table[ip[length]](vm, ip + (length), sp, constants)
+
+        //EXEC is one of the VM's constant loaders,the operand is a byte or,for the _LONG ops,a LEB128 index
+        template <bool (VM::*EXEC)(const ConstantPool &, uint64_t, Value *&)>
+        static InterpretResult Constant(VM &vm, const uint8_t *ip, Value *sp, const ConstantPool *constants)
+        {
+            if (!(vm.*EXEC)(*constants, ip[1], sp))
+                return INTERPRET_RUNTIME_ERROR;
+            NAJA_VM_NEXT(2);
+        }
+
+        template <bool (VM::*EXEC)(const ConstantPool &, uint64_t, Value *&)>
+        static InterpretResult ConstantLong(VM &vm, const uint8_t *ip, Value *sp, const ConstantPool *constants)
+        {
+            const uint8_t *next = ip + 1;
+            if (!(vm.*EXEC)(*constants, ReadLeb128(next), sp))
+                return INTERPRET_RUNTIME_ERROR;
+            NAJA_VM_NEXT(next - ip);
+        }
+
+        template <bool VALUE>
+        static InterpretResult Bool(VM &vm, const uint8_t *ip, Value *sp, const ConstantPool *constants)
+        {
+            if (!vm.ExecPush(Value::Bool(VALUE), sp))
+                return INTERPRET_RUNTIME_ERROR;
+            NAJA_VM_NEXT(1);
+        }
+
+        static InterpretResult Null(VM &vm, const uint8_t *ip, Value *sp, const ConstantPool *constants)
+        {
+            if (!vm.ExecPush(Value::Null(), sp))
+                return INTERPRET_RUNTIME_ERROR;
+            NAJA_VM_NEXT(1);
+        }
+
+        template <int64_t VALUE>
+        static InterpretResult PushInt(VM &vm, const uint8_t *ip, Value *sp, const ConstantPool *constants)
+        {
+            if (!vm.ExecPush(Value::SmallInt(VALUE), sp))
+                return INTERPRET_RUNTIME_ERROR;
+            NAJA_VM_NEXT(1);
+        }
+
+        static InterpretResult PushSmallInt(VM &vm, const uint8_t *ip, Value *sp, const ConstantPool *constants)
+        {
+            if (!vm.ExecPush(Value::SmallInt((int8_t)ip[1]), sp))
+                return INTERPRET_RUNTIME_ERROR;
+            NAJA_VM_NEXT(2);
+        }
+
+        static InterpretResult PushSmallInt16(VM &vm, const uint8_t *ip, Value *sp, const ConstantPool *constants)
+        {
+            if (!vm.ExecPush(Value::SmallInt(ReadInt16(ip + 1)), sp))
+                return INTERPRET_RUNTIME_ERROR;
+            NAJA_VM_NEXT(3);
+        }
+
+        static InterpretResult Return(VM &vm, const uint8_t *, Value *sp, const ConstantPool *)
+        {
+            vm.ExecReturn(sp);
+            return INTERPRET_OK;
+        }
+
+        static InterpretResult Pop(VM &vm, const uint8_t *ip, Value *sp, const ConstantPool *constants)
+        {
+            if (!vm.ExecPop(sp))
+                return INTERPRET_RUNTIME_ERROR;
+            NAJA_VM_NEXT(1);
+        }
+
+        template <OpCode OP>
+        static InterpretResult Binary(VM &vm, const uint8_t *ip, Value *sp, const ConstantPool *constants)
+        {
+            if (!vm.ExecBinary<OP>(sp))
+                return INTERPRET_RUNTIME_ERROR;
+            NAJA_VM_NEXT(1);
+        }
+
+        static InterpretResult Negate(VM &vm, const uint8_t *ip, Value *sp, const ConstantPool *constants)
+        {
+            if (!vm.ExecNegate(sp))
+                return INTERPRET_RUNTIME_ERROR;
+            NAJA_VM_NEXT(1);
+        }
+
+        static InterpretResult Not(VM &vm, const uint8_t *ip, Value *sp, const ConstantPool *constants)
+        {
+            if (!vm.ExecNot(sp))
+                return INTERPRET_RUNTIME_ERROR;
+            NAJA_VM_NEXT(1);
+        }
+
+        static InterpretResult BitNot(VM &vm, const uint8_t *ip, Value *sp, const ConstantPool *constants)
+        {
+            if (!vm.ExecBitNot(sp))
+                return INTERPRET_RUNTIME_ERROR;
+            NAJA_VM_NEXT(1);
+        }
+
+        static InterpretResult DefineGlobal(VM &vm, const uint8_t *ip, Value *sp, const ConstantPool *constants)
+        {
+            if (!vm.ExecDefineGlobal(ip + 1, sp))
+                return INTERPRET_RUNTIME_ERROR;
+            NAJA_VM_NEXT(5);
+        }
+
+        static InterpretResult GetGlobal(VM &vm, const uint8_t *ip, Value *sp, const ConstantPool *constants)
+        {
+            if (!vm.ExecGetGlobal(ip + 1, sp))
+                return INTERPRET_RUNTIME_ERROR;
+            NAJA_VM_NEXT(5);
+        }
+
+        static InterpretResult SetGlobal(VM &vm, const uint8_t *ip, Value *sp, const ConstantPool *constants)
+        {
+            if (!vm.ExecSetGlobal(ip + 1, sp))
+                return INTERPRET_RUNTIME_ERROR;
+            NAJA_VM_NEXT(5);
+        }
+
+        static InterpretResult Unknown(VM &vm, const uint8_t *ip, Value *, const ConstantPool *)
+        {
+            vm.Error("Unknown opcode " + std::to_string(ip[0]) + ".");
+            return INTERPRET_RUNTIME_ERROR;
+        }
+
+#undef NAJA_VM_NEXT
+
+        static const std::array<Handler, 256> table;
+    };
+
+    constexpr std::array<TailCallHandlers::Handler, 256> TailCallHandlers::table = []
+    {
+        std::array<Handler, 256> table{};
+        table.fill(Unknown);
+        table[FLOAT_NUM_OP] = Constant<&VM::ExecFloat>;
+        table[INT_NUM_OP] = Constant<&VM::ExecInt>;
+        table[STR_OP] = Constant<&VM::ExecStr>;
+        table[FLOAT_NUM_LONG_OP] = ConstantLong<&VM::ExecFloat>;
+        table[INT_NUM_LONG_OP] = ConstantLong<&VM::ExecInt>;
+        table[STR_LONG_OP] = ConstantLong<&VM::ExecStr>;
+        table[TRUE_OP] = Bool<true>;
+        table[FALSE_OP] = Bool<false>;
+        table[NULL_OP] = Null;
+        table[PUSH_ZERO_OP] = PushInt<0>;
+        table[PUSH_ONE_OP] = PushInt<1>;
+        table[PUSH_SMALL_INT_OP] = PushSmallInt;
+        table[PUSH_SMALL_INT_16_OP] = PushSmallInt16;
+        table[RETURN_OP] = Return;
+        table[POP_OP] = Pop;
+        table[ADD_OP] = Binary<ADD_OP>;
+        table[SUB_OP] = Binary<SUB_OP>;
+        table[MUL_OP] = Binary<MUL_OP>;
+        table[DIV_OP] = Binary<DIV_OP>;
+        table[MOD_OP] = Binary<MOD_OP>;
+        table[BIT_AND_OP] = Binary<BIT_AND_OP>;
+        table[BIT_OR_OP] = Binary<BIT_OR_OP>;
+        table[BIT_XOR_OP] = Binary<BIT_XOR_OP>;
+        table[SHL_OP] = Binary<SHL_OP>;
+        table[SHR_OP] = Binary<SHR_OP>;
+        table[EQUAL_OP] = Binary<EQUAL_OP>;
+        table[NOT_EQUAL_OP] = Binary<NOT_EQUAL_OP>;
+        table[LESS_OP] = Binary<LESS_OP>;
+        table[LESS_EQUAL_OP] = Binary<LESS_EQUAL_OP>;
+        table[GREATER_OP] = Binary<GREATER_OP>;
+        table[GREATER_EQUAL_OP] = Binary<GREATER_EQUAL_OP>;
+        table[NEGATE_OP] = Negate;
+        table[NOT_OP] = Not;
+        table[BIT_NOT_OP] = BitNot;
+        table[DEFINE_GLOBAL_OP] = DefineGlobal;
+        table[GET_GLOBAL_OP] = GetGlobal;
+        table[SET_GLOBAL_OP] = SetGlobal;
+        return table;
+    }();
+
+    InterpretResult VM::RunTailCall(const uint8_t *ip, const ConstantPool *constants)
+    {
+        return TailCallHandlers::table[*ip](*this, ip, m_Stack, constants);
+    }
+#else
+    InterpretResult VM::RunTailCall(const uint8_t *ip, const ConstantPool *constants)
+    {
+        return RunSwitch(ip, *constants);
+    }
+#endif
+
+    //ints wrap around on overflow,division by zero and shifts outside [0,63] are errors.Two small ints take the first
+    //branch without touching memory
+    template <OpCode OP>
+    inline bool VM::ExecBinary(Value *&sp)
+    {
+        if (!HasValues(sp, 2))
+            return Error("Stack underflow.");
+        Value right = *--sp;
+        Value &left = sp[-1];
+
+        if constexpr (OP == EQUAL_OP || OP == NOT_EQUAL_OP)
+        {
+            left = Value::Bool(IsEqual(left, right) == (OP == EQUAL_OP));
+            return true;
+        }
+        else
+        {
+            if (left.IsInt() && right.IsInt())
+            {
+                int64_t a = left.AsInt();
+                int64_t b = right.AsInt();
+                if constexpr (OP == ADD_OP)
+                    left = MakeInt((int64_t)((uint64_t)a + (uint64_t)b));
+                else if constexpr (OP == SUB_OP)
+                    left = MakeInt((int64_t)((uint64_t)a - (uint64_t)b));
+                else if constexpr (OP == MUL_OP)
+                    left = MakeInt((int64_t)((uint64_t)a * (uint64_t)b));
+                else if constexpr (OP == DIV_OP || OP == MOD_OP)
+                {
+                    if (b == 0)
+                        return Error("Division by zero.");
+                    if (b == -1) //INT64_MIN/-1 wraps like the other operators
+                        left = MakeInt(OP == DIV_OP ? (int64_t)(0 - (uint64_t)a) : 0);
+                    else
+                        left = MakeInt(OP == DIV_OP ? a / b : a % b);
+                }
+                else if constexpr (OP == BIT_AND_OP)
+                    left = MakeInt(a & b);
+                else if constexpr (OP == BIT_OR_OP)
+                    left = MakeInt(a | b);
+                else if constexpr (OP == BIT_XOR_OP)
+                    left = MakeInt(a ^ b);
+                else if constexpr (OP == SHL_OP || OP == SHR_OP)
+                {
+                    if (b < 0 || b > 63)
+                        return Error("Shift count out of range.");
+                    left = MakeInt(OP == SHL_OP ? (int64_t)((uint64_t)a << b) : a >> b);
+                }
+                else if constexpr (OP == LESS_OP)
+                    left = Value::Bool(a < b);
+                else if constexpr (OP == LESS_EQUAL_OP)
+                    left = Value::Bool(a <= b);
+                else if constexpr (OP == GREATER_OP)
+                    left = Value::Bool(a > b);
+                else
+                    left = Value::Bool(a >= b);
+                return true;
+            }
+
+            if constexpr (OP == BIT_AND_OP || OP == BIT_OR_OP || OP == BIT_XOR_OP || OP == SHL_OP || OP == SHR_OP)
+                return Error("Operands must be integers.");
+            else
+            {
+                if (!left.IsNumber() || !right.IsNumber())
+                    return Error("Operands must be numbers.");
+                double a = left.AsNumber();
+                double b = right.AsNumber();
+                if constexpr (OP == ADD_OP)
+                    left = Value::Float(a + b);
+                else if constexpr (OP == SUB_OP)
+                    left = Value::Float(a - b);
+                else if constexpr (OP == MUL_OP)
+                    left = Value::Float(a * b);
+                else if constexpr (OP == DIV_OP || OP == MOD_OP)
+                {
+                    if (b == 0.0)
+                        return Error("Division by zero.");
+                    left = Value::Float(OP == DIV_OP ? a / b : std::fmod(a, b));
+                }
+                else if constexpr (OP == LESS_OP)
+                    left = Value::Bool(a < b);
+                else if constexpr (OP == LESS_EQUAL_OP)
+                    left = Value::Bool(a <= b);
+                else if constexpr (OP == GREATER_OP)
+                    left = Value::Bool(a > b);
+                else
+                    left = Value::Bool(a >= b);
+                return true;
+            }
+        }
+    }
+
+    inline bool VM::ExecFloat(const ConstantPool &constants, uint64_t index, Value *&sp)
+    {
+        return ExecPush(Value::Float(constants.floats[index]), sp);
+    }
+
+    inline bool VM::ExecInt(const ConstantPool &constants, uint64_t index, Value *&sp)
+    {
+        return ExecPush(constants.ints[index], sp);
+    }
+
+    inline bool VM::ExecStr(const ConstantPool &constants, uint64_t index, Value *&sp)
+    {
+        return ExecPush(Value::Obj(constants.strs[index].get()), sp);
+    }
+
+    inline bool VM::ExecNegate(Value *&sp)
+    {
+        if (!HasValues(sp, 1))
+            return Error("Stack underflow.");
+        Value &value = sp[-1];
+        if (value.IsFloat())
+            value = Value::Float(-value.AsFloat());
+        else if (value.IsInt())
+            value = MakeInt((int64_t)(0 - (uint64_t)value.AsInt()));
+        else
+            return Error("Operand must be a number.");
+        return true;
+    }
+
+    inline bool VM::ExecNot(Value *&sp)
+    {
+        if (!HasValues(sp, 1))
+            return Error("Stack underflow.");
+        sp[-1] = Value::Bool(sp[-1].IsFalsy());
+        return true;
+    }
+
+    inline bool VM::ExecBitNot(Value *&sp)
+    {
+        if (!HasValues(sp, 1))
+            return Error("Stack underflow.");
+        Value &value = sp[-1];
+        if (!value.IsInt())
+            return Error("Operand must be an integer.");
+        value = MakeInt(~value.AsInt());
+        return true;
+    }
+
+    inline bool VM::ExecDefineGlobal(const uint8_t *ip, Value *&sp)
+    {
+        if (!HasValues(sp, 1))
+            return Error("Stack underflow.");
+        uint32_t symbol = ReadSymbol(ip);
+        if (symbol >= m_Globals.size())
+            m_Globals.resize(symbol + 1, Value::Empty());
+        m_Globals[symbol] = Escape(*--sp);
+        return true;
+    }
+
+    inline bool VM::ExecGetGlobal(const uint8_t *ip, Value *&sp)
+    {
+        uint32_t symbol = ReadSymbol(ip);
+        if (symbol >= m_Globals.size() || m_Globals[symbol].IsEmpty())
+            return UndefinedError(symbol);
+        return ExecPush(m_Globals[symbol], sp);
+    }
+
+    inline bool VM::ExecSetGlobal(const uint8_t *ip, Value *&sp)
+    {
+        if (!HasValues(sp, 1))
+            return Error("Stack underflow.");
+        uint32_t symbol = ReadSymbol(ip);
+        if (symbol >= m_Globals.size() || m_Globals[symbol].IsEmpty())
+            return UndefinedError(symbol);
+        m_Globals[symbol] = Escape(sp[-1]);
+        return true;
+    }
+
+    inline bool VM::ExecPop(Value *&sp)
+    {
+        if (!HasValues(sp, 1))
+            return Error("Stack underflow.");
+        --sp;
+        return true;
+    }
+
+    inline bool VM::ExecPush(Value value, Value *&sp)
+    {
+        if (sp == m_Stack + STACK_SIZE)
+            return Error("Stack overflow.");
+        *sp++ = value;
+        return true;
+    }
+
+    inline void VM::ExecReturn(Value *sp)
+    {
+        m_Result = sp > m_Stack ? Escape(sp[-1]) : Value::Null();
+    }
+
+    //the error paths stay out of line and take no temporaries:a string built inside a handler stops GCC from turning
+    //its last call into a jump
+    [[gnu::noinline, gnu::cold]] bool VM::Error(std::string_view message)
+    {
+        m_Error = message;
+        return false;
+    }
+
+    [[gnu::noinline, gnu::cold]] bool VM::UndefinedError(uint32_t symbol)
+    {
+        return Error("Undefined variable '" + std::string(GetSymbolTable().GetName(symbol)) + "'.");
+    }
+
+    inline Value VM::MakeInt(int64_t value)
+    {
+        return Value::FitsSmallInt(value) ? Value::SmallInt(value) : BoxInt(value);
+    }
+
+    [[gnu::noinline, gnu::cold]] Value VM::BoxInt(int64_t value)
+    {
+        m_Heap.emplace_back(new IntNumObject(value));
+        return Value::Obj(m_Heap.back().get());
+    }
+
+    inline Value VM::Escape(Value value)
+    {
+        return value.IsObject() ? Intern(value.AsObject()) : value;
+    }
+
+    [[gnu::noinline]] Value VM::Intern(Object *object)
+    {
+        if (object->Type() == INT_NUM_OBJECT)
+        {
+            int64_t value = ((IntNumObject *)object)->value;
+            auto &copy = m_Ints[value];
+            if (!copy)
+                copy = std::make_unique<IntNumObject>(value);
+            return Value::Obj(copy.get());
+        }
+
+        const std::string &value = ((StrObject *)object)->value;
+        auto iter = m_Strs.find(value);
+        if (iter == m_Strs.end())
+        {
+            auto copy = std::make_unique<StrObject>(value);
+            std::string_view key = copy->value;
+            iter = m_Strs.emplace(key, std::move(copy)).first;
+        }
+        return Value::Obj(iter->second.get());
+    }
+}
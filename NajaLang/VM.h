@@ -1 +1,122 @@
-#pragma once
\ No newline at end of file
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "Chunk.h"
+#include "Object.h"
+#include "Value.h"
+
+// how the VM gets from one instruction to the next.The build picks the default through NAJA_VM_DISPATCH_SWITCH,
+// NAJA_VM_DISPATCH_GOTO or NAJA_VM_DISPATCH_TAIL_CALL,the others stay available to VM::Run where the compiler
+// supports them
+#if defined(__GNUC__)
+#define NAJA_VM_HAS_COMPUTED_GOTO 1
+#endif
+
+// tail call threading needs every handler to end in a real jump:guaranteed with musttail,and left to sibling call
+// optimisation by GCC when optimising.Without either each instruction would take a stack frame
+#if defined(__has_cpp_attribute)
+#if __has_cpp_attribute(clang::musttail)
+#define NAJA_VM_HAS_TAIL_CALL 1
+#define NAJA_VM_MUSTTAIL [[clang::musttail]]
+#endif
+#endif
+#if !defined(NAJA_VM_HAS_TAIL_CALL) && defined(__GNUC__) && defined(__OPTIMIZE__)
+#define NAJA_VM_HAS_TAIL_CALL 1
+#define NAJA_VM_MUSTTAIL
+#endif
+
+namespace NajaLang
+{
+    enum VMDispatch
+    {
+        VM_DISPATCH_SWITCH,    // one loop around a switch on the opcode
+        VM_DISPATCH_GOTO,      // computed goto,every handler jumps through the label table on its own
+        VM_DISPATCH_TAIL_CALL, // one function per opcode,each ending in a tail call of the next handler
+    };
+
+    enum InterpretResult
+    {
+        INTERPRET_OK,
+        INTERPRET_COMPILE_ERROR, // the chunk was compiled with errors and did not run
+        INTERPRET_RUNTIME_ERROR,
+    };
+
+    // runs the code of a Chunk on a fixed value stack.Globals and the values they hold stay alive until Reset,so one
+    // VM can run chunk after chunk the way a REPL does
+    class VM
+    {
+    public:
+        VM();
+        ~VM();
+
+        VM(const VM &) = delete;
+        VM &operator=(const VM &) = delete;
+
+        // the code must end in RETURN_OP.A chunk the Compiler could not complete is refused with
+        // INTERPRET_COMPILE_ERROR.Popping more than was pushed is a runtime error rather than undefined behaviour,every
+        // instruction that pops checks the depth first.An unsupported dispatch falls back to the default
+        InterpretResult Run(const Chunk &chunk);
+        InterpretResult Run(const Chunk &chunk, VMDispatch dispatch);
+
+        static VMDispatch GetDefaultDispatch();
+        static bool IsDispatchSupported(VMDispatch dispatch);
+
+        // the value RETURN_OP found on top of the stack,null if it was empty
+        Value GetResult() const;
+        const std::string &GetError() const;
+        // empty if the global was never defined
+        Value GetGlobal(uint32_t symbol) const;
+
+        void Reset();
+
+    private:
+        static constexpr uint64_t STACK_SIZE = 16 * 1024; // values
+
+        InterpretResult RunSwitch(const uint8_t *ip, ConstantPool constants);
+        InterpretResult RunGoto(const uint8_t *ip, ConstantPool constants);
+        InterpretResult RunTailCall(const uint8_t *ip, const ConstantPool *constants);
+
+        // the instructions,shared by every dispatch loop.sp points behind the top value,false means a runtime error
+        template <OpCode OP>
+        bool ExecBinary(Value *&sp);
+        bool ExecFloat(const ConstantPool &constants, uint64_t index, Value *&sp);
+        bool ExecInt(const ConstantPool &constants, uint64_t index, Value *&sp);
+        bool ExecStr(const ConstantPool &constants, uint64_t index, Value *&sp);
+        bool ExecNegate(Value *&sp);
+        bool ExecNot(Value *&sp);
+        bool ExecBitNot(Value *&sp);
+        bool ExecDefineGlobal(const uint8_t *ip, Value *&sp);
+        bool ExecGetGlobal(const uint8_t *ip, Value *&sp);
+        bool ExecSetGlobal(const uint8_t *ip, Value *&sp);
+        bool ExecPop(Value *&sp);
+        bool ExecPush(Value value, Value *&sp);
+        void ExecReturn(Value *sp);
+
+        // at least count values below sp
+        bool HasValues(const Value *sp, ptrdiff_t count) const { return sp - m_Stack >= count; }
+        bool Error(std::string_view message);
+        bool UndefinedError(uint32_t symbol);
+        // results outside the small int range are boxed on m_Heap,the only instruction path that allocates
+        Value MakeInt(int64_t value);
+        Value BoxInt(int64_t value);
+        // objects on the stack belong to the running Chunk or to m_Heap.The ones stored in a global or returned are
+        // swapped for an interned copy,so they outlive both
+        Value Escape(Value value);
+        Value Intern(Object *object);
+
+        friend struct TailCallHandlers;
+
+        Value m_Stack[STACK_SIZE];
+        Value m_Result;
+        std::vector<Value> m_Globals; // indexed by symbol,empty until defined
+        std::vector<std::unique_ptr<Object>> m_Heap; // temporaries,freed when Run returns
+        std::unordered_map<std::string_view, std::unique_ptr<StrObject>> m_Strs; // keyed by the value of the object
+        std::unordered_map<int64_t, std::unique_ptr<IntNumObject>> m_Ints;
+        std::string m_Error;
+    };
+}
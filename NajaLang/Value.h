@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "Object.h"
+namespace NajaLang
+{
+    // a NaN boxed value in 64 bits.Doubles are stored as they are,everything else hides in the payload of a quiet NaN
+    // that arithmetic never produces:
+    //  0x7FFC|kind<<48|payload   small int(48 bit two's complement),bool,null or the empty marker
+    //  0xFFFC|pointer            heap object:strings and ints outside the small int range
+    // NaNs that would collide with the boxed ranges are folded into one canonical NaN when they are stored
+    class Value
+    {
+    public:
+        static constexpr int64_t SMALL_INT_MIN = -(INT64_C(1) << 47);
+        static constexpr int64_t SMALL_INT_MAX = (INT64_C(1) << 47) - 1;
+
+        // null
+        Value() : m_Bits(NULL_BITS) {}
+
+        static Value Float(double value)
+        {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            if ((bits & QNAN) == QNAN)
+                bits = CANONICAL_NAN;
+            return Value(bits);
+        }
+        // value must lie in [SMALL_INT_MIN,SMALL_INT_MAX],anything wider is boxed as an IntNumObject by its owner
+        static Value SmallInt(int64_t value) { return Value(QNAN | INT_KIND | ((uint64_t)value & PAYLOAD_MASK)); }
+        static Value Bool(bool value) { return Value(value ? TRUE_BITS : FALSE_BITS); }
+        static Value Null() { return Value(NULL_BITS); }
+        static Value Obj(Object *object) { return Value(SIGN_BIT | QNAN | (uint64_t)(uintptr_t)object); }
+        // marks unset slots such as undefined globals,never the value of an expression
+        static Value Empty() { return Value(EMPTY_BITS); }
+
+        static bool FitsSmallInt(int64_t value) { return value >= SMALL_INT_MIN && value <= SMALL_INT_MAX; }
+
+        bool IsFloat() const { return (m_Bits & QNAN) != QNAN; }
+        bool IsSmallInt() const { return (m_Bits & (SIGN_BIT | QNAN | KIND_MASK)) == (QNAN | INT_KIND); }
+        bool IsBool() const { return (m_Bits | 1) == TRUE_BITS; }
+        bool IsTrue() const { return m_Bits == TRUE_BITS; }
+        bool IsNull() const { return m_Bits == NULL_BITS; }
+        bool IsEmpty() const { return m_Bits == EMPTY_BITS; }
+        bool IsObject() const { return (m_Bits & (SIGN_BIT | QNAN)) == (SIGN_BIT | QNAN); }
+        // small or boxed
+        bool IsInt() const { return IsSmallInt() || (IsObject() && AsObject()->Type() == INT_NUM_OBJECT); }
+        bool IsNumber() const { return IsFloat() || IsInt(); }
+        bool IsStr() const { return IsObject() && AsObject()->Type() == STR_OBJECT; }
+        // false and null are falsy,everything else is truthy
+        bool IsFalsy() const { return m_Bits == FALSE_BITS || m_Bits == NULL_BITS; }
+
+        double AsFloat() const
+        {
+            double value;
+            std::memcpy(&value, &m_Bits, sizeof(value));
+            return value;
+        }
+        // sign extends the 48 bit payload
+        int64_t AsSmallInt() const { return (int64_t)(m_Bits << 16) >> 16; }
+        Object *AsObject() const { return (Object *)(uintptr_t)(m_Bits & PAYLOAD_MASK); }
+        int64_t AsInt() const { return IsSmallInt() ? AsSmallInt() : ((IntNumObject *)AsObject())->value; }
+        // ints are converted
+        double AsNumber() const { return IsFloat() ? AsFloat() : (double)AsInt(); }
+
+        uint64_t GetBits() const { return m_Bits; }
+
+        std::string Stringify() const
+        {
+            if (IsFloat())
+                return std::to_string(AsFloat());
+            if (IsSmallInt())
+                return std::to_string(AsSmallInt());
+            if (IsObject())
+                return AsObject()->Stringify();
+            if (IsBool())
+                return IsTrue() ? "true" : "false";
+            return IsNull() ? "null" : "<empty>";
+        }
+
+    private:
+        explicit Value(uint64_t bits) : m_Bits(bits) {}
+
+        static constexpr uint64_t SIGN_BIT = UINT64_C(0x8000000000000000);
+        static constexpr uint64_t QNAN = UINT64_C(0x7FFC000000000000);
+        static constexpr uint64_t CANONICAL_NAN = UINT64_C(0x7FF8000000000000);
+        static constexpr uint64_t PAYLOAD_MASK = UINT64_C(0x0000FFFFFFFFFFFF);
+        static constexpr uint64_t KIND_MASK = UINT64_C(3) << 48;
+        static constexpr uint64_t INT_KIND = UINT64_C(1) << 48;
+        static constexpr uint64_t BOOL_KIND = UINT64_C(2) << 48;
+        static constexpr uint64_t NULL_KIND = UINT64_C(3) << 48;
+
+        static constexpr uint64_t EMPTY_BITS = QNAN;
+        static constexpr uint64_t FALSE_BITS = QNAN | BOOL_KIND;
+        static constexpr uint64_t TRUE_BITS = QNAN | BOOL_KIND | 1;
+        static constexpr uint64_t NULL_BITS = QNAN | NULL_KIND;
+
+        uint64_t m_Bits;
+    };
+}
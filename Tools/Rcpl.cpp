@@ -8,19 +8,23 @@ void Rcpl()
 	std::string line;
 	NajaLang::Lexer lexer;
 	NajaLang::Parser parser;
+	NajaLang::ConstantFolder folder;
 	NajaLang::Compiler compiler;
 	std::cout << "> ";
 	while (getline(std::cin, line))
 	{
-		auto tokens = lexer.ScanTokens(line);
+		const auto &tokens = lexer.ScanTokens(line);
 		auto stmt = parser.Parse(tokens);
 
 		if (parser.HasError())
 			parser.PrintErrors();
 
-        auto chunk=compiler.Compile(stmt);
+        auto &chunk=compiler.Compile(folder.Fold(stmt));
 
-        std::cout<<chunk.Stringify()<<std::endl;
+        if (compiler.HasError())
+            compiler.PrintErrors();
+        else
+            std::cout<<chunk.Stringify()<<std::endl;
 
 		std::cout << "> ";
 	}
@@ -28,18 +32,23 @@ void Rcpl()
 
 void RunFile(std::string path)
 {
-	std::string content = ReadFile(path);
+	NajaLang::SourceFile file;
+	std::string_view content = LoadFile(file, path);
 	NajaLang::Lexer lexer;
 	NajaLang::Parser parser;
 
-	auto tokens = lexer.ScanTokens(content);
+	lexer.SetSource(content);
 
-	auto stmts = parser.Parse(tokens);
+	auto stmts = parser.Parse(lexer);
 
 	if (parser.HasError())
 			parser.PrintErrors();
 
-	std::cout << stmts->Stringify() << std::endl;
+	{
+		NajaLang::AstPrinter printer(std::cout);
+		printer.Print(stmts);
+	}
+	std::cout << std::endl;
 }
 
 int main(int argc, char **argv)
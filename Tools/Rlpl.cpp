@@ -10,7 +10,7 @@ void Rlpl()
     std::cout << "> ";
     while (getline(std::cin, line))
     {
-        auto tokens = lexer.ScanTokens(line);
+        const auto &tokens = lexer.ScanTokens(line);
         for (const auto &token : tokens)
             std::cout << token << std::endl;
 
@@ -20,9 +20,10 @@ void Rlpl()
 
 void RunFile(std::string_view path)
 {
-    std::string content = ReadFile(path);
+    NajaLang::SourceFile file;
+    std::string_view content = LoadFile(file, path);
     NajaLang::Lexer lexer;
-    auto tokens = lexer.ScanTokens(content);
+    const auto &tokens = lexer.ScanTokens(content);
     for (const auto &token : tokens)
         std::cout << token << std::endl;
 }
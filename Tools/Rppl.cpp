@@ -11,7 +11,7 @@ void Rppl()
 	std::cout << "> ";
 	while (getline(std::cin, line))
 	{
-		auto tokens = lexer.ScanTokens(line);
+		const auto &tokens = lexer.ScanTokens(line);
 		auto stmt = parser.Parse(tokens);
 
 		if (parser.HasError())
@@ -23,29 +23,45 @@ void Rppl()
 	}
 }
 
-void RunFile(std::string path)
+void RunFile(std::string path, std::string cacheDir)
 {
-	std::string content = ReadFile(path);
+	NajaLang::SourceFile file;
+	std::string_view content = LoadFile(file, path);
 	NajaLang::Lexer lexer;
+	NajaLang::TokenBuffer tokens;
 	NajaLang::Parser parser;
 
-	auto tokens = lexer.ScanTokens(content);
-
-	auto stmts = parser.Parse(tokens);
+	NajaLang::Stmt *stmts;
+	if (!cacheDir.empty())
+	{
+		//a cache hit skips the lexer and the parser
+		NajaLang::AstCache cache(cacheDir);
+		stmts = cache.Parse(content, lexer, parser);
+	}
+	else
+	{
+		lexer.ScanTokens(content, tokens);
+		stmts = parser.Parse(tokens);
+	}
 
 	if (parser.HasError())
 			parser.PrintErrors();
 
-	std::cout << stmts->Stringify() << std::endl;
+	{
+		//streamed as it is printed,a dump is never held in memory as a whole
+		NajaLang::AstPrinter printer(std::cout);
+		printer.Print(stmts);
+	}
+	std::cout << std::endl;
 }
 
 int main(int argc, char **argv)
 {
-	if (argc == 2)
-		RunFile(argv[1]);
+	if (argc == 2 || argc == 3)
+		RunFile(argv[1], argc == 3 ? argv[2] : "");
 	else if (argc == 1)
 		Rppl();
 	else
-		std::cout << "Usage: rppl [filepath]" << std::endl;
+		std::cout << "Usage: rppl [filepath [cachedir]]" << std::endl;
 	return 0;
 }
\ No newline at end of file
@@ -1,20 +1,14 @@
 #pragma once
 #include <string>
-#include <memory>
-#include <fstream>
-#include <sstream>
+#include <string_view>
 #include <iostream>
-inline std::string ReadFile(std::string_view path)
+#include "SourceFile.h"
+inline std::string_view LoadFile(NajaLang::SourceFile &file, std::string_view path)
 {
-    std::fstream file;
-    file.open(path.data(), std::ios::in | std::ios::binary);
-    if (!file.is_open())
+    if (!file.Open(path))
     {
         std::cout << "failed to open file:" << path << std::endl;
         exit(1);
     }
-
-    std::stringstream sstream;
-    sstream << file.rdbuf();
-    return sstream.str();
-}
\ No newline at end of file
+    return file.GetSource();
+}